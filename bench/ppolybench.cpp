@@ -0,0 +1,90 @@
+/**
+@file  ppolybench.cpp
+@brief Micro-benchmark of the breakpoint search of PiecewisePolynomial across curve sizes
+*/
+
+#include <qflib/math/interpol/piecewisepolynomial.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace qf;
+
+namespace {
+
+  // number of queries per measurement
+  const size_t NQUERIES = 1 << 20;
+
+  // Returns the average time in nanoseconds per query of f over the queries,
+  // the best of a few repetitions after a warmup run
+  template <typename F>
+  double timeQueries(std::vector<double> const& queries, F f)
+  {
+    const int NREPS = 5;
+    double best = 1.0e300;
+    ptrdiff_t sink = 0;
+    for (int rep = 0; rep <= NREPS; ++rep) {
+      auto start = std::chrono::steady_clock::now();
+      for (double q : queries)
+        sink += f(q);
+      auto stop = std::chrono::steady_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(stop - start).count() / queries.size();
+      if (rep > 0)  // the first run is the warmup
+        best = std::min(best, ns);
+    }
+    // keep the results alive
+    if (sink == 42)
+      std::printf(" ");
+    return best;
+  }
+
+} // anonymous namespace
+
+int main()
+{
+  std::printf("%10s %14s %14s %14s %14s %14s\n", "nbkpts", "upper_bound", "index",
+              "index(hint)", "eval(hint)", "integral");
+
+  std::mt19937 rng(12345);
+  for (size_t n : { 10, 100, 1000, 10000, 100000 }) {
+    // a piecewise linear curve on irregular breakpoints over 30 years
+    Vector x(n), y(n);
+    std::uniform_real_distribution<double> gap(0.5, 1.5);
+    double t = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      x[i] = t;
+      y[i] = 0.02 + 0.001 * std::sin(t);
+      t += gap(rng);
+    }
+    x *= 30.0 / t;
+    PiecewisePolynomial pp(x.begin(), x.end(), y.begin(), 1);
+
+    // random queries, and a monotone stream as produced by time stepping
+    std::uniform_real_distribution<double> unif(0.0, 30.0);
+    std::vector<double> random(NQUERIES), monotone(NQUERIES);
+    for (size_t i = 0; i < NQUERIES; ++i) {
+      random[i] = unif(rng);
+      monotone[i] = 30.0 * i / NQUERIES;
+    }
+
+    double tub = timeQueries(random, [&](double q) {
+      return std::upper_bound(x.begin(), x.end(), q) - x.begin() - 1; });
+    double tidx = timeQueries(random, [&](double q) { return pp.index(q); });
+    ptrdiff_t hint = 0;
+    double thint = timeQueries(monotone, [&](double q) { return hint = pp.index(q, hint); });
+    hint = 0;
+    double teval = timeQueries(monotone, [&](double q) { return (ptrdiff_t) pp.eval(q, 0, hint); });
+    // integral walks the breakpoints, hence fewer queries for the large curves
+    std::vector<double> fewer(random.begin(), random.begin() + std::min(NQUERIES, (NQUERIES << 4) / n));
+    double tint = timeQueries(fewer, [&](double q) { return (ptrdiff_t) pp.integral(0.0, q); });
+
+    std::printf("%10zu %14.2f %14.2f %14.2f %14.2f %14.2f\n", n, tub, tidx, thint, teval, tint);
+    std::fflush(stdout);
+  }
+  std::printf("times in ns per query; index and integral on random points, the hinted calls on a monotone stream\n");
+
+  return 0;
+}
@@ -0,0 +1,553 @@
+/**
+@file  qflibbench.cpp
+@brief Benchmark suite of the library hot paths, with machine-readable output and comparison to a baseline
+
+Usage: qflib_bench [options]
+  --format table|json|csv   output format, table by default
+  --out FILE                writes the results to FILE instead of stdout
+  --filter TEXT             runs only the benchmarks whose name contains TEXT
+  --list                    lists the benchmark names and exits
+  --reps N                  number of measured repetitions, 10 by default
+  --warmup N                number of discarded repetitions, 2 by default
+  --min-time MS             minimum duration of a repetition in milliseconds, 50 by default
+  --compare FILE            compares the medians to the baseline FILE, saved with --format json or csv
+  --tolerance X             relative slowdown flagged as a regression, 0.10 by default
+
+With --compare the exit code is 1 if any benchmark regressed, so that the suite can gate a library upgrade:
+  qflib_bench --format json --out baseline.json     (before)
+  qflib_bench --compare baseline.json               (after)
+*/
+
+#include <qflib/math/random/rng.hpp>
+#include <qflib/math/stats/errorfunction.hpp>
+#include <qflib/math/stats/meanvarcalculator.hpp>
+#include <qflib/math/interpol/piecewisepolynomial.hpp>
+#include <qflib/methods/montecarlo/eulerpathgenerator.hpp>
+#include <qflib/market/yieldcurve.hpp>
+#include <qflib/market/volatilitytermstructure.hpp>
+#include <qflib/pricers/bsmcpricer.hpp>
+#include <qflib/pricers/simplepricers.hpp>
+#include <qflib/products/europeancallput.hpp>
+#include <qflib/sptrmap.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace qf;
+
+namespace {
+
+  /** A benchmark: run(n) performs n operations, e.g. n option prices or n Monte Carlo paths */
+  struct Benchmark
+  {
+    std::string name;       // no commas nor quotes, so that it is written as is in CSV and JSON
+    std::string op;         // what one operation is
+    std::function<void(size_t)> run;
+  };
+
+  /** The statistics of the repetitions of a benchmark, in nanoseconds per operation */
+  struct Result
+  {
+    std::string name;
+    std::string op;
+    size_t nops;            // operations per repetition
+    size_t reps;
+    double min;
+    double median;
+    double mean;
+    double stdev;
+    double opsPerSec;       // from the median
+  };
+
+  /** The run options */
+  struct Options
+  {
+    std::string format = "table";
+    std::string out;
+    std::string filter;
+    std::string compare;
+    bool list = false;
+    size_t reps = 10;
+    size_t warmup = 2;
+    double minTimeMs = 50.0;
+    double tolerance = 0.10;
+  };
+
+  // the benchmark bodies add their results here, so that the compiler cannot drop the work
+  volatile double sink = 0.0;
+
+  // Returns the duration of f(n) in nanoseconds
+  double timeRun(Benchmark const& bm, size_t n)
+  {
+    auto start = std::chrono::steady_clock::now();
+    bm.run(n);
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+  }
+
+  // Runs the benchmark: finds the number of operations filling the minimum time, runs the warmup
+  // repetitions, then the measured ones
+  Result measure(Benchmark const& bm, Options const& opts)
+  {
+    double minNs = opts.minTimeMs * 1.0e6;
+    size_t n = 1;
+    for (;;) {
+      double ns = timeRun(bm, n);
+      if (ns >= minNs)
+        break;
+      // grow towards the minimum time, by at most 10x per step
+      double factor = ns > 0.0 ? std::min(10.0, 1.2 * minNs / ns) : 10.0;
+      n = std::max(n + 1, static_cast<size_t>(n * factor));
+    }
+
+    for (size_t i = 0; i < opts.warmup; ++i)
+      timeRun(bm, n);
+
+    std::vector<double> samples(opts.reps);
+    for (size_t i = 0; i < opts.reps; ++i)
+      samples[i] = timeRun(bm, n) / n;
+
+    Result res;
+    res.name = bm.name;
+    res.op = bm.op;
+    res.nops = n;
+    res.reps = opts.reps;
+    std::sort(samples.begin(), samples.end());
+    res.min = samples.front();
+    size_t m = samples.size() / 2;
+    res.median = samples.size() % 2 ? samples[m] : 0.5 * (samples[m - 1] + samples[m]);
+    double sum = 0.0, sumsq = 0.0;
+    for (double s : samples) {
+      sum += s;
+      sumsq += s * s;
+    }
+    res.mean = sum / samples.size();
+    res.stdev = samples.size() > 1
+      ? std::sqrt(std::max(0.0, (sumsq - sum * res.mean) / (samples.size() - 1))) : 0.0;
+    res.opsPerSec = 1.0e9 / res.median;
+    return res;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // The benchmarks
+
+  // A flat-forward yield curve on yearly pillars, with an upward sloping spot rate
+  SPtrYieldCurve makeYieldCurve(size_t npillars)
+  {
+    Vector tmats(npillars), rates(npillars);
+    for (size_t i = 0; i < npillars; ++i) {
+      tmats[i] = i + 1.0;
+      rates[i] = 0.02 + 0.01 * std::log(1.0 + tmats[i]) / std::log(1.0 + npillars);
+    }
+    return SPtrYieldCurve(new YieldCurve(tmats.begin(), tmats.end(), rates.begin(), rates.end()));
+  }
+
+  template <typename NRNG>
+  Benchmark normalRngBench(std::string const& engine)
+  {
+    // one batch of deviates per call, as drawn by a path generator
+    const size_t DIM = 1024;
+    auto nrng = std::make_shared<NRNG>(DIM);
+    auto buf = std::make_shared<std::vector<double>>(DIM);
+    return { "NormalRng::next/" + engine, "deviate", [nrng, buf](size_t n) {
+      double acc = 0.0;
+      for (size_t done = 0; done < n; done += DIM) {
+        nrng->next(buf->begin(), buf->end());
+        acc += buf->front();
+      }
+      sink = sink + acc;
+    } };
+  }
+
+  Benchmark eulerPathGeneratorBench(size_t ntimesteps)
+  {
+    auto pathgen = std::make_shared<EulerPathGenerator<NormalRngMt19937>>(ntimesteps, 1);
+    auto path = std::make_shared<Matrix>(ntimesteps, 1);
+    return { "EulerPathGenerator::next/steps=" + std::to_string(ntimesteps), "path", [pathgen, path](size_t n) {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; ++i) {
+        pathgen->next(*path);
+        acc += (*path)(0, 0);
+      }
+      sink = sink + acc;
+    } };
+  }
+
+  Benchmark bsMcPricerBench(McParams::UrngType urng, std::string const& engine)
+  {
+    SPtrProduct spprod(new EuropeanCallPut(1, 100.0, 1.0));
+    auto pricer = std::make_shared<BsMcPricer>(spprod, makeYieldCurve(30), 0.01, 0.2, 100.0, McParams(urng));
+    return { "BsMcPricer::simulate/" + engine, "path", [pricer](size_t n) {
+      MeanVarCalculator<double*> sc(pricer->nVariables());
+      pricer->simulate(sc, n);
+      sink = sink + sc.results()(0, 0);
+    } };
+  }
+
+  Benchmark europeanOptionBSBench()
+  {
+    // the strikes vary, so that nothing is hoisted out of the loop
+    const size_t NSTRIKES = 256;
+    auto strikes = std::make_shared<std::vector<double>>(NSTRIKES);
+    for (size_t i = 0; i < NSTRIKES; ++i)
+      (*strikes)[i] = 50.0 + 100.0 * i / NSTRIKES;
+    return { "europeanOptionBS", "option", [strikes](size_t n) {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; ++i)
+        acc += europeanOptionBS(1, 100.0, (*strikes)[i % NSTRIKES], 1.0, 0.03, 0.01, 0.2)[0];
+      sink = sink + acc;
+    } };
+  }
+
+  Benchmark erfcBench()
+  {
+    // arguments over [-6, 6], covering both branches of erfc
+    const size_t NX = 4096;
+    auto xs = std::make_shared<std::vector<double>>(NX);
+    for (size_t i = 0; i < NX; ++i)
+      (*xs)[i] = -6.0 + 12.0 * i / NX;
+    return { "ErrorFunction::erfc", "call", [xs](size_t n) {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; ++i)
+        acc += ErrorFunction::erfc((*xs)[i % NX]);
+      sink = sink + acc;
+    } };
+  }
+
+  Benchmark ppolyIntegralBench(size_t nbkpts)
+  {
+    // a piecewise linear curve on irregular breakpoints over 30 years, as in qflib_ppoly_bench
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> gap(0.5, 1.5);
+    Vector x(nbkpts), y(nbkpts);
+    double t = 0.0;
+    for (size_t i = 0; i < nbkpts; ++i) {
+      x[i] = t;
+      y[i] = 0.02 + 0.001 * std::sin(t);
+      t += gap(rng);
+    }
+    x *= 30.0 / t;
+    auto pp = std::make_shared<PiecewisePolynomial>(x.begin(), x.end(), y.begin(), 1);
+
+    const size_t NQ = 4096;
+    auto queries = std::make_shared<std::vector<double>>(NQ);
+    std::uniform_real_distribution<double> unif(0.0, 30.0);
+    for (double& q : *queries)
+      q = unif(rng);
+    return { "PiecewisePolynomial::integral/n=" + std::to_string(nbkpts), "call", [pp, queries](size_t n) {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; ++i)
+        acc += pp->integral(0.0, (*queries)[i % NQ]);
+      sink = sink + acc;
+    } };
+  }
+
+  Benchmark discountBench()
+  {
+    SPtrYieldCurve spyc = makeYieldCurve(30);
+    const size_t NQ = 4096;
+    auto tmats = std::make_shared<std::vector<double>>(NQ);
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<double> unif(0.0, 30.0);
+    for (double& t : *tmats)
+      t = unif(rng);
+    return { "YieldCurve::discount", "call", [spyc, tmats](size_t n) {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; ++i)
+        acc += spyc->discount((*tmats)[i % NQ]);
+      sink = sink + acc;
+    } };
+  }
+
+  // Lookups in a map of curves by name, in mixed case as they come from Python, and by handle
+  std::vector<Benchmark> sptrMapBenches()
+  {
+    const size_t NCURVES = 100;
+    auto map = std::make_shared<SPtrMap<YieldCurve>>();
+    auto names = std::make_shared<std::vector<std::string>>();
+    auto handles = std::make_shared<std::vector<SPtrMap<YieldCurve>::Handle>>();
+    SPtrYieldCurve spyc = makeYieldCurve(10);
+    for (size_t i = 0; i < NCURVES; ++i) {
+      std::string name = "UsdLibor" + std::to_string(i);
+      handles->push_back(map->set(name, spyc).handle);
+      names->push_back(name);
+    }
+    Benchmark byName = { "SPtrMap::get/name", "lookup", [map, names](size_t n) {
+      size_t found = 0;
+      for (size_t i = 0; i < n; ++i)
+        found += map->get((*names)[i % NCURVES]) ? 1 : 0;
+      sink = sink + found;
+    } };
+    Benchmark byHandle = { "SPtrMap::get/handle", "lookup", [map, handles](size_t n) {
+      size_t found = 0;
+      for (size_t i = 0; i < n; ++i)
+        found += map->get((*handles)[i % NCURVES]) ? 1 : 0;
+      sink = sink + found;
+    } };
+    return { byName, byHandle };
+  }
+
+  std::vector<Benchmark> allBenchmarks()
+  {
+    std::vector<Benchmark> bms;
+    bms.push_back(normalRngBench<NormalRngMinStdRand>("minstd_rand"));
+    bms.push_back(normalRngBench<NormalRngMt19937>("mt19937"));
+    bms.push_back(normalRngBench<NormalRngRanLux3>("ranlux24"));
+    bms.push_back(normalRngBench<NormalRngRanLux4>("ranlux48"));
+    bms.push_back(eulerPathGeneratorBench(1));
+    bms.push_back(eulerPathGeneratorBench(252));
+    bms.push_back(bsMcPricerBench(McParams::UrngType::MT19937, "mt19937"));
+    bms.push_back(bsMcPricerBench(McParams::UrngType::MINSTDRAND, "minstd_rand"));
+    bms.push_back(europeanOptionBSBench());
+    bms.push_back(erfcBench());
+    for (size_t n : { 10, 100, 1000, 10000, 100000 })
+      bms.push_back(ppolyIntegralBench(n));
+    bms.push_back(discountBench());
+    for (Benchmark& bm : sptrMapBenches())
+      bms.push_back(bm);
+    return bms;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Output
+
+  void writeTable(std::ostream& os, std::vector<Result> const& results)
+  {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-40s %12s %12s %12s %10s %14s\n",
+                  "benchmark", "median(ns)", "min(ns)", "mean(ns)", "stdev(%)", "ops/s");
+    os << line;
+    for (Result const& r : results) {
+      std::snprintf(line, sizeof(line), "%-40s %12.2f %12.2f %12.2f %10.2f %14.4g  per %s\n",
+                    r.name.c_str(), r.median, r.min, r.mean, 100.0 * r.stdev / r.mean, r.opsPerSec, r.op.c_str());
+      os << line;
+    }
+  }
+
+  void writeCsv(std::ostream& os, std::vector<Result> const& results)
+  {
+    os << "name,op,nops,reps,min_ns,median_ns,mean_ns,stdev_ns,ops_per_sec\n";
+    os.precision(10);
+    for (Result const& r : results)
+      os << r.name << ',' << r.op << ',' << r.nops << ',' << r.reps << ',' << r.min << ',' << r.median << ','
+         << r.mean << ',' << r.stdev << ',' << r.opsPerSec << '\n';
+  }
+
+  void writeJson(std::ostream& os, std::vector<Result> const& results, Options const& opts)
+  {
+    os.precision(10);
+    os << "{\n  \"suite\": \"qflib_bench\",\n  \"unit\": \"ns/op\",\n"
+       << "  \"reps\": " << opts.reps << ",\n  \"warmup\": " << opts.warmup << ",\n"
+       << "  \"min_time_ms\": " << opts.minTimeMs << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      Result const& r = results[i];
+      os << "    {\"name\": \"" << r.name << "\", \"op\": \"" << r.op << "\", \"nops\": " << r.nops
+         << ", \"reps\": " << r.reps << ", \"min\": " << r.min << ", \"median\": " << r.median
+         << ", \"mean\": " << r.mean << ", \"stdev\": " << r.stdev << ", \"ops_per_sec\": " << r.opsPerSec
+         << (i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    os << "  ]\n}\n";
+  }
+
+  ///////////////////////////////////////////////////////////////////////////////
+  // Comparison to a baseline
+
+  // Reads the medians by name from a file written by qflib_bench with --format json or csv
+  std::map<std::string, double> readBaseline(std::string const& fileName)
+  {
+    std::ifstream is(fileName);
+    if (!is) {
+      std::fprintf(stderr, "qflib_bench: cannot open the baseline %s\n", fileName.c_str());
+      std::exit(2);
+    }
+    std::stringstream ss;
+    ss << is.rdbuf();
+    std::string text = ss.str();
+
+    std::map<std::string, double> medians;
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first != std::string::npos && text[first] == '{') {
+      // one object per benchmark, as written by writeJson
+      std::regex re("\"name\"\\s*:\\s*\"([^\"]*)\"[^}]*\"median\"\\s*:\\s*([-+0-9.eE]+)");
+      for (std::sregex_iterator it(text.begin(), text.end(), re), end; it != end; ++it)
+        medians[(*it)[1].str()] = std::stod((*it)[2].str());
+    }
+    else {
+      // the header gives the columns
+      std::istringstream lines(text);
+      std::string line;
+      std::vector<std::string> header;
+      while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r')
+          line.pop_back();
+        std::vector<std::string> fields;
+        std::istringstream fs(line);
+        for (std::string f; std::getline(fs, f, ',');)
+          fields.push_back(f);
+        if (header.empty()) {
+          header = fields;
+          continue;
+        }
+        size_t iname = std::find(header.begin(), header.end(), "name") - header.begin();
+        size_t imed = std::find(header.begin(), header.end(), "median_ns") - header.begin();
+        if (iname < fields.size() && imed < fields.size())
+          medians[fields[iname]] = std::stod(fields[imed]);
+      }
+    }
+    if (medians.empty()) {
+      std::fprintf(stderr, "qflib_bench: no results in the baseline %s\n", fileName.c_str());
+      std::exit(2);
+    }
+    return medians;
+  }
+
+  // Prints the change of each median against the baseline, for the benchmarks selected by the filter;
+  // returns the number of regressions
+  size_t compare(std::vector<Result> const& results, std::map<std::string, double> const& baseline,
+                 double tolerance, std::string const& filter)
+  {
+    std::printf("%-40s %12s %12s %9s  %s\n", "benchmark", "base(ns)", "now(ns)", "change", "status");
+    size_t nregressions = 0;
+    for (Result const& r : results) {
+      auto it = baseline.find(r.name);
+      if (it == baseline.end()) {
+        std::printf("%-40s %12s %12.2f %9s  new\n", r.name.c_str(), "-", r.median, "-");
+        continue;
+      }
+      double change = r.median / it->second - 1.0;
+      char const* status = "ok";
+      if (change > tolerance) {
+        status = "REGRESSION";
+        ++nregressions;
+      }
+      else if (change < -tolerance)
+        status = "improved";
+      std::printf("%-40s %12.2f %12.2f %+8.1f%%  %s\n", r.name.c_str(), it->second, r.median, 100.0 * change, status);
+    }
+    for (auto const& b : baseline) {
+      if (!filter.empty() && b.first.find(filter) == std::string::npos)
+        continue;
+      bool found = std::any_of(results.begin(), results.end(), [&](Result const& r) { return r.name == b.first; });
+      if (!found)
+        std::printf("%-40s %12.2f %12s %9s  missing\n", b.first.c_str(), b.second, "-", "-");
+    }
+    std::printf("%zu regression(s) beyond %.0f%%\n", nregressions, 100.0 * tolerance);
+    return nregressions;
+  }
+
+  void usage()
+  {
+    std::fprintf(stderr,
+      "usage: qflib_bench [--format table|json|csv] [--out FILE] [--filter TEXT] [--list]\n"
+      "                   [--reps N] [--warmup N] [--min-time MS] [--compare FILE] [--tolerance X]\n");
+    std::exit(2);
+  }
+
+  Options parseOptions(int argc, char* argv[])
+  {
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--list") {
+        opts.list = true;
+        continue;
+      }
+      if (i + 1 >= argc)
+        usage();
+      std::string val = argv[++i];
+      if (arg == "--format")
+        opts.format = val;
+      else if (arg == "--out")
+        opts.out = val;
+      else if (arg == "--filter")
+        opts.filter = val;
+      else if (arg == "--compare")
+        opts.compare = val;
+      else if (arg == "--reps")
+        opts.reps = std::stoul(val);
+      else if (arg == "--warmup")
+        opts.warmup = std::stoul(val);
+      else if (arg == "--min-time")
+        opts.minTimeMs = std::stod(val);
+      else if (arg == "--tolerance")
+        opts.tolerance = std::stod(val);
+      else
+        usage();
+    }
+    if ((opts.format != "table" && opts.format != "json" && opts.format != "csv") || opts.reps == 0)
+      usage();
+    return opts;
+  }
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  Options opts;
+  try {
+    opts = parseOptions(argc, argv);
+  }
+  catch (std::exception const&) {
+    usage();
+  }
+
+  std::map<std::string, double> baseline;
+  if (!opts.compare.empty())
+    baseline = readBaseline(opts.compare);
+
+  std::vector<Result> results;
+  try {
+    for (Benchmark const& bm : allBenchmarks()) {
+      if (!opts.filter.empty() && bm.name.find(opts.filter) == std::string::npos)
+        continue;
+      if (opts.list) {
+        std::printf("%s\n", bm.name.c_str());
+        continue;
+      }
+      std::fprintf(stderr, "running %s\n", bm.name.c_str());
+      results.push_back(measure(bm, opts));
+    }
+  }
+  catch (std::exception const& e) {
+    std::fprintf(stderr, "qflib_bench: %s\n", e.what());
+    return 2;
+  }
+  if (opts.list)
+    return 0;
+
+  // with --compare, the results are written only to a file
+  bool write = opts.compare.empty() || !opts.out.empty();
+  std::ofstream file;
+  if (!opts.out.empty()) {
+    file.open(opts.out);
+    if (!file) {
+      std::fprintf(stderr, "qflib_bench: cannot write to %s\n", opts.out.c_str());
+      return 2;
+    }
+  }
+  std::ostream& os = opts.out.empty() ? std::cout : file;
+  if (write && opts.format == "json")
+    writeJson(os, results, opts);
+  else if (write && opts.format == "csv")
+    writeCsv(os, results);
+  else if (write)
+    writeTable(os, results);
+  os.flush();
+
+  if (!opts.compare.empty())
+    return compare(results, baseline, opts.tolerance, opts.filter) > 0 ? 1 : 0;
+  return 0;
+}
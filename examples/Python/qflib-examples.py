@@ -109,6 +109,15 @@ spotrate = qf.spotRate(ycname = yc, tmat = 2)
 fwdrate = qf.fwdRate(ycname = yc, tmat1 = 1, tmat2 = 2)
 print(f'DF={df:.4f}, SpotRate={spotrate:.4f} FwdRate={fwdrate:.4f}')
 
+#smooth forward curves through the same spot rates
+for interp in ['FLATFWD', 'MONOTONECONVEX', 'HERMITE']:
+    ycs = qf.ycCreate(ycname = 'USD-' + interp,
+                      tmats =  [1/12,  1/4,  1/2,   3/4,    1,     2,    3,     4,    5,      10],
+                      vals = [0.01,   0.02, 0.03, 0.035, 0.04, 0.045, 0.05, 0.055, 0.0575, 0.065],
+                      valtype = 0, interp = interp)
+    fwds = [qf.fwdRate(ycname = ycs, tmat1 = t, tmat2 = t + 1/365) for t in [0.9, 1.0, 1.1]]
+    print(f'{interp}: SpotRate(2)={qf.spotRate(ycname = ycs, tmat = 2):.4f} overnight fwd rates around 1Y={fwds}')
+
 print('Market list')
 print(qf.mktList())
 
@@ -125,3 +134,83 @@ euromc0 = qf.euroBSMC(payofftype = 1, strike = 100, timetoexp = 1.0, spot = 100,
                        mcparams = mcpars0, npaths = npaths0)
 print(f'URNGTYPE={mcpars0["URNGTYPE"]} PATHGENTYPE={mcpars0["PATHGENTYPE"]} NPATHS={npaths0}')
 print(f'Price={euromc0['Mean']:0.4f}  StdErr={euromc0['StdErr']:0.4f}')
+
+
+#%%
+# function group 4
+print('=================')
+print('European options on a strip of strikes using Fourier methods')
+
+#eurofourier
+strikes = np.arange(60, 145, 5)
+bscos = qf.euroFourier(payofftype = 1, spot = 100, strikes = strikes, timetoexp = 1.0,
+                       discountcrv = yc, divyield = 0.02, model = 0.4, method = 'COS')
+bsfft = qf.euroFourier(payofftype = 1, spot = 100, strikes = strikes, timetoexp = 1.0,
+                       discountcrv = yc, divyield = 0.02, model = 0.4, method = 'FFT')
+hestonpars = {'V0': 0.04, 'KAPPA': 1.5, 'THETA': 0.04, 'SIGMA': 0.5, 'RHO': -0.7}
+hescos = qf.euroFourier(payofftype = 1, spot = 100, strikes = strikes, timetoexp = 1.0,
+                        discountcrv = yc, divyield = 0.02, model = hestonpars, method = 'COS')
+print(f'Strikes={strikes}')
+print(f'BS COS={bscos}')
+print(f'BS FFT={bsfft}')
+print(f'Heston COS={hescos}')
+
+#%%
+print('=================')
+print('Vanilla and barrier options using finite differences')
+
+#optionbspde
+pdeparams = {'NSPACENODES': 401, 'NTIMESTEPS': 200}
+euro = qf.optionBSPDE(payofftype = -1, exercisetype = 'EUROPEAN', strike = 100, timetoexp = 1.0, spot = 100,
+                      discountcrv = yc, divyield = 0.02, volatility = 0.4,
+                      lowerbarrier = 0, upperbarrier = 0, pdeparams = pdeparams)
+amer = qf.optionBSPDE(payofftype = -1, exercisetype = 'AMERICAN', strike = 100, timetoexp = 1.0, spot = 100,
+                      discountcrv = yc, divyield = 0.02, volatility = 0.4,
+                      lowerbarrier = 0, upperbarrier = 0, pdeparams = pdeparams)
+dao = qf.optionBSPDE(payofftype = 1, exercisetype = 'EUROPEAN', strike = 100, timetoexp = 1.0, spot = 100,
+                     discountcrv = yc, divyield = 0.02, volatility = 0.4,
+                     lowerbarrier = 80, upperbarrier = 0, pdeparams = pdeparams)
+print(f'European put [price, delta, gamma, theta]={euro}')
+print(f'American put [price, delta, gamma, theta]={amer}')
+print(f'Down-and-out call [price, delta, gamma, theta]={dao}')
+
+#%%
+print('=================')
+print('American and Bermudan options using recombining trees')
+
+#optionbslattice
+latticeparams = {'TREETYPE': 'LEISENREIMER', 'NSTEPS': 201}
+amer = qf.optionBSLattice(payofftype = -1, exercisetype = 'AMERICAN', strike = 100, timetoexp = 1.0, exertimes = [],
+                          spot = 100, discountcrv = yc, divyield = 0.02, volatility = 0.4, latticeparams = latticeparams)
+berm = qf.optionBSLattice(payofftype = -1, exercisetype = 'BERMUDAN', strike = 100, timetoexp = 1.0,
+                          exertimes = [0.25, 0.5, 0.75], spot = 100, discountcrv = yc, divyield = 0.02,
+                          volatility = 0.4, latticeparams = latticeparams)
+print(f'American put [price, delta, gamma, theta]={amer}')
+print(f'Bermudan put [price, delta, gamma, theta]={berm}')
+
+#%%
+print('=================')
+print('Yield curve bootstrapping from deposits, FRAs and swaps')
+
+#ycbootstrap, swaprate
+insttypes = ['DEPOSIT', 'DEPOSIT', 'FRA', 'SWAP', 'SWAP', 'SWAP', 'SWAP']
+tstarts = [0, 0, 0.5, 0, 0, 0, 0]
+tmats = [0.25, 0.5, 1.0, 2, 5, 10, 30]
+rates = [0.030, 0.031, 0.032, 0.033, 0.035, 0.037, 0.038]
+freqs = [0, 0, 0, 2, 2, 2, 2]
+bootyc = qf.ycBootstrap('BOOTSTRAPPED', insttypes, tstarts, tmats, rates, freqs)
+print(f'bootstrapped curve: {bootyc}')
+for tmat in [2, 5, 10, 30]:
+    print(f'{tmat}Y par swap rate: {qf.swapRate(bootyc, 0, tmat, 2):.6f}')
+print(f'5Yx5Y forward swap rate: {qf.swapRate(bootyc, 5, 10, 2):.6f}')
+
+# long dated swaps at high rates, with a stub after the 30Y node; the bootstrapped curve reprices them all
+for rate, freq in [(0.03, 4), (0.09, 1), (0.09, 2), (0.25, 1)]:
+    tmats = [0.25, 0.5, 1.0] + list(range(2, 31)) + [30 + 1 / 52, 40, 50]
+    ninst = len(tmats)
+    insttypes = ['DEPOSIT', 'DEPOSIT', 'FRA'] + ['SWAP'] * (ninst - 3)
+    tstarts = [0, 0, 0.5] + [0] * (ninst - 3)
+    freqs = [0, 0, 0] + [freq] * (ninst - 3)
+    bootyc = qf.ycBootstrap('BOOTSTRAPPED', insttypes, tstarts, tmats, [rate] * ninst, freqs)
+    maxerr = max(abs(qf.swapRate(bootyc, 0, tmat, freq) - rate) for tmat in tmats[3:])
+    print(f'{rate:.2f} swaps paying {freq}/year to 50Y: max repricing error {maxerr:.1e}')
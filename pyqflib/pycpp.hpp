@@ -38,6 +38,22 @@ if (!(condition)) { \
             return nullptr; \
     }
 
+/** Releases the GIL for its lifetime, so that other Python threads run during long C++ computations.
+    No Python API may be called while it is alive; the GIL is taken back also when an exception is thrown.
+*/
+class GilRelease
+{
+public:
+  GilRelease() : save_(PyEval_SaveThread()) {}
+  ~GilRelease() { PyEval_RestoreThread(save_); }
+
+  GilRelease(GilRelease const&) = delete;
+  GilRelease& operator=(GilRelease const&) = delete;
+
+private:
+  PyThreadState* save_;
+};
+
 static bool isNone(PyObject* p)
 {
   return p == Py_None;
@@ -268,6 +284,59 @@ static std::vector<std::vector<double>> asDblVecVec(PyObject* pobj)
     }
 }
 
+/** Returns a new reference to a float64 numpy array with ndim dimensions, aligned and contiguous
+    in C order, or in Fortran order if fortranOrder is true.
+    An array already laid out so is returned as is, without copying; other inputs, e.g. strided
+    or differently ordered arrays, other dtypes or lists, are converted once by numpy.
+*/
+static PyArrayObject* asDblArray(PyObject* pobj, int ndim, bool fortranOrder)
+{
+    PyObject* arr = PyArray_FROM_OTF(pobj, NPY_DOUBLE, fortranOrder ? NPY_ARRAY_IN_FARRAY : NPY_ARRAY_IN_ARRAY);
+    CASSERT(arr != nullptr, "asDblArray: input object not convertible to a float64 array");
+    if (PyArray_NDIM((PyArrayObject*) arr) != ndim) {
+        Py_DECREF(arr);
+        throw std::runtime_error("asDblArray: input object is not " + std::to_string(ndim) + " dimensional");
+    }
+    return (PyArrayObject*) arr;
+}
+
+/** Returns a capsule owning the heap object p, which is deleted when the capsule is collected */
+template <typename T>
+static PyObject* asPyCapsule(T* p)
+{
+    PyObject* cap = PyCapsule_New(p, nullptr, [](PyObject* c) { delete (T*) PyCapsule_GetPointer(c, nullptr); });
+    if (cap == nullptr) {
+        delete p;
+        throw std::runtime_error("asPyCapsule: cannot create the capsule");
+    }
+    return cap;
+}
+
+/** Returns a numpy array of doubles over memory owned by another Python object, e.g. a capsule.
+    The data is in C order, or in Fortran order if fortranOrder is true. The reference to owner is stolen:
+    the array keeps the owner alive and releases it when it is collected.
+*/
+static PyObject* asPyArray(double* data, int ndim, npy_intp* dims, bool fortranOrder, PyObject* owner)
+{
+    if (data == nullptr) {
+        // empty arrays may have no memory at all
+        Py_DECREF(owner);
+        return PyArray_ZEROS(ndim, dims, NPY_DOUBLE, fortranOrder ? 1 : 0);
+    }
+    PyObject* arr = PyArray_New(&PyArray_Type, ndim, dims, NPY_DOUBLE, nullptr, data, 0,
+                                fortranOrder ? NPY_ARRAY_FARRAY : NPY_ARRAY_CARRAY, nullptr);
+    if (arr == nullptr) {
+        Py_DECREF(owner);
+        throw std::runtime_error("asPyArray: cannot create the array");
+    }
+    // the owner reference is stolen even on failure
+    if (PyArray_SetBaseObject((PyArrayObject*) arr, owner) != 0) {
+        Py_DECREF(arr);
+        throw std::runtime_error("asPyArray: cannot set the owner of the array");
+    }
+    return arr;
+}
+
 static PyObject* asPyList(std::vector<std::vector<double>> const& dvecvec)
 {
     size_t nrow = dvecvec.size();
@@ -171,7 +171,7 @@ PY_BEGIN;
     return NULL;
 
   qf::Matrix mat = asMatrix(pyMat);
-  return asNumpy(mat);
+  return asNumpy(std::move(mat));
 PY_END;
 }
 
@@ -190,17 +190,17 @@ PY_BEGIN;
   qf::Vector bkpts = asVector(pyBkPoints);
   qf::Vector vals = asVector(pyValues);
   int degree = asInt(pyPolyOrder);
-  qf::Vector xx = asVector(pyXVec);
+  NumpyView<qf::Vector> xx(pyXVec);
   QF_ASSERT(bkpts.size() == vals.size(), "unequal number of breakpoints and vals");
   int derivOrder = asInt(pyDerivOrder);
 
   // create the curve
   qf::PiecewisePolynomial pp(bkpts.begin(), bkpts.end(), vals.begin(), degree);
 
-  qf::Vector yy(xx.size());
-  pp.eval(xx.begin(), xx.end(), yy.begin(), derivOrder);
+  qf::Vector yy(xx().size());
+  pp.eval(xx().begin(), xx().end(), yy.begin(), derivOrder);
 
-  return asNumpy(yy);
+  return asNumpy(std::move(yy));
 PY_END;
 }
 
@@ -221,14 +221,14 @@ PY_BEGIN;
   QF_ASSERT(bkpts.size() == vals.size(), "unequal number of breakpoints and vals");
   int degree = asInt(pyPolyOrder);
   double x0 = asDouble(pyXStart);
-  qf::Vector xx = asVector(pyXVecEnd);
+  NumpyView<qf::Vector> xx(pyXVecEnd);
   // create the curve
   qf::PiecewisePolynomial pp(bkpts.begin(), bkpts.end(), vals.begin(), degree);
   // integrate
-  qf::Vector yy(xx.size());
-  pp.integral(x0, xx.begin(), xx.end(), yy.begin());
+  qf::Vector yy(xx().size());
+  pp.integral(x0, xx().begin(), xx().end(), yy.begin());
 
-  return asNumpy(yy);
+  return asNumpy(std::move(yy));
 PY_END;
 }
 
@@ -266,7 +266,7 @@ PY_BEGIN;
   qf::Matrix ret(bkpts.size(), 2);
   ret.col(0) = bkpts;
   ret.col(1) = vals;
-  return asNumpy(ret);
+  return asNumpy(std::move(ret));
 PY_END;
 }
 
@@ -296,7 +296,7 @@ PY_BEGIN;
     bkts(i, 0) = xb1[i];
     bkts(i, 1) = xb2[i];
   };
-  return asNumpy(bkts);
+  return asNumpy(std::move(bkts));
 PY_END;
 }
 
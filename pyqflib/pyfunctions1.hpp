@@ -5,6 +5,7 @@
 #include <pyqflib/pyutils.hpp>
 #include <qflib/defines.hpp>
 #include <qflib/pricers/simplepricers.hpp>
+#include <qflib/pricers/batchpricers.hpp>
 #include <string>
 
 static
@@ -79,6 +80,21 @@ PY_BEGIN;
     &pyTimeToExp, &pyIntRate, &pyDivYield, &pyVolatility))
     return NULL;
 
+  // arrays of options are broadcast against each other and priced by the batch kernel without the GIL;
+  // the results have the price and Greeks first, then the broadcast shape
+  if (hasArrays({ pyPayoffType, pySpot, pyStrike, pyTimeToExp, pyIntRate, pyDivYield, pyVolatility })) {
+    Broadcast bc({ pyPayoffType, pySpot, pyStrike, pyTimeToExp, pyIntRate, pyDivYield, pyVolatility });
+    std::vector<int> payoffTypes = bc.asInts(0);
+    qf::Matrix greeks(bc.size(), 5);
+    {
+      GilRelease nogil;
+      qf::digitalOptionBSBatch(bc.size(), payoffTypes.data(), bc[1].memptr(), bc[2].memptr(), bc[3].memptr(),
+                               bc[4].memptr(), bc[5].memptr(), bc[6].memptr(),
+                               greeks.colptr(0), greeks.colptr(1), greeks.colptr(2), greeks.colptr(3), greeks.colptr(4));
+    }
+    return bc.asNumpy(std::move(greeks));
+  }
+
   int payoffType = asInt(pyPayoffType);
   double spot = asDouble(pySpot);
   double strike = asDouble(pyStrike);
@@ -89,7 +105,7 @@ PY_BEGIN;
 
   qf::Vector greeks = qf::digitalOptionBS(payoffType, spot, strike, timeToExp, intRate, divYield, vol);
 
-  return asNumpy(greeks);
+  return asNumpy(std::move(greeks));
 PY_END;
 }
 
@@ -110,6 +126,20 @@ PY_BEGIN;
     &pyTimeToExp, &pyIntRate, &pyDivYield, &pyVolatility))
     return NULL;
 
+  // arrays of options are broadcast against each other and priced by the batch kernel without the GIL;
+  // the results have the price and Greeks first, then the broadcast shape
+  if (hasArrays({ pyPayoffType, pySpot, pyStrike, pyTimeToExp, pyIntRate, pyDivYield, pyVolatility })) {
+    Broadcast bc({ pyPayoffType, pySpot, pyStrike, pyTimeToExp, pyIntRate, pyDivYield, pyVolatility });
+    std::vector<int> payoffTypes = bc.asInts(0);
+    qf::Matrix greeks(bc.size(), 5);
+    {
+      GilRelease nogil;
+      qf::europeanOptionBSBatch(bc.size(), payoffTypes.data(), bc[1].memptr(), bc[2].memptr(), bc[3].memptr(),
+                                bc[4].memptr(), bc[5].memptr(), bc[6].memptr(),
+                                greeks.colptr(0), greeks.colptr(1), greeks.colptr(2), greeks.colptr(3), greeks.colptr(4));
+    }
+    return bc.asNumpy(std::move(greeks));
+  }
 
   int payoffType = asInt(pyPayoffType);
   double spot = asDouble(pySpot);
@@ -122,7 +152,7 @@ PY_BEGIN;
   qf::Vector greeks = qf::europeanOptionBS(payoffType, spot, strike, timeToExp,
     intRate, divYield, vol);
 
-  return asNumpy(greeks);
+  return asNumpy(std::move(greeks));
 PY_END;
 }
 
@@ -6,6 +6,8 @@
 
 #include <qflib/defines.hpp>
 #include <qflib/market/market.hpp>
+#include <qflib/market/marketfile.hpp>
+#include <qflib/market/yieldcurvebootstrap.hpp>
 
 static
 PyObject*  pyQfMktList(PyObject* pyDummy, PyObject* pyArgs)
@@ -14,11 +16,13 @@ PY_BEGIN;
 
   std::vector<std::string> ycnames = qf::market().yieldCurves().list();
   std::vector<std::string> volnames = qf::market().volatilities().list();
+  std::vector<std::string> mcnames = qf::market().mcSessions().list();
 
   // return market contents as a Python dictionary
   PyObject* ret = PyDict_New();
   int ok = PyDict_SetItem(ret, asPyScalar("YieldCurves"), asPyList(ycnames));
   PyDict_SetItem(ret, asPyScalar("Volatilities"), asPyList(volnames));
+  PyDict_SetItem(ret, asPyScalar("McSessions"), asPyList(mcnames));
   return ret;
 PY_END;
 }
@@ -33,6 +37,75 @@ PY_BEGIN;
 PY_END;
 }
 
+static
+PyObject*  pyQfMktSave(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyFileName(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O", &pyFileName))
+    return NULL;
+
+  std::string fileName = asString(pyFileName);
+  {
+    GilRelease nogil;
+    qf::MarketFile::save(fileName);
+  }
+  return asPyScalar(true);
+PY_END;
+}
+
+static
+PyObject*  pyQfMktLoad(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyFileName(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O", &pyFileName))
+    return NULL;
+
+  std::string fileName = asString(pyFileName);
+  size_t nobjects;
+  {
+    GilRelease nogil;
+    nobjects = qf::MarketFile::load(fileName);
+  }
+  return asPyScalar(long(nobjects));
+PY_END;
+}
+
+static
+PyObject*  pyQfCacheStats(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  qf::ValuationCache::Stats stats = qf::market().valuations().stats();
+
+  // return the counters as a Python dictionary
+  PyObject* ret = PyDict_New();
+  PyDict_SetItem(ret, asPyScalar("Hits"), asPyScalar(long(stats.hits)));
+  PyDict_SetItem(ret, asPyScalar("Misses"), asPyScalar(long(stats.misses)));
+  PyDict_SetItem(ret, asPyScalar("Stale"), asPyScalar(long(stats.stale)));
+  PyDict_SetItem(ret, asPyScalar("Invalidations"), asPyScalar(long(stats.invalidations)));
+  PyDict_SetItem(ret, asPyScalar("InvalidatedEntries"), asPyScalar(long(stats.invalidatedEntries)));
+  PyDict_SetItem(ret, asPyScalar("MaxFanout"), asPyScalar(long(stats.maxFanout)));
+  PyDict_SetItem(ret, asPyScalar("Evictions"), asPyScalar(long(stats.evictions)));
+  PyDict_SetItem(ret, asPyScalar("Entries"), asPyScalar(long(stats.entries)));
+  PyDict_SetItem(ret, asPyScalar("HitRate"), asPyScalar(stats.hitRate()));
+  return ret;
+PY_END;
+}
+
+static
+PyObject*  pyQfCacheClear(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  qf::market().valuations().clear();
+  return asPyScalar(true);
+PY_END;
+}
+
 static
 PyObject*  pyQfYCCreate(PyObject* pyDummy, PyObject* pyArgs)
 {
@@ -42,7 +115,8 @@ PY_BEGIN;
   PyObject* pyTMats(NULL);
   PyObject* pyVals(NULL);
   PyObject* pyValType(NULL);
-  if (!PyArg_ParseTuple(pyArgs, "OOOO", &pyYCName, &pyTMats, &pyVals, &pyValType))
+  PyObject* pyInterp(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "OOOO|O", &pyYCName, &pyTMats, &pyVals, &pyValType, &pyInterp))
     return NULL;
 
   std::string name = asString(pyYCName);
@@ -65,9 +139,21 @@ PY_BEGIN;
     QF_ASSERT(0, "error: unknown yield curve input type");
   }
 
+  qf::YieldCurve::InterpType interp = qf::YieldCurve::InterpType::FLATFWD;
+  if (pyInterp != NULL) {
+    std::string interpname = trim(asString(pyInterp));
+    std::transform(interpname.begin(), interpname.end(), interpname.begin(), ::toupper);
+    if (interpname == "MONOTONECONVEX")
+      interp = qf::YieldCurve::InterpType::MONOTONECONVEX;
+    else if (interpname == "HERMITE")
+      interp = qf::YieldCurve::InterpType::HERMITE;
+    else
+      QF_ASSERT(interpname == "FLATFWD", "error: unknown yield curve interpolation " + interpname);
+  }
+
   std::pair<std::string, unsigned long> pr =
     qf::market().yieldCurves().set(name,
-      std::make_shared<qf::YieldCurve>(tmats.begin(), tmats.end(), vals.begin(), vals.end(), intype)
+      std::make_shared<qf::YieldCurve>(tmats.begin(), tmats.end(), vals.begin(), vals.end(), intype, interp)
     );
 
   std::string tag = pr.first;
@@ -86,11 +172,22 @@ PY_BEGIN;
     return NULL;
 
   std::string name = asString(pyCrvName);
-  double tmat = asDouble(pyMat);
-
   qf::SPtrYieldCurve spyc = qf::market().yieldCurves().get(name);
   QF_ASSERT(spyc, "error: yield curve " + name + " not found");
 
+  // arrays of maturities are evaluated in one call, without the GIL; sorted ones in a single sweep of the curve
+  if (hasArrays({ pyMat }))
+    return broadcastSweep({ pyMat },
+      [&](Broadcast const& bc, qf::Vector& res) {
+        if (!isSorted(bc[0]))
+          return false;
+        spyc->discount(bc[0].begin(), bc[0].end(), res.begin());
+        return true;
+      },
+      [&](Broadcast const& bc, size_t i) { return spyc->discount(bc[0][i]); });
+
+  double tmat = asDouble(pyMat);
+
   double df = spyc->discount(tmat);
   return asPyScalar(df);
 PY_END;
@@ -109,12 +206,30 @@ PY_BEGIN;
     return NULL;
 
   std::string name = asString(pyCrvName);
-  double T1 = asDouble(pyMat1);
-  double T2 = asDouble(pyMat2);
-
   qf::SPtrYieldCurve spyc = qf::market().yieldCurves().get(name);
   QF_ASSERT(spyc, "error: yield curve " + name + " not found");
 
+  // arrays of maturities are broadcast against each other and evaluated in one call, without the GIL;
+  // sorted ones as the ratios of the discount factors from two sweeps of the curve
+  if (hasArrays({ pyMat1, pyMat2 }))
+    return broadcastSweep({ pyMat1, pyMat2 },
+      [&](Broadcast const& bc, qf::Vector& res) {
+        if (!isSorted(bc[0]) || !isSorted(bc[1]))
+          return false;
+        for (size_t i = 0; i < bc.size(); ++i)
+          QF_ASSERT(bc[0][i] <= bc[1][i], "YieldCurve: maturities are out of order");
+        qf::Vector df1(bc.size());
+        spyc->discount(bc[0].begin(), bc[0].end(), df1.begin());
+        spyc->discount(bc[1].begin(), bc[1].end(), res.begin());
+        for (size_t i = 0; i < bc.size(); ++i)
+          res[i] /= df1[i];
+        return true;
+      },
+      [&](Broadcast const& bc, size_t i) { return spyc->fwdDiscount(bc[0][i], bc[1][i]); });
+
+  double T1 = asDouble(pyMat1);
+  double T2 = asDouble(pyMat2);
+
   double fdf = spyc->fwdDiscount(T1, T2);
   return asPyScalar(fdf);
 PY_END;
@@ -131,11 +246,22 @@ PY_BEGIN;
     return NULL;
 
   std::string name = asString(pyCrvName);
-  double tmat = asDouble(pyMat);
-
   qf::SPtrYieldCurve spyc = qf::market().yieldCurves().get(name);
   QF_ASSERT(spyc, "error: yield curve " + name + " not found");
 
+  // arrays of maturities are evaluated in one call, without the GIL; sorted ones in a single sweep of the curve
+  if (hasArrays({ pyMat }))
+    return broadcastSweep({ pyMat },
+      [&](Broadcast const& bc, qf::Vector& res) {
+        if (!isSorted(bc[0]))
+          return false;
+        spyc->spotRate(bc[0].begin(), bc[0].end(), res.begin());
+        return true;
+      },
+      [&](Broadcast const& bc, size_t i) { return spyc->spotRate(bc[0][i]); });
+
+  double tmat = asDouble(pyMat);
+
   double srate = spyc->spotRate(tmat);
   return asPyScalar(srate);
 PY_END;
@@ -153,15 +279,108 @@ PY_BEGIN;
   if (!PyArg_ParseTuple(pyArgs, "OOO", &pyCrvName, &pyMat1, &pyMat2))
     return NULL;
 
+  std::string name = asString(pyCrvName);
+  qf::SPtrYieldCurve spyc = qf::market().yieldCurves().get(name);
+  QF_ASSERT(spyc, "error: yield curve " + name + " not found");
+
+  // arrays of maturities are broadcast against each other and evaluated in one call, without the GIL;
+  // the periods of a schedule in a single sweep of the curve
+  if (hasArrays({ pyMat1, pyMat2 }))
+    return broadcastSweep({ pyMat1, pyMat2 },
+      [&](Broadcast const& bc, qf::Vector& res) {
+        if (!isChained(bc[0], bc[1]))
+          return false;
+        spyc->fwdRate(bc[0][0], bc[1].begin(), bc[1].end(), res.begin());
+        return true;
+      },
+      [&](Broadcast const& bc, size_t i) { return spyc->fwdRate(bc[0][i], bc[1][i]); });
+
+  double T1 = asDouble(pyMat1);
+  double T2 = asDouble(pyMat2);
+
+  double frate = spyc->fwdRate(T1, T2);
+  return asPyScalar(frate);
+PY_END;
+}
+
+static
+PyObject*  pyQfYCBootstrap(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyYCName(NULL);
+  PyObject* pyTypes(NULL);
+  PyObject* pyTStarts(NULL);
+  PyObject* pyTMats(NULL);
+  PyObject* pyRates(NULL);
+  PyObject* pyFreqs(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "OOOOOO", &pyYCName, &pyTypes, &pyTStarts, &pyTMats, &pyRates, &pyFreqs))
+    return NULL;
+
+  std::string name = asString(pyYCName);
+  std::vector<std::string> types = asStrVec(pyTypes);
+  qf::Vector tstarts = asVector(pyTStarts);
+  qf::Vector tmats = asVector(pyTMats);
+  qf::Vector rates = asVector(pyRates);
+  std::vector<long> freqs = asLongVec(pyFreqs);
+  size_t ninst = types.size();
+  QF_ASSERT(tstarts.n_elem == ninst && tmats.n_elem == ninst && rates.n_elem == ninst && freqs.size() == ninst,
+    "error: the instrument inputs must all have the same length");
+
+  std::vector<qf::RateInstrument> insts(ninst);
+  for (size_t i = 0; i < ninst; ++i) {
+    // numpy pads the shorter strings of the array with nulls
+    std::string type = trim(types[i].c_str());
+    std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+    if (type == "DEPOSIT")
+      insts[i].type = qf::RateInstrument::Type::DEPOSIT;
+    else if (type == "FRA")
+      insts[i].type = qf::RateInstrument::Type::FRA;
+    else if (type == "SWAP")
+      insts[i].type = qf::RateInstrument::Type::SWAP;
+    else
+      QF_ASSERT(0, "error: unknown instrument type " + type);
+    insts[i].tStart = tstarts[i];
+    insts[i].tMat = tmats[i];
+    insts[i].rate = rates[i];
+    if (insts[i].type == qf::RateInstrument::Type::SWAP)
+      insts[i].freq = asSwapFreq(freqs[i]);
+  }
+
+  std::pair<std::string, unsigned long> pr;
+  {
+    GilRelease nogil;
+    pr = qf::market().yieldCurves().set(name, qf::bootstrapYieldCurve(insts));
+  }
+
+  std::string tag = pr.first;
+  return asPyScalar(tag);
+PY_END;
+}
+
+static
+PyObject*  pyQfSwapRate(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyCrvName(NULL);
+  PyObject* pyMat1(NULL);
+  PyObject* pyMat2(NULL);
+  PyObject* pyFreq(NULL);
+
+  if (!PyArg_ParseTuple(pyArgs, "OOOO", &pyCrvName, &pyMat1, &pyMat2, &pyFreq))
+    return NULL;
+
   std::string name = asString(pyCrvName);
   double T1 = asDouble(pyMat1);
   double T2 = asDouble(pyMat2);
+  qf::YieldCurve::SwapFreq freq = asSwapFreq(asInt(pyFreq));
 
   qf::SPtrYieldCurve spyc = qf::market().yieldCurves().get(name);
   QF_ASSERT(spyc, "error: yield curve " + name + " not found");
 
-  double frate = spyc->fwdRate(T1, T2);
-  return asPyScalar(frate);
+  double srate = spyc->fwdSwapRate(T1, T2, freq);
+  return asPyScalar(srate);
 PY_END;
 }
 
@@ -174,7 +393,8 @@ PY_BEGIN;
   PyObject* pyTMats(NULL);
   PyObject* pyVals(NULL);
   PyObject* pyValType(NULL);
-  if (!PyArg_ParseTuple(pyArgs, "OOOO", &pyVolName, &pyTMats, &pyVals, &pyValType))
+  PyObject* pyInterp(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "OOOO|O", &pyVolName, &pyTMats, &pyVals, &pyValType, &pyInterp))
     return NULL;
 
   std::string name = asString(pyVolName);
@@ -194,9 +414,22 @@ PY_BEGIN;
     QF_ASSERT(0, "error: unknown volatility input type");
   }
 
+  qf::VolatilityTermStructure::InterpType interp = qf::VolatilityTermStructure::InterpType::FLATFWD;
+  if (pyInterp != NULL) {
+    std::string interpname = trim(asString(pyInterp));
+    std::transform(interpname.begin(), interpname.end(), interpname.begin(), ::toupper);
+    if (interpname == "MONOTONECONVEX")
+      interp = qf::VolatilityTermStructure::InterpType::MONOTONECONVEX;
+    else if (interpname == "HERMITE")
+      interp = qf::VolatilityTermStructure::InterpType::HERMITE;
+    else
+      QF_ASSERT(interpname == "FLATFWD", "error: unknown volatility interpolation " + interpname);
+  }
+
   std::pair<std::string, unsigned long> pr =
     qf::market().volatilities().set(name,
-      std::make_shared<qf::VolatilityTermStructure>(tmats.begin(), tmats.end(), vals.begin(), vals.end(), voltype)
+      std::make_shared<qf::VolatilityTermStructure>(tmats.begin(), tmats.end(), vals.begin(), vals.end(),
+                                                    voltype, interp)
     );
 
   std::string tag = pr.first;
@@ -215,11 +448,22 @@ PY_BEGIN;
     return NULL;
 
   std::string name = asString(pyVolName);
-  double tmat = asDouble(pyMat);
-
   qf::SPtrVolatilityTermStructure spvol = qf::market().volatilities().get(name);
   QF_ASSERT(spvol, "error: volatility cruve " + name + " not found");
 
+  // arrays of maturities are evaluated in one call, without the GIL; sorted ones in a single sweep of the curve
+  if (hasArrays({ pyMat }))
+    return broadcastSweep({ pyMat },
+      [&](Broadcast const& bc, qf::Vector& res) {
+        if (!isSorted(bc[0]))
+          return false;
+        spvol->spotVol(bc[0].begin(), bc[0].end(), res.begin());
+        return true;
+      },
+      [&](Broadcast const& bc, size_t i) { return spvol->spotVol(bc[0][i]); });
+
+  double tmat = asDouble(pyMat);
+
   double svol = spvol->spotVol(tmat);
   return asPyScalar(svol);
 PY_END;
@@ -238,12 +482,24 @@ PY_BEGIN;
     return NULL;
 
   std::string name = asString(pyVolName);
-  double T1 = asDouble(pyMat1);
-  double T2 = asDouble(pyMat2);
-
   qf::SPtrVolatilityTermStructure spvol = qf::market().volatilities().get(name);
   QF_ASSERT(spvol, "error: volatility curve " + name + " not found");
 
+  // arrays of maturities are broadcast against each other and evaluated in one call, without the GIL;
+  // the periods of a schedule in a single sweep of the curve
+  if (hasArrays({ pyMat1, pyMat2 }))
+    return broadcastSweep({ pyMat1, pyMat2 },
+      [&](Broadcast const& bc, qf::Vector& res) {
+        if (!isChained(bc[0], bc[1]))
+          return false;
+        spvol->fwdVol(bc[0][0], bc[1].begin(), bc[1].end(), res.begin());
+        return true;
+      },
+      [&](Broadcast const& bc, size_t i) { return spvol->fwdVol(bc[0][i], bc[1][i]); });
+
+  double T1 = asDouble(pyMat1);
+  double T2 = asDouble(pyMat2);
+
   double fvol = spvol->fwdVol(T1, T2);
   return asPyScalar(fvol);
 PY_END;
@@ -2,44 +2,27 @@
 #include <qflib/defines.hpp>
 #include <qflib/products/europeancallput.hpp>
 #include <qflib/pricers/bsmcpricer.hpp>
+#include <qflib/pricers/mcsession.hpp>
 #include <qflib/math/stats/meanvarcalculator.hpp>
 #include <qflib/math/random/rng.hpp>
 #include <qflib/exception.hpp>
+#include <qflib/threadpool.hpp>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
 
 using namespace std;
 
+// The results of a Monte Carlo simulation, as (name, value) pairs
+using McResults = std::vector<std::pair<std::string, double>>;
+
+// Creates the pricer of a European option from the arguments of euroBSMC, without the number of paths
 static
-PyObject* pyQfEuroBSMC(PyObject* pyDummy, PyObject* pyArgs)
+std::shared_ptr<qf::BsMcPricer> asBsMcPricer(PyObject* pyPayoffType, PyObject* pyStrike, PyObject* pyTimeToExp,
+                                             PyObject* pySpot, PyObject* pyDiscountCrv, PyObject* pyDivYield,
+                                             PyObject* pyVolatility, PyObject* pyMcParams)
 {
-  PY_BEGIN;
-
-
-  PyObject* pyPayoffType  = nullptr;
-  PyObject* pyStrike      = nullptr;
-  PyObject* pyTimeToExp   = nullptr;
-  PyObject* pySpot        = nullptr;
-  PyObject* pyDiscountCrv = nullptr;
-  PyObject* pyDivYield    = nullptr;
-  PyObject* pyVolatility  = nullptr;
-  PyObject* pyMcParams    = nullptr;
-  PyObject* pyNPaths      = nullptr;
-
-
-  if (!PyArg_ParseTuple(pyArgs, "OOOOOOOOO",
-        &pyPayoffType,
-        &pyStrike,
-        &pyTimeToExp,
-        &pySpot,
-        &pyDiscountCrv,
-        &pyDivYield,
-        &pyVolatility,
-        &pyMcParams,
-        &pyNPaths))
-  {
-    return nullptr;
-  }
-
-
   int payoffType    = asInt(pyPayoffType);
   double strike     = asDouble(pyStrike);
   double timeToExp  = asDouble(pyTimeToExp);
@@ -50,13 +33,12 @@ PyObject* pyQfEuroBSMC(PyObject* pyDummy, PyObject* pyArgs)
 
   double divYield   = asDouble(pyDivYield);
   qf::McParams mcparams = asMcParams(pyMcParams);
-  unsigned long npaths  = asInt(pyNPaths);
   qf::SPtrProduct spprod(new qf::EuropeanCallPut(payoffType, strike, timeToExp));
 
   // Check if pyVolatility is numeric or string
   bool isNumeric = PyFloat_Check(pyVolatility) || PyLong_Check(pyVolatility);
   bool isString  = PyUnicode_Check(pyVolatility) || PyBytes_Check(pyVolatility);
-  std::unique_ptr<qf::BsMcPricer> pricer;
+  std::shared_ptr<qf::BsMcPricer> pricer;
 
   if (isNumeric)
   {
@@ -93,24 +75,319 @@ PyObject* pyQfEuroBSMC(PyObject* pyDummy, PyObject* pyArgs)
   else
   {
     QF_ASSERT(false, "Invalid argument for volatility: must be numeric (float/int) or a string handle.");
+  }
+  return pricer;
+}
+
+// Creates the pricer and reads the number of paths from the arguments of euroBSMC and euroBSMCAsync
+static
+std::shared_ptr<qf::BsMcPricer> asBsMcPricer(PyObject* pyArgs, unsigned long& npaths)
+{
+  PyObject* pyPayoffType  = nullptr;
+  PyObject* pyStrike      = nullptr;
+  PyObject* pyTimeToExp   = nullptr;
+  PyObject* pySpot        = nullptr;
+  PyObject* pyDiscountCrv = nullptr;
+  PyObject* pyDivYield    = nullptr;
+  PyObject* pyVolatility  = nullptr;
+  PyObject* pyMcParams    = nullptr;
+  PyObject* pyNPaths      = nullptr;
+
+
+  if (!PyArg_ParseTuple(pyArgs, "OOOOOOOOO",
+        &pyPayoffType,
+        &pyStrike,
+        &pyTimeToExp,
+        &pySpot,
+        &pyDiscountCrv,
+        &pyDivYield,
+        &pyVolatility,
+        &pyMcParams,
+        &pyNPaths))
+  {
     return nullptr;
   }
 
+  npaths = asInt(pyNPaths);
+  return asBsMcPricer(pyPayoffType, pyStrike, pyTimeToExp, pySpot, pyDiscountCrv, pyDivYield,
+                      pyVolatility, pyMcParams);
+}
 
-  qf::MeanVarCalculator<double*> sc(pricer->nVariables());
-  pricer->simulate(sc, npaths);
+// Runs the simulation; pure C++, called without the GIL
+static
+McResults runBsMc(qf::BsMcPricer& pricer, unsigned long npaths)
+{
+  qf::MeanVarCalculator<double*> sc(pricer.nVariables());
+  pricer.simulate(sc, npaths);
   const qf::Matrix& results = sc.results();
   size_t nsamples  = sc.nSamples();
   double mean      = results(0, 0);
   double stderror  = results(1, 0);
   stderror         = std::sqrt(stderror / nsamples);
+  McResults ret{ { "Mean", mean }, { "StdErr", stderror } };
+#ifdef QF_MC_PROFILE
+  qf::McProfile const& prof = pricer.profile();
+  ret.insert(ret.end(), { { "RngTime", prof.rngTime }, { "PathTime", prof.pathTime },
+                          { "ProductTime", prof.productTime }, { "StatsTime", prof.statsTime },
+                          { "TotalTime", prof.totalTime }, { "PathsPerSec", prof.pathsPerSec() },
+                          { "NormalsPerSec", prof.normalsPerSec() } });
+#endif
+  return ret;
+}
 
-  // Build a Python dictionary to return
+// Converts the results to a Python dictionary
+static
+PyObject* asPyDict(McResults const& results)
+{
   PyObject* ret = PyDict_New();
-  PyDict_SetItem(ret, asPyScalar("Mean"),   asPyScalar(mean));
-  PyDict_SetItem(ret, asPyScalar("StdErr"), asPyScalar(stderror));
+  for (auto const& res : results)
+    PyDict_SetItem(ret, asPyScalar(res.first), asPyScalar(res.second));
+  return ret;
+}
+
+// The pool running the asynchronous simulations, and the jobs by id until their results are collected
+static qf::ThreadPool& mcThreadPool()
+{
+  static qf::ThreadPool pool;
+  return pool;
+}
+
+static std::mutex mcJobsMutex;
+static std::map<long, std::shared_future<McResults>> mcJobs;
+static long mcNextJobId = 0;
+
+static
+std::shared_future<McResults> findMcJob(long jobId)
+{
+  std::lock_guard<std::mutex> lock(mcJobsMutex);
+  auto it = mcJobs.find(jobId);
+  QF_ASSERT(it != mcJobs.end(), "error: unknown or collected job " + std::to_string(jobId));
+  return it->second;
+}
+
+static
+PyObject* pyQfEuroBSMC(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  unsigned long npaths = 0;
+  std::shared_ptr<qf::BsMcPricer> pricer = asBsMcPricer(pyArgs, npaths);
+  if (!pricer)
+    return nullptr;
+
+  // other Python threads run during the simulation
+  McResults results;
+  {
+    GilRelease nogil;
+    results = runBsMc(*pricer, npaths);
+  }
+
+  // Build a Python dictionary to return
+  return asPyDict(results);
+
+  PY_END;
+}
 
+static
+PyObject* pyQfEuroBSMCAsync(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  // the curves are resolved now; the simulation runs on the pool
+  unsigned long npaths = 0;
+  std::shared_ptr<qf::BsMcPricer> pricer = asBsMcPricer(pyArgs, npaths);
+  if (!pricer)
+    return nullptr;
+
+  std::shared_future<McResults> fut =
+    mcThreadPool().submit([pricer, npaths]() { return runBsMc(*pricer, npaths); }).share();
+  std::lock_guard<std::mutex> lock(mcJobsMutex);
+  long jobId = ++mcNextJobId;
+  mcJobs[jobId] = fut;
+  return asPyScalar(jobId);
+
+  PY_END;
+}
+
+static
+PyObject* pyQfJobDone(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyJobId(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O", &pyJobId))
+    return NULL;
+
+  std::shared_future<McResults> fut = findMcJob(asInt(pyJobId));
+  bool done = fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  return asPyScalar(done);
+
+  PY_END;
+}
+
+static
+PyObject* pyQfJobResult(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyJobId(NULL);
+  PyObject* pyTimeout(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O|O", &pyJobId, &pyTimeout))
+    return NULL;
+
+  long jobId = asInt(pyJobId);
+  double timeout = (pyTimeout == NULL || isNone(pyTimeout)) ? -1.0 : asDouble(pyTimeout);
+  std::shared_future<McResults> fut = findMcJob(jobId);
+
+  // wait without the GIL; None if the job is still running after the timeout
+  bool done;
+  {
+    GilRelease nogil;
+    if (timeout < 0.0) {
+      fut.wait();
+      done = true;
+    }
+    else
+      done = fut.wait_for(std::chrono::duration<double>(timeout)) == std::future_status::ready;
+  }
+  if (!done)
+    Py_RETURN_NONE;
+
+  {
+    std::lock_guard<std::mutex> lock(mcJobsMutex);
+    mcJobs.erase(jobId);
+  }
+  return asPyDict(fut.get());   // rethrows the exception of a failed job
+
+  PY_END;
+}
+
+static
+PyObject* pyQfJobDiscard(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyJobId(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O", &pyJobId))
+    return NULL;
+
+  // a running job completes, but its results are dropped
+  std::lock_guard<std::mutex> lock(mcJobsMutex);
+  size_t n = mcJobs.erase(asInt(pyJobId));
+  return asPyScalar(n > 0);
+
+  PY_END;
+}
+
+// Converts the results of a Monte Carlo session to a Python dictionary
+static
+PyObject* asPyDict(qf::McSession::Results const& results)
+{
+  PyObject* ret = asPyDict(McResults{ { "Mean", results.mean }, { "StdErr", results.stdErr } });
+  PyDict_SetItem(ret, asPyScalar("NPaths"), asPyScalar(long(results.nPaths)));
   return ret;
+}
+
+// Returns the session stored under the name
+static
+qf::SPtrMcSession findMcSession(std::string const& name)
+{
+  qf::SPtrMcSession spsession = qf::market().mcSessions().get(name);
+  QF_ASSERT(spsession, "error: Monte Carlo session " + name + " not found");
+  return spsession;
+}
+
+static
+PyObject* pyQfMcSessionCreate(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyName(NULL);
+  PyObject* pyPayoffType(NULL);
+  PyObject* pyStrike(NULL);
+  PyObject* pyTimeToExp(NULL);
+  PyObject* pySpot(NULL);
+  PyObject* pyDiscountCrv(NULL);
+  PyObject* pyDivYield(NULL);
+  PyObject* pyVolatility(NULL);
+  PyObject* pyMcParams(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "OOOOOOOOO", &pyName, &pyPayoffType, &pyStrike, &pyTimeToExp, &pySpot,
+                        &pyDiscountCrv, &pyDivYield, &pyVolatility, &pyMcParams))
+    return NULL;
+
+  std::string name = asString(pyName);
+  std::shared_ptr<qf::BsMcPricer> pricer = asBsMcPricer(pyPayoffType, pyStrike, pyTimeToExp, pySpot,
+                                                        pyDiscountCrv, pyDivYield, pyVolatility, pyMcParams);
+  std::pair<std::string, unsigned long> pr =
+    qf::market().mcSessions().set(name, std::make_shared<qf::McSession>(pricer));
+
+  std::string tag = pr.first;
+  return asPyScalar(tag);
+
+  PY_END;
+}
+
+static
+PyObject* pyQfMcSessionSimulate(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyName(NULL);
+  PyObject* pyNPaths(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "OO", &pyName, &pyNPaths))
+    return NULL;
+
+  qf::SPtrMcSession spsession = findMcSession(asString(pyName));
+  int npaths = asInt(pyNPaths);
+  QF_ASSERT(npaths >= 0, "error: the number of paths must be non-negative");
+
+  // the paths continue the random number stream of the previous calls; other Python threads run meanwhile
+  qf::McSession::Results results;
+  {
+    GilRelease nogil;
+    results = spsession->simulate(static_cast<unsigned long>(npaths));
+  }
+  return asPyDict(results);
+
+  PY_END;
+}
+
+static
+PyObject* pyQfMcSessionResults(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyName(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O", &pyName))
+    return NULL;
+
+  qf::SPtrMcSession spsession = findMcSession(asString(pyName));
+  qf::McSession::Results results;
+  {
+    // waits for a simulation running on another thread
+    GilRelease nogil;
+    results = spsession->results();
+  }
+  return asPyDict(results);
+
+  PY_END;
+}
+
+static
+PyObject* pyQfMcSessionReset(PyObject* pyDummy, PyObject* pyArgs)
+{
+  PY_BEGIN;
+
+  PyObject* pyName(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "O", &pyName))
+    return NULL;
+
+  qf::SPtrMcSession spsession = findMcSession(asString(pyName));
+  {
+    GilRelease nogil;
+    spsession->reset();
+  }
+  return asPyScalar(true);
 
   PY_END;
 }
@@ -0,0 +1,292 @@
+/**
+@file  pyfunctions4.hpp
+@brief Implementation of Python callable functions
+*/
+#include <pyqflib/pyutils.hpp>
+#include <qflib/defines.hpp>
+#include <qflib/market/market.hpp>
+#include <qflib/methods/fourier/fourierpricer.hpp>
+#include <qflib/methods/fourier/bscharfunction.hpp>
+#include <qflib/methods/fourier/hestoncharfunction.hpp>
+#include <qflib/pricers/bspdepricer.hpp>
+#include <qflib/pricers/bslatticepricer.hpp>
+#include <qflib/exception.hpp>
+
+static
+PyObject* pyQfEuroFourier(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyPayoffType(NULL);
+  PyObject* pySpot(NULL);
+  PyObject* pyStrikes(NULL);
+  PyObject* pyTimeToExp(NULL);
+  PyObject* pyDiscountCrv(NULL);
+  PyObject* pyDivYield(NULL);
+  PyObject* pyModel(NULL);
+  PyObject* pyMethod(NULL);
+
+  if (!PyArg_ParseTuple(pyArgs, "OOOOOOOO", &pyPayoffType, &pySpot, &pyStrikes, &pyTimeToExp,
+    &pyDiscountCrv, &pyDivYield, &pyModel, &pyMethod))
+    return NULL;
+
+  int payoffType = asInt(pyPayoffType);
+  double spot = asDouble(pySpot);
+  NumpyView<qf::Vector> strikes(pyStrikes);
+  double timeToExp = asDouble(pyTimeToExp);
+  std::string ycName = asString(pyDiscountCrv);
+  QF_ASSERT(qf::market().yieldCurves().contains(ycName), "error: yield curve " + ycName + " not found");
+  double divYield = asDouble(pyDivYield);
+  std::string method = asString(pyMethod);
+  method = trim(method);
+  std::transform(method.begin(), method.end(), method.begin(), ::toupper);
+
+  // the prices are cached until the curves they use are replaced
+  qf::ValuationKey key("euroFourier");
+  key << payoffType << spot << strikes() << timeToExp << ycName << divYield << method
+      << std::string(Py_TYPE(pyModel)->tp_name) << asString(pyModel);
+  std::vector<qf::MarketDependency> deps{ { qf::MarketDependency::Type::YIELDCURVE, ycName } };
+  if (PyUnicode_Check(pyModel))
+    deps.push_back({ qf::MarketDependency::Type::VOLATILITY, asString(pyModel) });
+
+  // the model is a number (BS constant vol), a string (BS vol term structure) or a dictionary (Heston);
+  // the vol term structure is taken from the market by the cache
+  qf::SPtrCharacteristicFunction spcf;
+  if (PyFloat_Check(pyModel) || PyLong_Check(pyModel)) {
+    spcf.reset(new qf::BsCharFunction(asDouble(pyModel)));
+  }
+  else if (PyUnicode_Check(pyModel)) {
+    std::string volName = asString(pyModel);
+    QF_ASSERT(qf::market().volatilities().contains(volName), "error: vol curve " + volName + " not found");
+  }
+  else if (PyDict_Check(pyModel)) {
+    spcf = asHestonCharFunction(pyModel);
+  }
+  else
+    QF_ASSERT(0, "Invalid argument for model: must be a number, a vol curve name or a dictionary of Heston parameters.");
+
+  // other Python threads run during the pricing
+  qf::Vector prices;
+  {
+    GilRelease nogil;
+    prices = qf::market().valuations().get(key.str(), deps, [&](qf::MarketObjects const& objs) {
+      qf::SPtrCharacteristicFunction cf = spcf;
+      if (!cf)
+        cf.reset(new qf::BsCharFunction(objs.volatilities[0]));
+      qf::FourierPricer pricer(cf, objs.yieldCurves[0], divYield, spot);
+      qf::Vector prices;
+      if (method == "COS")
+        prices = pricer.cosPrices(payoffType, timeToExp, strikes());
+      else if (method == "FFT")
+        prices = pricer.fftPrices(payoffType, timeToExp, strikes());
+      else
+        QF_ASSERT(0, "error: unknown Fourier method " + method);
+      return prices;
+    });
+  }
+
+  return asNumpy(std::move(prices));
+PY_END;
+}
+
+static
+PyObject* pyQfOptionBSPDE(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyPayoffType(NULL);
+  PyObject* pyExerType(NULL);
+  PyObject* pyStrike(NULL);
+  PyObject* pyTimeToExp(NULL);
+  PyObject* pySpot(NULL);
+  PyObject* pyDiscountCrv(NULL);
+  PyObject* pyDivYield(NULL);
+  PyObject* pyVolatility(NULL);
+  PyObject* pyLowerBarrier(NULL);
+  PyObject* pyUpperBarrier(NULL);
+  PyObject* pyPdeParams(NULL);
+
+  if (!PyArg_ParseTuple(pyArgs, "OOOOOOOOOOO", &pyPayoffType, &pyExerType, &pyStrike, &pyTimeToExp,
+    &pySpot, &pyDiscountCrv, &pyDivYield, &pyVolatility, &pyLowerBarrier, &pyUpperBarrier, &pyPdeParams))
+    return NULL;
+
+  int payoffType = asInt(pyPayoffType);
+  std::string exer = asString(pyExerType);
+  exer = trim(exer);
+  std::transform(exer.begin(), exer.end(), exer.begin(), ::toupper);
+  qf::BsPdePricer::ExerciseType exerType;
+  if (exer == "EUROPEAN")
+    exerType = qf::BsPdePricer::ExerciseType::EUROPEAN;
+  else if (exer == "AMERICAN")
+    exerType = qf::BsPdePricer::ExerciseType::AMERICAN;
+  else
+    QF_ASSERT(0, "error: unknown exercise type " + exer);
+  double strike = asDouble(pyStrike);
+  double timeToExp = asDouble(pyTimeToExp);
+  double spot = asDouble(pySpot);
+  std::string ycName = asString(pyDiscountCrv);
+  QF_ASSERT(qf::market().yieldCurves().contains(ycName), "error: yield curve " + ycName + " not found");
+  double divYield = asDouble(pyDivYield);
+  double lowerBarrier = asDouble(pyLowerBarrier);
+  double upperBarrier = asDouble(pyUpperBarrier);
+  qf::PdeParams pdeparams = asPdeParams(pyPdeParams);
+
+  // the results are cached until the curves they use are replaced
+  qf::ValuationKey key("optionBSPDE");
+  key << payoffType << exer << strike << timeToExp << spot << ycName << divYield << lowerBarrier << upperBarrier
+      << pdeparams.nSpaceNodes << pdeparams.nTimeSteps << pdeparams.nRannacherSteps
+      << pdeparams.nStdevs << pdeparams.concentration;
+  // the volatility is a number or the name of a vol term structure
+  std::vector<qf::MarketDependency> deps{ { qf::MarketDependency::Type::YIELDCURVE, ycName } };
+  // the curves are taken from the market by the cache
+  bool volCurve = PyUnicode_Check(pyVolatility);
+  double volatility = 0.0;
+  if (volCurve) {
+    std::string volName = asString(pyVolatility);
+    QF_ASSERT(qf::market().volatilities().contains(volName), "error: vol curve " + volName + " not found");
+    key << volName;
+    deps.push_back({ qf::MarketDependency::Type::VOLATILITY, volName });
+  }
+  else {
+    volatility = asDouble(pyVolatility);
+    key << volatility;
+  }
+
+  // other Python threads run during the pricing
+  qf::Vector results;
+  {
+    GilRelease nogil;
+    results = qf::market().valuations().get(key.str(), deps, [&](qf::MarketObjects const& objs) {
+      std::unique_ptr<qf::BsPdePricer> pricer;
+      if (volCurve)
+        pricer.reset(new qf::BsPdePricer(payoffType, strike, timeToExp, exerType, lowerBarrier, upperBarrier,
+                                         objs.yieldCurves[0], divYield, objs.volatilities[0], spot, pdeparams));
+      else
+        pricer.reset(new qf::BsPdePricer(payoffType, strike, timeToExp, exerType, lowerBarrier, upperBarrier,
+                                         objs.yieldCurves[0], divYield, volatility, spot, pdeparams));
+      return pricer->solve();
+    });
+  }
+  return asNumpy(std::move(results));
+PY_END;
+}
+
+static
+PyObject* pyQfOptionBSLattice(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyPayoffType(NULL);
+  PyObject* pyExerType(NULL);
+  PyObject* pyStrike(NULL);
+  PyObject* pyTimeToExp(NULL);
+  PyObject* pyExerTimes(NULL);
+  PyObject* pySpot(NULL);
+  PyObject* pyDiscountCrv(NULL);
+  PyObject* pyDivYield(NULL);
+  PyObject* pyVolatility(NULL);
+  PyObject* pyLatticeParams(NULL);
+
+  if (!PyArg_ParseTuple(pyArgs, "OOOOOOOOOO", &pyPayoffType, &pyExerType, &pyStrike, &pyTimeToExp,
+    &pyExerTimes, &pySpot, &pyDiscountCrv, &pyDivYield, &pyVolatility, &pyLatticeParams))
+    return NULL;
+
+  int payoffType = asInt(pyPayoffType);
+  std::string exer = asString(pyExerType);
+  exer = trim(exer);
+  std::transform(exer.begin(), exer.end(), exer.begin(), ::toupper);
+  qf::BsLatticePricer::ExerciseType exerType;
+  if (exer == "EUROPEAN")
+    exerType = qf::BsLatticePricer::ExerciseType::EUROPEAN;
+  else if (exer == "AMERICAN")
+    exerType = qf::BsLatticePricer::ExerciseType::AMERICAN;
+  else if (exer == "BERMUDAN")
+    exerType = qf::BsLatticePricer::ExerciseType::BERMUDAN;
+  else
+    QF_ASSERT(0, "error: unknown exercise type " + exer);
+  double strike = asDouble(pyStrike);
+  double timeToExp = asDouble(pyTimeToExp);
+  qf::Vector exerTimes;
+  if (exerType == qf::BsLatticePricer::ExerciseType::BERMUDAN)
+    exerTimes = asVector(pyExerTimes);
+  double spot = asDouble(pySpot);
+  std::string ycName = asString(pyDiscountCrv);
+  QF_ASSERT(qf::market().yieldCurves().contains(ycName), "error: yield curve " + ycName + " not found");
+  double divYield = asDouble(pyDivYield);
+  qf::LatticeParams latticeparams = asLatticeParams(pyLatticeParams);
+
+  // the results are cached until the curves they use are replaced
+  qf::ValuationKey key("optionBSLattice");
+  key << payoffType << exer << strike << timeToExp << exerTimes << spot << ycName << divYield
+      << static_cast<int>(latticeparams.treeType) << latticeparams.nSteps;
+  // the volatility is a number or the name of a vol term structure
+  std::vector<qf::MarketDependency> deps{ { qf::MarketDependency::Type::YIELDCURVE, ycName } };
+  // the curves are taken from the market by the cache
+  bool volCurve = PyUnicode_Check(pyVolatility);
+  double volatility = 0.0;
+  if (volCurve) {
+    std::string volName = asString(pyVolatility);
+    QF_ASSERT(qf::market().volatilities().contains(volName), "error: vol curve " + volName + " not found");
+    key << volName;
+    deps.push_back({ qf::MarketDependency::Type::VOLATILITY, volName });
+  }
+  else {
+    volatility = asDouble(pyVolatility);
+    key << volatility;
+  }
+
+  // other Python threads run during the pricing
+  qf::Vector results;
+  {
+    GilRelease nogil;
+    results = qf::market().valuations().get(key.str(), deps, [&](qf::MarketObjects const& objs) {
+      std::unique_ptr<qf::BsLatticePricer> pricer;
+      if (volCurve)
+        pricer.reset(new qf::BsLatticePricer(payoffType, strike, timeToExp, exerType, exerTimes,
+                                             objs.yieldCurves[0], divYield, objs.volatilities[0], spot, latticeparams));
+      else
+        pricer.reset(new qf::BsLatticePricer(payoffType, strike, timeToExp, exerType, exerTimes,
+                                             objs.yieldCurves[0], divYield, volatility, spot, latticeparams));
+      return pricer->solve();
+    });
+  }
+  return asNumpy(std::move(results));
+PY_END;
+}
+
+static
+PyObject* pyQfScenarioVaR(PyObject* pyDummy, PyObject* pyArgs)
+{
+PY_BEGIN;
+
+  PyObject* pyTrades(NULL);
+  PyObject* pyMarketFiles(NULL);
+  PyObject* pySpotReturns(NULL);
+  PyObject* pyConfidences(NULL);
+  if (!PyArg_ParseTuple(pyArgs, "OOOO", &pyTrades, &pyMarketFiles, &pySpotReturns, &pyConfidences))
+    return NULL;
+
+  QF_ASSERT(PyList_Check(pyTrades), "error: trades must be a list of dictionaries");
+  std::vector<qf::Trade> trades;
+  for (Py_ssize_t i = 0; i < PyList_Size(pyTrades); ++i)
+    trades.push_back(asTrade(PyList_GetItem(pyTrades, i)));   // borrowed reference
+  std::vector<std::string> marketFiles = asStrVec(pyMarketFiles);
+  qf::Vector spotReturns = pySpotReturns == Py_None ? qf::Vector() : asVector(pySpotReturns);
+  qf::Vector confidences = asVector(pyConfidences);
+
+  qf::ScenarioEngine engine(trades);
+  qf::ScenarioEngine::VarResults results;
+  {
+    GilRelease nogil;
+    results = engine.valueAtRisk(marketFiles, spotReturns, confidences);
+  }
+
+  // return the results as a Python dictionary
+  PyObject* ret = PyDict_New();
+  PyDict_SetItem(ret, asPyScalar("BaseValues"), asNumpy(std::move(results.baseValues)));
+  PyDict_SetItem(ret, asPyScalar("VaR"), asNumpy(std::move(results.var)));
+  PyDict_SetItem(ret, asPyScalar("ES"), asNumpy(std::move(results.es)));
+  PyDict_SetItem(ret, asPyScalar("NScenarios"), asPyScalar(long(results.nScenarios)));
+  return ret;
+PY_END;
+}
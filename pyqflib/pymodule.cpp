@@ -9,6 +9,7 @@
 #include "pyfunctions1.hpp"
 #include "pyfunctions2.hpp"
 #include "pyfunctions3.hpp"
+#include "pyfunctions4.hpp"
 
 static PyMethodDef PyQflibMethods[] = 
 {
@@ -51,11 +52,17 @@ static PyMethodDef PyQflibMethods[] =
 // functions 2
   { "mktList", pyQfMktList, METH_VARARGS, "lists all market objects." },
   { "mktClear", pyQfMktClear, METH_VARARGS, "deletes all market objects." },
+  { "mktSave", pyQfMktSave, METH_VARARGS, "saves all market objects to a binary file." },
+  { "mktLoad", pyQfMktLoad, METH_VARARGS, "replaces all market objects with the ones in a binary file." },
+  { "cacheStats", pyQfCacheStats, METH_VARARGS, "returns the valuation cache counters." },
+  { "cacheClear", pyQfCacheClear, METH_VARARGS, "clears the valuation cache." },
   { "ycCreate", pyQfYCCreate, METH_VARARGS, "creates a yield curve." },
   { "discount", pyQfDiscount, METH_VARARGS, "discount factor to maturity." },
   { "fwdDiscount", pyQfFwdDiscount, METH_VARARGS, "fwd discount factor between the two maturities." },
   { "spotRate", pyQfSpotRate, METH_VARARGS, "spot rate to maturity." },
   { "fwdRate", pyQfFwdRate, METH_VARARGS, "fwd rate between the two maturities." },
+  { "ycBootstrap", pyQfYCBootstrap, METH_VARARGS, "bootstraps a yield curve from deposits, FRAs and swaps." },
+  { "swapRate", pyQfSwapRate, METH_VARARGS, "fwd par swap rate between the two maturities." },
   { "volCreate", pyQfVolCreate, METH_VARARGS, "creates a volatility curve." },
   { "spotVol", pyQfSpotVol, METH_VARARGS, "spot volatility to maturity." },
   { "fwdVol", pyQfFwdVol, METH_VARARGS, "fwd volatility between the two maturities." },
@@ -63,6 +70,19 @@ static PyMethodDef PyQflibMethods[] =
   { "cdsPV", pyQfCDSPV, METH_VARARGS, "present value of a CDS." },
 // functions 3
   { "euroBSMC", pyQfEuroBSMC, METH_VARARGS | METH_KEYWORDS, "price of a European option in the Black-Scholes model using Monte Carlo." },
+  { "euroBSMCAsync", pyQfEuroBSMCAsync, METH_VARARGS, "starts the Monte Carlo pricing of a European option on a thread pool and returns the job id." },
+  { "jobDone", pyQfJobDone, METH_VARARGS, "returns true if an asynchronous job has completed." },
+  { "jobResult", pyQfJobResult, METH_VARARGS, "waits for an asynchronous job and returns its results." },
+  { "jobDiscard", pyQfJobDiscard, METH_VARARGS, "drops the results of an asynchronous job." },
+  { "mcSessionCreate", pyQfMcSessionCreate, METH_VARARGS, "creates a Monte Carlo session for a European option in the Black-Scholes model." },
+  { "mcSessionSimulate", pyQfMcSessionSimulate, METH_VARARGS, "simulates more paths in a Monte Carlo session." },
+  { "mcSessionResults", pyQfMcSessionResults, METH_VARARGS, "returns the accumulated results of a Monte Carlo session." },
+  { "mcSessionReset", pyQfMcSessionReset, METH_VARARGS, "clears the accumulated results of a Monte Carlo session." },
+// functions 4
+  { "euroFourier", pyQfEuroFourier, METH_VARARGS, "prices of European options on a strip of strikes using Fourier methods." },
+  { "optionBSPDE", pyQfOptionBSPDE, METH_VARARGS, "price and Greeks of a European or American, vanilla or knock-out option in the Black-Scholes model using finite differences." },
+  { "optionBSLattice", pyQfOptionBSLattice, METH_VARARGS, "price and Greeks of a European, American or Bermudan option in the Black-Scholes model using a recombining tree." },
+  { "scenarioVaR", pyQfScenarioVaR, METH_VARARGS, "historical VaR and expected shortfall of a portfolio revalued on saved market scenarios." },
   {NULL, NULL, 0, NULL}
 };
 
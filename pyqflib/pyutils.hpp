@@ -7,7 +7,12 @@
 #define PYORFLIB_PYUTILS_HPP
 
 #include <qflib/math/matrix.hpp>
+#include <qflib/market/yieldcurve.hpp>
 #include <qflib/methods/montecarlo/mcparams.hpp>
+#include <qflib/methods/fourier/hestoncharfunction.hpp>
+#include <qflib/methods/pde/pdeparams.hpp>
+#include <qflib/methods/lattice/latticeparams.hpp>
+#include <qflib/risk/scenarioengine.hpp>
 #include <pyqflib/pycpp.hpp>   // NOTE: include the python headers last (before armadillo)
 
 /** utility function for trimming strings */
@@ -19,47 +24,281 @@ std::string trim(const std::string &s)
   return (wsback <= wsfront ? std::string() : std::string(wsfront, wsback));
 }
 
-/** Converts a numpy 1-D array to an qf::Vector.
+/** A read-only qf::Vector or qf::Matrix viewing the data of a numpy array.
+    Float64 arrays in the Armadillo layout, i.e. 1-D arrays with unit stride and Fortran-ordered 2-D arrays,
+    are viewed in place, without copying. Other inputs, e.g. C-ordered or strided arrays, other dtypes or lists,
+    are converted once by numpy. The view holds a reference to the array; use it within the call receiving the array.
+*/
+template <typename T>
+class NumpyView
+{
+public:
+  /** Ctor from a numpy array, or any object convertible to one */
+  explicit NumpyView(PyObject* pyArr);
+
+  ~NumpyView() { Py_DECREF(arr_); }
+
+  NumpyView(NumpyView const&) = delete;
+  NumpyView& operator=(NumpyView const&) = delete;
+
+  /** Returns the view */
+  T const& operator()() const { return view_; }
+
+private:
+  PyArrayObject* arr_;
+  T view_;
+};
+
+template <>
+inline NumpyView<qf::Vector>::NumpyView(PyObject* pyArr)
+: arr_(asDblArray(pyArr, 1, false)),
+  view_((double*) PyArray_DATA(arr_), (arma::uword) PyArray_DIM(arr_, 0), false, true)
+{}
+
+template <>
+inline NumpyView<qf::Matrix>::NumpyView(PyObject* pyArr)
+: arr_(asDblArray(pyArr, 2, true)),
+  view_((double*) PyArray_DATA(arr_), (arma::uword) PyArray_DIM(arr_, 0), (arma::uword) PyArray_DIM(arr_, 1),
+        false, true)
+{}
+
+/** Converts a numpy 1-D array to an qf::Vector, copying its data once.
 */
 static qf::Vector asVector(PyObject* pyVec)
 {
-  return qf::Vector(asDblVec(pyVec));
+  return qf::Vector(NumpyView<qf::Vector>(pyVec)());
+}
+
+/** Moves an qf::Vector to a numpy vector without copying its data.
+    The array owns the vector through a capsule and frees it when it is collected.
+*/
+static PyObject* asNumpy(qf::Vector&& vec)
+{
+  qf::Vector* pvec = new qf::Vector(std::move(vec));
+  npy_intp dims[1] = { (npy_intp) pvec->n_elem };
+  PyObject* owner = asPyCapsule(pvec);
+  return asPyArray(pvec->memptr(), 1, dims, false, owner);
 }
 
-/** Converts an qf::Vector to a numpy vector
+/** Converts an qf::Vector to a numpy vector, copying its data once
 */
 static PyObject* asNumpy(qf::Vector const & vec)
 {
-  return asPyArray(arma::conv_to<std::vector<double>>::from(vec));
+  return asNumpy(qf::Vector(vec));
 }
 
-/** Converts a numpy 2-D array to an qf::Matrix.
+/** Converts a numpy 2-D array to an qf::Matrix, copying its data once.
 */
 static qf::Matrix asMatrix(PyObject* pyMat)
 {
-  std::vector<std::vector<double>> dvecvec = asDblVecVec(pyMat);
-  size_t nrows = dvecvec.size();
-  size_t ncols = dvecvec.front().size();
-  qf::Matrix mat(nrows, ncols);
-  for (size_t i = 0; i < nrows; ++i)
-    for (size_t j = 0; j < ncols; ++j)
-      mat(i, j) = dvecvec[i][j];
-  return mat;
+  return qf::Matrix(NumpyView<qf::Matrix>(pyMat)());
 }
 
-/** Converts an qf::Matrix to numpy
+/** Moves an qf::Matrix to a Fortran-ordered numpy array without copying its data.
+    The array owns the matrix through a capsule and frees it when it is collected.
+*/
+static PyObject* asNumpy(qf::Matrix&& mat)
+{
+  qf::Matrix* pmat = new qf::Matrix(std::move(mat));
+  npy_intp dims[2] = { (npy_intp) pmat->n_rows, (npy_intp) pmat->n_cols };
+  PyObject* owner = asPyCapsule(pmat);
+  return asPyArray(pmat->memptr(), 2, dims, true, owner);
+}
+
+/** Converts an qf::Matrix to numpy, copying its data once
 */
 static PyObject* asNumpy(qf::Matrix const & mat)
 {
-  size_t nrows = mat.n_rows;
-  size_t ncols = mat.n_cols;
-  std::vector<std::vector<double>> dvecvec(nrows);
-  for (size_t i = 0; i < nrows; ++i) {
-    dvecvec[i].resize(ncols);
-    for (size_t j = 0; j < ncols; ++j)
-      dvecvec[i][j] = mat(i, j);
+  return asNumpy(qf::Matrix(mat));
+}
+
+/** Returns true if any of the arguments is a numpy array, a list or a tuple, rather than a scalar */
+static bool hasArrays(std::initializer_list<PyObject*> pyArgs)
+{
+  for (PyObject* p : pyArgs)
+    if (PyArray_Check(p) || PyList_Check(p) || PyTuple_Check(p))
+      return true;
+  return false;
+}
+
+/** Broadcasts numbers and arrays against each other, with the numpy rules.
+    Each argument is converted to float64 and expanded to the broadcast shape, as a contiguous qf::Vector
+    in C order, ready for the batch kernels. Arguments which already have the broadcast shape and layout
+    are viewed in place, without copying. asNumpy gives the results of the kernels the broadcast shape.
+*/
+class Broadcast
+{
+public:
+  /** Ctor from the Python arguments */
+  explicit Broadcast(std::initializer_list<PyObject*> pyArgs);
+
+  Broadcast(Broadcast const&) = delete;
+  Broadcast& operator=(Broadcast const&) = delete;
+
+  /** Returns the number of elements of the broadcast shape */
+  size_t size() const { return size_; }
+
+  /** Returns true if all the arguments are scalars */
+  bool scalar() const { return shape_.empty(); }
+
+  /** Returns the values of argument k, expanded to the broadcast shape */
+  qf::Vector const& operator[](size_t k) const { return args_[k]; }
+
+  /** Returns the values of argument k as integers, e.g. payoff types; throws if one is not integral */
+  std::vector<int> asInts(size_t k) const;
+
+  /** Moves vec, of size size(), to a numpy array with the broadcast shape */
+  PyObject* asNumpy(qf::Vector&& vec) const;
+
+  /** Moves mat, with size() rows, to a numpy array of shape (mat.n_cols, broadcast shape),
+      e.g. the price and Greeks of each option, so that the results unpack by column
+  */
+  PyObject* asNumpy(qf::Matrix&& mat) const;
+
+private:
+  // owns the references to the arrays, so that they are released also if the ctor throws
+  struct ArrayRefs
+  {
+    ArrayRefs() = default;
+    ArrayRefs(ArrayRefs const&) = delete;
+    ArrayRefs& operator=(ArrayRefs const&) = delete;
+    ~ArrayRefs() { for (PyObject* a : arrs) Py_DECREF(a); }
+
+    std::vector<PyObject*> arrs;
+  };
+
+  ArrayRefs refs_;                  // the arguments as float64 arrays
+  std::vector<npy_intp> shape_;
+  size_t size_;
+  std::vector<qf::Vector> args_;
+};
+
+inline Broadcast::Broadcast(std::initializer_list<PyObject*> pyArgs)
+{
+  std::vector<PyObject*>& arrs = refs_.arrs;
+  arrs.reserve(pyArgs.size());
+  for (PyObject* p : pyArgs) {
+    PyObject* arr = PyArray_FROM_OTF(p, NPY_DOUBLE, NPY_ARRAY_ALIGNED);
+    QF_ASSERT(arr != nullptr, "Broadcast: argument not convertible to a float64 array");
+    arrs.push_back(arr);
+  }
+  // the broadcast shape; the iterator holds its own references to the arrays
+  PyObject* pyIter = PyArray_MultiIterFromObjects(arrs.data(), (int) arrs.size(), 0);
+  QF_ASSERT(pyIter != nullptr, "Broadcast: the arguments cannot be broadcast together");
+  PyArrayMultiIterObject* mit = (PyArrayMultiIterObject*) pyIter;
+  shape_.assign(mit->dimensions, mit->dimensions + mit->nd);
+  size_ = (size_t) mit->size;
+  Py_DECREF(pyIter);
+
+  // scalars are repeated, arrays with the broadcast shape are viewed, the others are expanded;
+  // the vectors are built in place, since moving a view may copy it
+  args_.reserve(arrs.size());
+  for (size_t k = 0; k < arrs.size(); ++k) {
+    PyArrayObject* arr = (PyArrayObject*) arrs[k];
+    if (PyArray_SIZE(arr) == 1) {
+      args_.emplace_back(size_);
+      args_[k].fill(*(double*) PyArray_DATA(arr));
+    }
+    else if (PyArray_IS_C_CONTIGUOUS(arr) && PyArray_NDIM(arr) == (int) shape_.size()
+             && std::equal(shape_.begin(), shape_.end(), PyArray_DIMS(arr))) {
+      args_.emplace_back((double*) PyArray_DATA(arr), size_, false, true);
+    }
+    else {
+      args_.emplace_back(size_);
+      PyObject* pyArrIter = PyArray_BroadcastToShape(arrs[k], shape_.data(), (int) shape_.size());
+      QF_ASSERT(pyArrIter != nullptr, "Broadcast: the arguments cannot be broadcast together");
+      PyArrayIterObject* it = (PyArrayIterObject*) pyArrIter;
+      for (size_t i = 0; PyArray_ITER_NOTDONE(it); ++i) {
+        args_[k][i] = *(double*) PyArray_ITER_DATA(it);
+        PyArray_ITER_NEXT(it);
+      }
+      Py_DECREF(pyArrIter);
+    }
+  }
+}
+
+inline std::vector<int> Broadcast::asInts(size_t k) const
+{
+  std::vector<int> ints(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    ints[i] = (int) args_[k][i];
+    QF_ASSERT(ints[i] == args_[k][i], "Broadcast: integer values expected");
   }
-  return asPyArray(dvecvec);
+  return ints;
+}
+
+inline PyObject* Broadcast::asNumpy(qf::Vector&& vec) const
+{
+  QF_ASSERT(vec.n_elem == size_, "Broadcast: the results do not match the broadcast shape");
+  qf::Vector* pvec = new qf::Vector(std::move(vec));
+  std::vector<npy_intp> dims(shape_);
+  PyObject* owner = asPyCapsule(pvec);
+  return asPyArray(pvec->memptr(), (int) dims.size(), dims.data(), false, owner);
+}
+
+inline PyObject* Broadcast::asNumpy(qf::Matrix&& mat) const
+{
+  QF_ASSERT(mat.n_rows == size_, "Broadcast: the results do not match the broadcast shape");
+  // the columns are contiguous, hence the matrix is a C-ordered array with the columns first
+  qf::Matrix* pmat = new qf::Matrix(std::move(mat));
+  std::vector<npy_intp> dims(1, (npy_intp) pmat->n_cols);
+  dims.insert(dims.end(), shape_.begin(), shape_.end());
+  PyObject* owner = asPyCapsule(pmat);
+  return asPyArray(pmat->memptr(), (int) dims.size(), dims.data(), false, owner);
+}
+
+/** Evaluates f(bc, i) at each element i of the arguments broadcast against each other, without the GIL.
+    Returns the results as a numpy array with the broadcast shape, or as a number if all arguments are scalars.
+*/
+template <typename F>
+static PyObject* broadcastEval(std::initializer_list<PyObject*> pyArgs, F f)
+{
+  Broadcast bc(pyArgs);
+  qf::Vector res(bc.size());
+  {
+    GilRelease nogil;
+    for (size_t i = 0; i < bc.size(); ++i)
+      res[i] = f(bc, i);
+  }
+  return bc.scalar() ? asPyScalar(res[0]) : bc.asNumpy(std::move(res));
+}
+
+/** Evaluates the arguments broadcast against each other in one pass, without the GIL.
+    sweep(bc, res) fills res, of size bc.size(), and returns true if it applies to the arguments, e.g. to
+    sorted maturities; otherwise f(bc, i) is evaluated at each element, as in broadcastEval.
+*/
+template <typename S, typename F>
+static PyObject* broadcastSweep(std::initializer_list<PyObject*> pyArgs, S sweep, F f)
+{
+  Broadcast bc(pyArgs);
+  qf::Vector res(bc.size());
+  {
+    GilRelease nogil;
+    if (!sweep(bc, res)) {
+      for (size_t i = 0; i < bc.size(); ++i)
+        res[i] = f(bc, i);
+    }
+  }
+  return bc.scalar() ? asPyScalar(res[0]) : bc.asNumpy(std::move(res));
+}
+
+/** Returns true if the values are in ascending order */
+inline bool isSorted(qf::Vector const& v)
+{
+  return std::is_sorted(v.begin(), v.end());
+}
+
+/** Returns true if the periods [t1[i], t2[i]] follow each other, i.e. t2 is sorted, t1[0] <= t2[0]
+    and t1[i] == t2[i - 1], as in a schedule
+*/
+inline bool isChained(qf::Vector const& t1, qf::Vector const& t2)
+{
+  if (t1.n_elem == 0 || t1[0] > t2[0] || !isSorted(t2))
+    return false;
+  for (size_t i = 1; i < t1.n_elem; ++i)
+    if (t1[i] != t2[i - 1])
+      return false;
+  return true;
 }
 
 /** Converts a Python dictionary with name-value pairs to an McParams structure.
@@ -102,4 +341,128 @@ static qf::McParams asMcParams(PyObject* dict)
   return mcparams;
 }
 
+/** Converts a Python dictionary with Heston model parameters to a characteristic function.
+*/
+static qf::SPtrCharacteristicFunction asHestonCharFunction(PyObject* dict)
+{
+  QF_ASSERT(PyDict_Check(dict) == 1, "asHestonCharFunction: input param must be a dictionary");
+
+  const char* names[] = { "V0", "KAPPA", "THETA", "SIGMA", "RHO" };
+  double vals[5];
+  for (size_t i = 0; i < 5; ++i) {
+    PyObject* pyVal = PyDict_GetItemString(dict, names[i]);  // borrowed reference
+    QF_ASSERT(pyVal != nullptr, 
+      std::string("asHestonCharFunction: input dictionary does not contain key ") + names[i]);
+    vals[i] = asDouble(pyVal);
+  }
+  return std::make_shared<qf::HestonCharFunction>(vals[0], vals[1], vals[2], vals[3], vals[4]);
+}
+
+/** Converts a Python dictionary to PDE parameters.
+    The keys NSPACENODES, NTIMESTEPS and NRANNACHER are optional; missing keys keep their defaults.
+*/
+static qf::PdeParams asPdeParams(PyObject* dict)
+{
+  QF_ASSERT(PyDict_Check(dict) == 1, "asPdeParams: input param must be a dictionary");
+
+  qf::PdeParams defaults;
+  size_t vals[3] = { defaults.nSpaceNodes, defaults.nTimeSteps, defaults.nRannacherSteps };
+  const char* names[] = { "NSPACENODES", "NTIMESTEPS", "NRANNACHER" };
+  for (size_t i = 0; i < 3; ++i) {
+    PyObject* pyVal = PyDict_GetItemString(dict, names[i]);  // borrowed reference
+    if (pyVal != nullptr) {
+      int val = asInt(pyVal);
+      QF_ASSERT(val >= 0, std::string("asPdeParams: negative value for ") + names[i]);
+      vals[i] = static_cast<size_t>(val);
+    }
+  }
+  return qf::PdeParams(vals[0], vals[1], vals[2]);
+}
+
+/** Converts a number of payments per year to a swap frequency */
+static qf::YieldCurve::SwapFreq asSwapFreq(int freq)
+{
+  switch (freq) {
+  case 1:
+    return qf::YieldCurve::SwapFreq::ANNUAL;
+  case 2:
+    return qf::YieldCurve::SwapFreq::SEMIANNUAL;
+  case 4:
+    return qf::YieldCurve::SwapFreq::QUARTERLY;
+  case 12:
+    return qf::YieldCurve::SwapFreq::MONTHLY;
+  case 52:
+    return qf::YieldCurve::SwapFreq::WEEKLY;
+  default:
+    QF_ASSERT(0, "asSwapFreq: the payment frequency must be one of 1, 2, 4, 12 or 52");
+  }
+  return qf::YieldCurve::SwapFreq::ANNUAL;
+}
+
+/** Converts a Python dictionary to lattice parameters.
+    The keys TREETYPE and NSTEPS are optional; missing keys keep their defaults.
+*/
+static qf::LatticeParams asLatticeParams(PyObject* dict)
+{
+  QF_ASSERT(PyDict_Check(dict) == 1, "asLatticeParams: input param must be a dictionary");
+
+  qf::LatticeParams latticeparams;
+  PyObject* pyVal = PyDict_GetItemString(dict, "TREETYPE");  // borrowed reference
+  if (pyVal != nullptr) {
+    std::string paramvalue = asString(pyVal);
+    paramvalue = trim(paramvalue);
+    std::transform(paramvalue.begin(), paramvalue.end(), paramvalue.begin(), ::toupper);
+    if (paramvalue == "CRR")
+      latticeparams.treeType = qf::LatticeParams::TreeType::CRR;
+    else if (paramvalue == "LEISENREIMER")
+      latticeparams.treeType = qf::LatticeParams::TreeType::LEISENREIMER;
+    else if (paramvalue == "TRINOMIAL")
+      latticeparams.treeType = qf::LatticeParams::TreeType::TRINOMIAL;
+    else
+      QF_ASSERT(0, "asLatticeParams: invalid value for LatticeParam TREETYPE!");
+  }
+  pyVal = PyDict_GetItemString(dict, "NSTEPS");  // borrowed reference
+  if (pyVal != nullptr) {
+    int nsteps = asInt(pyVal);
+    QF_ASSERT(nsteps >= 3, "asLatticeParams: at least 3 time steps are required");
+    latticeparams.nSteps = static_cast<size_t>(nsteps);
+  }
+  return latticeparams;
+}
+
+/** Converts a Python dictionary to a trade.
+    The keys QUANTITY (default 1) and NPATHS (default 10000) are optional.
+*/
+static qf::Trade asTrade(PyObject* dict)
+{
+  QF_ASSERT(PyDict_Check(dict) == 1, "asTrade: each trade must be a dictionary");
+
+  const char* names[] = { "TYPE", "PAYOFF", "STRIKE", "TIMETOEXP", "SPOT", "DIVYIELD", "YIELDCURVE", "VOLATILITY" };
+  PyObject* vals[8];
+  for (size_t i = 0; i < 8; ++i) {
+    vals[i] = PyDict_GetItemString(dict, names[i]);  // borrowed reference
+    QF_ASSERT(vals[i] != nullptr, std::string("asTrade: trade dictionary does not contain key ") + names[i]);
+  }
+
+  std::string type = trim(asString(vals[0]));
+  std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+  qf::Trade::Type ttype = qf::Trade::Type::EUROPEAN;
+  if (type == "EUROPEAN")
+    ttype = qf::Trade::Type::EUROPEAN;
+  else if (type == "DIGITAL")
+    ttype = qf::Trade::Type::DIGITAL;
+  else if (type == "EUROPEANMC")
+    ttype = qf::Trade::Type::EUROPEANMC;
+  else
+    QF_ASSERT(0, "asTrade: invalid trade type " + type);
+
+  PyObject* pyQuantity = PyDict_GetItemString(dict, "QUANTITY");
+  PyObject* pyNPaths = PyDict_GetItemString(dict, "NPATHS");
+  double quantity = pyQuantity != nullptr ? asDouble(pyQuantity) : 1.0;
+  int npaths = pyNPaths != nullptr ? asInt(pyNPaths) : 10000;
+  QF_ASSERT(npaths > 0, "asTrade: NPATHS must be positive");
+  return qf::Trade(ttype, asInt(vals[1]), asDouble(vals[2]), asDouble(vals[3]), asDouble(vals[4]), asDouble(vals[5]),
+                   asString(vals[6]), asString(vals[7]), quantity, static_cast<unsigned long>(npaths));
+}
+
 #endif // PYORFLIB_PYUTILS_HPP
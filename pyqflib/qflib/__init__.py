@@ -327,25 +327,31 @@ def digiBS(payofftype, spot, strike, timetoexp, intrate, divyield, volatility):
 
     Parameters
     ----------
-    payofftype : {1, -1}
+    payofftype : {1, -1} or array_like
         1 for call, -1 for put
-    spot : double
+    spot : double or array_like
         asset spot price
-    strike : double
+    strike : double or array_like
         strike price
-    timetoexp : double
+    timetoexp : double or array_like
         time to expiration in years
-    intrate : double
+    intrate : double or array_like
         interest rate, p.a. and c.c.
-    divyield : double    
+    divyield : double or array_like
         asset dividend yield, p.a. and c.c.
-    volatility : double
+    volatility : double or array_like
         asset return volatility
 
     Returns
     -------
-    1D numpy array
+    numpy array
         Array with Price, Delta, Gamma, Theta, Vega
+
+    Notes
+    -----
+    All the inputs may be arrays, which are broadcast against each other with the numpy rules and priced
+    in a single call by the batch kernel, in parallel and without the GIL. The results then have
+    the shape (5, broadcast shape), so that price, delta, gamma, theta, vega = digiBS(...) unpacks them.
     """
     return pyqflib.digiBS(payofftype, spot, strike, timetoexp, intrate, divyield, volatility)
 
@@ -355,25 +361,31 @@ def euroBS(payofftype, spot, strike, timetoexp, intrate, divyield, volatility):
 
     Parameters
     ----------
-    payofftype : {1, -1}
+    payofftype : {1, -1} or array_like
         1 for call, -1 for put
-    spot : double
+    spot : double or array_like
         asset spot price
-    strike : double
+    strike : double or array_like
         strike price
-    timetoexp : double
+    timetoexp : double or array_like
         time to expiration in years
-    intrate : double
+    intrate : double or array_like
         interest rate, p.a. and c.c.
-    divyield : double    
+    divyield : double or array_like
         asset dividend yield, p.a. and c.c.
-    volatility : double
+    volatility : double or array_like
         asset return volatility
 
     Returns
     -------
-    1D numpy array
+    numpy array
         Array with Price, Delta, Gamma, Theta, Vega
+
+    Notes
+    -----
+    All the inputs may be arrays, which are broadcast against each other with the numpy rules and priced
+    in a single call by the batch kernel, in parallel and without the GIL. The results then have
+    the shape (5, broadcast shape), so that price, delta, gamma, theta, vega = euroBS(...) unpacks them.
     """
     return pyqflib.euroBS(payofftype, spot, strike, timetoexp, intrate, divyield, volatility)
 
@@ -418,6 +430,7 @@ def mktList():
     dictionary
         YieldCurves : list with names of yield curves
         Volatilities : list with names of volatility term structures   
+        McSessions : list with names of Monte Carlo sessions
     """
     return pyqflib.mktList()
 
@@ -432,7 +445,72 @@ def mktClear():
     return pyqflib.mktClear()
 
 
-def ycCreate(ycname, tmats, vals, valtype):
+def mktSave(filename):
+    """Saves all market objects, with their names and versions, to a binary file.
+
+    Parameters
+    ----------
+    filename : str
+        Name of the file; a file being used by mktLoad is not overwritten but replaced.
+
+    Returns
+    -------
+    TRUE
+    """
+    return pyqflib.mktSave(filename)
+
+
+def mktLoad(filename):
+    """Replaces all market objects with the ones saved in a binary file by mktSave.
+
+    The file is memory mapped and the curves use its contents directly, without copying them.
+
+    Parameters
+    ----------
+    filename : str
+        Name of the file.
+
+    Returns
+    -------
+    int
+        The number of market objects loaded.
+    """
+    return pyqflib.mktLoad(filename)
+
+
+def cacheStats():
+    """Counters of the valuation cache.
+
+    The prices from optionBSPDE, optionBSLattice and euroFourier are cached,
+    and served from the cache until the market objects they depend on are replaced.
+
+    Returns
+    -------
+    dictionary
+        Hits : requests served from the cache
+        Misses : requests computed
+        Stale : requests that found prices computed on replaced market objects
+        Invalidations : market object updates acted upon
+        InvalidatedEntries : prices dropped by the invalidations
+        MaxFanout : the most prices dropped by one invalidation
+        Evictions : prices dropped because the cache was full
+        Entries : prices currently cached
+        HitRate : fraction of the requests served from the cache
+    """
+    return pyqflib.cacheStats()
+
+
+def cacheClear():
+    """Clears the valuation cache and its counters.
+
+    Returns
+    -------
+    TRUE
+    """
+    return pyqflib.cacheClear()
+
+
+def ycCreate(ycname, tmats, vals, valtype, interp='FLATFWD'):
     """Creates a new yield curve.
 
     Parameters
@@ -445,6 +523,9 @@ def ycCreate(ycname, tmats, vals, valtype):
         zero bond prices or interest rates to each maturity in `tmats`
     valtype : {0, 1, 2}
         0: zero bond prices, 1: spot interest rates, 2: forward interest rates
+    interp : {'FLATFWD', 'MONOTONECONVEX', 'HERMITE'}, optional
+        interpolation of the forward rates between maturities: piecewise constant,
+        monotone convex (Hagan-West), or quadratic from a monotone Hermite spline of the log discount factors
 
     Returns
     -------
@@ -456,7 +537,7 @@ def ycCreate(ycname, tmats, vals, valtype):
     1. Yield curve names are case insensitive.
     2. A new yield curve replaces an existing one if they have the same name.
     """
-    return pyqflib.ycCreate(ycname, tmats, vals, valtype)
+    return pyqflib.ycCreate(ycname, tmats, vals, valtype, interp)
 
 
 def discount(ycname, tmat):
@@ -466,13 +547,18 @@ def discount(ycname, tmat):
     ----------
     ycname : str
         name of the yield curve
-    tmat : double
+    tmat : double or array_like
         time to maturity of the discount factor, in years
 
     Returns
     -------
-    double
-        discount factor
+    double or numpy array
+        discount factor, with the broadcast shape of the maturities if any is an array
+
+    Notes
+    -----
+    Arrays of maturities are broadcast against each other with the numpy rules and evaluated
+    in a single call, which releases the GIL.
     """
     return pyqflib.discount(ycname, tmat)
 
@@ -484,15 +570,20 @@ def fwdDiscount(ycname, tmat1, tmat2):
     ----------
     ycname : str
         name of the yield curve
-    tmat1 : double
+    tmat1 : double or array_like
         time to reset of the forward discount factor, in years
-    tmat2 : double
+    tmat2 : double or array_like
         time to maturity of the forward discount factor, in years
 
     Returns
     -------
-    double
-        forward discount factor
+    double or numpy array
+        forward discount factor, with the broadcast shape of the maturities if any is an array
+
+    Notes
+    -----
+    Arrays of maturities are broadcast against each other with the numpy rules and evaluated
+    in a single call, which releases the GIL.
     """
     return pyqflib.fwdDiscount(ycname, tmat1, tmat2)
 
@@ -504,13 +595,18 @@ def spotRate(ycname, tmat):
     ----------
     ycname : str
         name of the yield curve
-    tmat : double
+    tmat : double or array_like
         time to maturity of the interest rate, in years
 
     Returns
     -------
-    double
-        spot interest rate
+    double or numpy array
+        spot interest rate, with the broadcast shape of the maturities if any is an array
+
+    Notes
+    -----
+    Arrays of maturities are broadcast against each other with the numpy rules and evaluated
+    in a single call, which releases the GIL.
     """
     return pyqflib.spotRate(ycname, tmat)
 
@@ -522,20 +618,79 @@ def fwdRate(ycname, tmat1, tmat2):
     ----------
     ycname : str
         name of the yield curve
-    tmat1 : double
+    tmat1 : double or array_like
         time to reset of the forward discount rate, in years
-    tmat2 : double
+    tmat2 : double or array_like
         time to maturity of the forward discount rate, in years
 
     Returns
     -------
-    double
-        the forward discount rate
+    double or numpy array
+        the forward discount rate, with the broadcast shape of the maturities if any is an array
+
+    Notes
+    -----
+    Equal maturities give the instantaneous forward rate.
+    Arrays of maturities are broadcast against each other with the numpy rules and evaluated
+    in a single call, which releases the GIL.
     """
     return pyqflib.fwdRate(ycname, tmat1, tmat2)
 
 
-def volCreate(volname, tmats, vals, valtype):
+def ycBootstrap(ycname, insttypes, tstarts, tmats, rates, freqs):
+    """Bootstraps a new yield curve from deposits, FRAs and par swaps.
+
+    Parameters
+    ----------
+    ycname : str
+        new yield curve name
+    insttypes : list(str)
+        instrument types, one of 'DEPOSIT', 'FRA' or 'SWAP'
+    tstarts : list(double) or 1D numpy array
+        start times of the instruments in years; zero for spot starting instruments
+    tmats : list(double) or 1D numpy array
+        maturities of the instruments in years, which must be distinct
+    rates : list(double) or 1D numpy array
+        quoted rates; simply compounded for deposits and FRAs, par fixed rates for swaps
+    freqs : list(int) or 1D numpy array
+        fixed leg payments per year of the swaps, one of 1, 2, 4, 12 or 52; ignored for deposits and FRAs
+
+    Returns
+    -------
+    str 
+        name of the newly created yield curve
+
+    Notes
+    -----
+    1. The curve has piecewise constant forward rates between the instrument maturities.
+    2. A new yield curve replaces an existing one if they have the same name.
+    """
+    return pyqflib.ycBootstrap(ycname, insttypes, tstarts, tmats, rates, freqs)
+
+
+def swapRate(ycname, tmat1, tmat2, freq):
+    """Forward par swap rate from yield curve.
+
+    Parameters
+    ----------
+    ycname : str
+        name of the yield curve
+    tmat1 : double
+        start time of the swap in years; zero for a spot starting swap
+    tmat2 : double
+        maturity of the swap in years
+    freq : {1, 2, 4, 12, 52}
+        fixed leg payments per year
+
+    Returns
+    -------
+    double
+        the par swap rate
+    """
+    return pyqflib.swapRate(ycname, tmat1, tmat2, freq)
+
+
+def volCreate(volname, tmats, vals, valtype, interp='FLATFWD'):
     """Creates a new volatility term structure.
 
     Parameters
@@ -548,13 +703,16 @@ def volCreate(volname, tmats, vals, valtype):
         volatility values to each maturity in `tmats`
     valtype : {0, 1}
         0: spot volatilities, 1: forward volatilities
+    interp : {'FLATFWD', 'MONOTONECONVEX', 'HERMITE'}, optional
+        interpolation of the forward variances between maturities: piecewise constant,
+        monotone convex (Hagan-West), or quadratic from a monotone Hermite spline of the total variances
 
     Returns
     -------
     str 
         name of the newly created volatility term structure
     """
-    return pyqflib.volCreate(volname, tmats, vals, valtype)
+    return pyqflib.volCreate(volname, tmats, vals, valtype, interp)
 
 
 def spotVol(volname, tmat):
@@ -564,13 +722,18 @@ def spotVol(volname, tmat):
     ----------
     volname : str
         name of the volatility term structure
-    tmat : double
+    tmat : double or array_like
         time to maturity (expiration) of the spot volatility, in years
 
     Returns
     -------
-    double
-        spot volatility
+    double or numpy array
+        spot volatility, with the broadcast shape of the maturities if any is an array
+
+    Notes
+    -----
+    Arrays of maturities are broadcast against each other with the numpy rules and evaluated
+    in a single call, which releases the GIL.
     """
     return pyqflib.spotVol(volname, tmat)
 
@@ -582,15 +745,21 @@ def fwdVol(volname, tmat1, tmat2):
     ----------
     volname : str
         name of the volatility term structure
-    tmat1 : double
+    tmat1 : double or array_like
         time to reset of the forward volatility, in years
-    tmat2 : double
+    tmat2 : double or array_like
         time to maturity (expiration) of the forward volatility, in years
 
     Returns
     -------
-    double
-        forward volatility
+    double or numpy array
+        forward volatility, with the broadcast shape of the maturities if any is an array
+
+    Notes
+    -----
+    Equal maturities give the instantaneous forward volatility.
+    Arrays of maturities are broadcast against each other with the numpy rules and evaluated
+    in a single call, which releases the GIL.
     """
     return pyqflib.fwdVol(volname, tmat1, tmat2)
 
@@ -629,5 +798,301 @@ def euroBSMC(payofftype, strike, timetoexp, spot, discountcrv, divyield, volatil
     dictionary
         Mean : Monte Carlo mean price
         StdErr : Monte Carlo standard error
+        and, if pyqflib is built with QF_MC_PROFILE (cmake -DQF_MC_PROFILE=ON):
+        RngTime, PathTime, ProductTime, StatsTime : seconds spent drawing the normal deviates, building the
+            paths, evaluating the option and accumulating the statistics
+        TotalTime : seconds spent in the simulation
+        PathsPerSec, NormalsPerSec : paths simulated and normal deviates drawn per second
+    """
+    return pyqflib.euroBSMC(payofftype, strike, timetoexp, spot, discountcrv, divyield, volatility, mcparams, npaths)
+
+
+class McFuture:
+    """Handle to a Monte Carlo simulation running on the native thread pool, returned by euroBSMCAsync.
+
+    The simulation runs without the GIL, so that the interpreter and other simulations progress meanwhile.
+    """
+
+    def __init__(self, jobid):
+        self._jobid = jobid
+        self._result = None
+
+    def done(self):
+        """True if the simulation has completed."""
+        return self._result is not None or pyqflib.jobDone(self._jobid)
+
+    def result(self, timeout=None):
+        """Waits for the simulation and returns its results, as euroBSMC.
+
+        Parameters
+        ----------
+        timeout : double, optional
+            maximum wait in seconds; None waits until completion
+
+        Raises
+        ------
+        TimeoutError
+            if the simulation has not completed within the timeout
+        RuntimeError
+            if the simulation failed
+        """
+        if self._result is None:
+            res = pyqflib.jobResult(self._jobid, timeout)
+            if res is None:
+                raise TimeoutError("the simulation has not completed")
+            self._result = res
+        return self._result
+
+    def __del__(self):
+        # drop the results of a simulation that was never collected
+        if self._result is None:
+            try:
+                pyqflib.jobDiscard(self._jobid)
+            except Exception:
+                pass
+
+
+def euroBSMCAsync(payofftype, strike, timetoexp, spot, discountcrv, divyield, volatility, mcparams, npaths):
+    """Starts the Monte Carlo pricing of a European option in the Black-Scholes model on a native thread pool.
+
+    The arguments are the ones of euroBSMC. The curves are looked up when the call is made;
+    the simulation runs on a pool with one thread per core, and the call returns immediately.
+
+    Returns
+    -------
+    McFuture
+        handle whose result() returns the dictionary of euroBSMC
+    """
+    return McFuture(pyqflib.euroBSMCAsync(payofftype, strike, timetoexp, spot, discountcrv, divyield,
+                                          volatility, mcparams, npaths))
+
+
+def mcSessionCreate(name, payofftype, strike, timetoexp, spot, discountcrv, divyield, volatility, mcparams):
+    """Creates a Monte Carlo session pricing a European option in the Black-Scholes model.
+
+    The session keeps the pricer, its random number generator and its precomputed drifts and discount factors
+    across calls to mcSessionSimulate, and accumulates the results of all the paths simulated.
+
+    Parameters
+    ----------
+    name : str
+        session name
+    payofftype, strike, timetoexp, spot, discountcrv, divyield, volatility, mcparams :
+        as for euroBSMC
+
+    Returns
+    -------
+    str
+        name of the newly created session
+
+    Notes
+    -----
+    1. The session uses the curves in the market when it is created.
+    2. A new session replaces an existing one if they have the same name; mktClear removes all sessions.
+    """
+    return pyqflib.mcSessionCreate(name, payofftype, strike, timetoexp, spot, discountcrv, divyield,
+                                   volatility, mcparams)
+
+
+def mcSessionSimulate(name, npaths):
+    """Simulates more paths in a Monte Carlo session.
+
+    The paths continue the random number stream of the previous calls, so that simulating n paths k times
+    gives the same results as simulating k * n paths at once.
+
+    Parameters
+    ----------
+    name : str
+        session name
+    npaths : int
+        number of paths to add
+
+    Returns
+    -------
+    dictionary
+        Mean : the mean PV of all the paths simulated so far
+        StdErr : the standard error of the mean
+        NPaths : the number of paths simulated so far
+    """
+    return pyqflib.mcSessionSimulate(name, npaths)
+
+
+def mcSessionResults(name):
+    """Accumulated results of a Monte Carlo session.
+
+    Parameters
+    ----------
+    name : str
+        session name
+
+    Returns
+    -------
+    dictionary
+        as returned by mcSessionSimulate
+    """
+    return pyqflib.mcSessionResults(name)
+
+
+def mcSessionReset(name):
+    """Clears the accumulated results of a Monte Carlo session; the random number stream continues.
+
+    Parameters
+    ----------
+    name : str
+        session name
+
+    Returns
+    -------
+    TRUE
+    """
+    return pyqflib.mcSessionReset(name)
+
+
+###################
+# function group 4
+
+def euroFourier(payofftype, spot, strikes, timetoexp, discountcrv, divyield, model, method):
+    """Prices of European options on a strip of strikes using Fourier methods.
+
+    Parameters
+    ----------
+    payofftype : {1, -1}
+        1 for call, -1 for put
+    spot : double
+        asset spot price
+    strikes : list(double) or 1D numpy array
+        strike prices
+    timetoexp : double
+        time to expiration in years
+    discountcrv : str
+        discount yield curve name
+    divyield : double    
+        asset dividend yield, p.a. and c.c.
+    model : double, str or dictionary
+        double : constant Black-Scholes volatility
+        str : name of a volatility term structure (Black-Scholes)
+        dictionary : Heston parameters V0, KAPPA, THETA, SIGMA, RHO
+    method : {'COS', 'FFT'}
+        COS: Fourier-cosine expansion, FFT: Carr-Madan fast Fourier transform
+    
+    Returns
+    -------
+    1D numpy array
+        option prices, one per strike
+    """
+    return pyqflib.euroFourier(payofftype, spot, strikes, timetoexp, discountcrv, divyield, model, method)
+
+
+def optionBSPDE(payofftype, exercisetype, strike, timetoexp, spot, discountcrv, divyield, volatility,
+                lowerbarrier, upperbarrier, pdeparams):
+    """Price and Greeks of a vanilla or knock-out option in the Black-Scholes model using finite differences.
+
+    Parameters
+    ----------
+    payofftype : {1, -1}
+        1 for call, -1 for put
+    exercisetype : {'EUROPEAN', 'AMERICAN'}
+        exercise type
+    strike : double
+        strike price
+    timetoexp : double
+        time to expiration in years
+    spot : double
+        asset spot price
+    discountcrv : str
+        discount yield curve name
+    divyield : double    
+        asset dividend yield, p.a. and c.c.
+    volatility : double or str
+        constant volatility, or the name of a volatility term structure
+    lowerbarrier : double
+        continuously monitored lower knock-out barrier, 0 for none
+    upperbarrier : double
+        continuously monitored upper knock-out barrier, 0 for none
+    pdeparams : dictionary
+        NSPACENODES : number of spatial grid nodes (default 401)
+        NTIMESTEPS : number of time steps (default 200)
+        NRANNACHER : number of Rannacher start-up steps (default 2)
+    
+    Returns
+    -------
+    1D numpy array
+        price, delta, gamma, theta
+    """
+    return pyqflib.optionBSPDE(payofftype, exercisetype, strike, timetoexp, spot, discountcrv, divyield, volatility,
+                               lowerbarrier, upperbarrier, pdeparams)
+
+
+def optionBSLattice(payofftype, exercisetype, strike, timetoexp, exertimes, spot, discountcrv, divyield, volatility,
+                    latticeparams):
+    """Price and Greeks of a European, American or Bermudan option in the Black-Scholes model using a tree.
+
+    Parameters
+    ----------
+    payofftype : {1, -1}
+        1 for call, -1 for put
+    exercisetype : {'EUROPEAN', 'AMERICAN', 'BERMUDAN'}
+        exercise type
+    strike : double
+        strike price
+    timetoexp : double
+        time to expiration in years
+    exertimes : list(double) or 1D numpy array
+        early exercise times of a Bermudan option, ignored otherwise
+    spot : double
+        asset spot price
+    discountcrv : str
+        discount yield curve name
+    divyield : double    
+        asset dividend yield, p.a. and c.c.
+    volatility : double or str
+        constant volatility, or the name of a volatility term structure
+    latticeparams : dictionary
+        TREETYPE : 'CRR', 'LEISENREIMER', 'TRINOMIAL' (default 'LEISENREIMER')
+        NSTEPS : number of time steps (default 201)
+    
+    Returns
+    -------
+    1D numpy array
+        price, delta, gamma, theta
+    """
+    return pyqflib.optionBSLattice(payofftype, exercisetype, strike, timetoexp, exertimes, spot, discountcrv, divyield,
+                                   volatility, latticeparams)
+
+
+def scenarioVaR(trades, marketfiles, spotreturns, confidences):
+    """Historical VaR and expected shortfall of a portfolio of options.
+
+    The trades are valued on the current market, then revalued on each scenario,
+    a market saved with mktSave, with the spots moved by the scenario spot return.
+    The scenarios are mapped a block at a time and revalued in parallel.
+
+    Parameters
+    ----------
+    trades : list of dictionaries
+        TYPE : 'EUROPEAN', 'DIGITAL' (closed form) or 'EUROPEANMC' (Monte Carlo)
+        PAYOFF : 1 for call, -1 for put
+        STRIKE : strike
+        TIMETOEXP : time to expiration in years
+        SPOT : spot on the current market
+        DIVYIELD : dividend yield, p.a. and c.c.
+        YIELDCURVE : discount yield curve name
+        VOLATILITY : volatility term structure name
+        QUANTITY : number of options, negative if sold (optional, default 1)
+        NPATHS : number of Monte Carlo paths (optional, default 10000)
+    marketfiles : list of str
+        the market files of the scenarios
+    spotreturns : 1D array or None
+        the relative spot return of each scenario, or None for no spot moves
+    confidences : 1D array
+        the confidence levels, e.g. [0.95, 0.99]
+
+    Returns
+    -------
+    dictionary
+        BaseValues : values of the trades and the portfolio on the current market
+        VaR : 2D array, the VaR of the trades and the portfolio, one row per confidence level
+        ES : 2D array, the expected shortfall, likewise
+        NScenarios : number of scenarios
     """
-    return pyqflib.euroBSMC(payofftype, strike, timetoexp, spot, discountcrv, divyield, volatility, mcparams, npaths)
\ No newline at end of file
+    return pyqflib.scenarioVaR(trades, marketfiles, spotreturns, confidences)
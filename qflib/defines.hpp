@@ -8,20 +8,34 @@
 
 /** version string */
 #ifdef NDEBUG
-#define QF_VERSION_STRING "0.8.0"
+#define QF_VERSION_STRING "0.9.0"
 #else
-#define QF_VERSION_STRING "0.8.0-debug"
+#define QF_VERSION_STRING "0.9.0-debug"
 #endif
 
 /** version numbers */
 #define QF_VERSION_MAJOR 0
-#define QF_VERSION_MINOR 8
+#define QF_VERSION_MINOR 9
 #define QF_VERSION_REVISION 0
 
 /** Macro for namespaces */
 #define BEGIN_NAMESPACE(x)	namespace x {
 #define END_NAMESPACE(x)	}
 
+/** Macro for forcing the inlining of small kernels called from vectorized loops */
+#if defined(_MSC_VER)
+#define QF_FORCEINLINE __forceinline
+#else
+#define QF_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+/** Macro asking the compiler to vectorize the loop that follows (honored when OpenMP is enabled) */
+#if defined(_OPENMP) && !defined(_MSC_VER)
+#define QF_SIMD _Pragma("omp simd")
+#else
+#define QF_SIMD
+#endif
+
 /** Macro for Extern C */
 #define BEGIN_EXTERN_C  extern "C" {
 #define END_EXTERN_C    }
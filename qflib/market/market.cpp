@@ -18,6 +18,8 @@ void Market::clear()
 {
   ycmap_.clear();
   volmap_.clear();
+  mcmap_.clear();
+  valcache_.clear();
 }
 
 // The helper function
@@ -11,17 +11,31 @@
 #include <qflib/sptrmap.hpp>
 #include <qflib/market/yieldcurve.hpp>
 #include <qflib/market/volatilitytermstructure.hpp>
+#include <qflib/market/valuationcache.hpp>
 
 BEGIN_NAMESPACE(qf)
 
+class McSession;
+
+/** The market singleton, holding the named market objects
+    Its maps can be read from pricing threads while another thread publishes new versions;
+    see SPtrMap for the snapshot semantics.
+*/
 class Market
 {
 public:
 
+  /** Immutable views of the yield curve and volatility maps */
+  struct Snapshot
+  {
+    SPtrMap<YieldCurve>::Snapshot yieldCurves;
+    SPtrMap<VolatilityTermStructure>::Snapshot volatilities;
+  };
+
   /** Returns the unique instance */
   static Market& instance();
 
-  /** Clears the market of all objects */
+  /** Clears the market of all objects, the Monte Carlo sessions and the valuation cache */
   void clear();
 
   /** Returns the yield curves map */
@@ -30,6 +44,17 @@ public:
   /** Returns the volatility termstructure map */
   SPtrMap<VolatilityTermStructure>& volatilities() { return volmap_; }
 
+  /** Returns the Monte Carlo sessions map; include qflib/pricers/mcsession.hpp to use the sessions */
+  SPtrMap<McSession>& mcSessions() { return mcmap_; }
+
+  /** Returns the cache of valuation results computed on the market objects */
+  ValuationCache& valuations() { return valcache_; }
+
+  /** Returns snapshots of both maps, without locking
+      Each map is consistent in itself; updates of the two maps are published separately.
+  */
+  Snapshot snapshot() const { return Snapshot{ ycmap_.snapshot(), volmap_.snapshot() }; }
+
 private:
 
   /** allow private default ctor */
@@ -44,6 +69,8 @@ private:
   // state
   SPtrMap<YieldCurve> ycmap_;
   SPtrMap<VolatilityTermStructure> volmap_;
+  SPtrMap<McSession> mcmap_;
+  ValuationCache valcache_;
 };
 
 /** Free function returning the market singleton */
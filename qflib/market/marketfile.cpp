@@ -0,0 +1,290 @@
+/**
+@file  marketfile.cpp
+@brief Implementation of the MarketFile class
+*/
+
+#include <qflib/market/marketfile.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+BEGIN_NAMESPACE(qf)
+
+using namespace std;
+
+namespace {
+
+  const char marketMagic[8] = { 'Q', 'F', 'M', 'A', 'R', 'K', 'E', 'T' };
+  const uint32_t byteOrderMark = 0x01020304;
+
+  // the size of n bytes padded to a multiple of 8
+  inline uint64_t padded(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+  // A file mapped copy-on-write into memory, unmapped on destruction
+  class MappedFile
+  {
+  public:
+    explicit MappedFile(string const& fileName);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = NULL;
+#endif
+  };
+
+#if defined(_WIN32)
+
+  MappedFile::MappedFile(string const& fileName)
+  {
+    file_ = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    QF_ASSERT(file_ != INVALID_HANDLE_VALUE, "MarketFile: cannot open " + fileName);
+    LARGE_INTEGER sz;
+    GetFileSizeEx(file_, &sz);
+    size_ = (size_t) sz.QuadPart;
+    if (size_ > 0) {
+      mapping_ = CreateFileMappingA(file_, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+      if (mapping_ != NULL)
+        data_ = static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_COPY, 0, 0, 0));
+    }
+    if (data_ == nullptr) {
+      if (mapping_ != NULL)
+        CloseHandle(mapping_);
+      CloseHandle(file_);
+      QF_ASSERT(0, "MarketFile: cannot map " + fileName);
+    }
+  }
+
+  MappedFile::~MappedFile()
+  {
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+  }
+
+#else
+
+  MappedFile::MappedFile(string const& fileName)
+  {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    QF_ASSERT(fd >= 0, "MarketFile: cannot open " + fileName);
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      size_ = (size_t) st.st_size;
+      // private writable pages, so that the arrays can be viewed as non-const without touching the file
+      p = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);  // the mapping keeps the file alive
+    QF_ASSERT(p != MAP_FAILED, "MarketFile: cannot map " + fileName);
+    data_ = static_cast<char*>(p);
+  }
+
+  MappedFile::~MappedFile()
+  {
+    ::munmap(data_, size_);
+  }
+
+#endif
+
+} // anonymous namespace
+
+void MarketFile::save(string const& fileName)
+{
+  Market::Snapshot snap = market().snapshot();
+  string tmpName = fileName + ".tmp";
+  ofstream out(tmpName, ios::binary | ios::trunc);
+  QF_ASSERT(out.good(), "MarketFile: cannot open " + tmpName);
+
+  auto writeBytes = [&out](void const* p, uint64_t n) {
+    out.write(static_cast<char const*>(p), (streamsize) n);
+  };
+  auto writeString = [&](string const& s) {
+    static const char zeros[8] = {};
+    writeBytes(s.data(), s.size());
+    writeBytes(zeros, padded(s.size()) - s.size());
+  };
+  auto writeCurve = [&](PiecewisePolynomial const& pp) {
+    writeBytes(pp.breakPoints().memptr(), pp.size() * sizeof(double));
+    writeBytes(pp.coefficients().memptr(), pp.size() * (pp.order() + 1) * sizeof(double));
+  };
+  auto initHeader = [](ObjectType type, unsigned long version, string const& name, string const& ccy,
+                       PiecewisePolynomial const& pp, PiecewisePolynomial const& shifts, uint64_t nCumulatives) {
+    ObjectHeader oh;
+    oh.type = (uint64_t) type;
+    oh.version = version;
+    oh.nameSize = name.size();
+    oh.ccySize = ccy.size();
+    oh.size = pp.size();
+    oh.order = pp.order();
+    oh.shiftSize = shifts.size();
+    oh.shiftOrder = shifts.size() == 0 ? 0 : shifts.order();
+    oh.recordSize = sizeof(ObjectHeader) + padded(oh.nameSize) + padded(oh.ccySize)
+      + sizeof(double) * (oh.size * (oh.order + 2 + nCumulatives) + oh.shiftSize * (oh.shiftOrder + 2));
+    return oh;
+  };
+
+  FileHeader fh;
+  memcpy(fh.magic, marketMagic, sizeof(fh.magic));
+  fh.format = formatVersion;
+  fh.byteOrder = byteOrderMark;
+  fh.fileSize = sizeof(FileHeader);
+  fh.nObjects = 0;
+  writeBytes(&fh, sizeof(fh));   // rewritten with the sizes at the end
+
+  for (string const& name : snap.yieldCurves.list()) {
+    SPtrYieldCurve spyc = snap.yieldCurves.get(name);
+    if (!spyc)
+      continue;
+    YieldCurve const& yc = *spyc;
+    ObjectHeader oh = initHeader(ObjectType::YIELDCURVE, snap.yieldCurves.version(name), name, yc.ccy_,
+                                 *yc.fwdrates_, yc.fwdshifts_, 1);
+    writeBytes(&oh, sizeof(oh));
+    writeString(name);
+    writeString(yc.ccy_);
+    writeCurve(*yc.fwdrates_);
+    writeBytes(yc.cumfwdrates_->memptr(), oh.size * sizeof(double));
+    if (oh.shiftSize > 0)
+      writeCurve(yc.fwdshifts_);
+    fh.fileSize += oh.recordSize;
+    ++fh.nObjects;
+  }
+
+  for (string const& name : snap.volatilities.list()) {
+    SPtrVolatilityTermStructure spvts = snap.volatilities.get(name);
+    if (!spvts)
+      continue;
+    VolatilityTermStructure const& vts = *spvts;
+    ObjectHeader oh = initHeader(ObjectType::VOLATILITY, snap.volatilities.version(name), name, string(),
+                                 *vts.fwdvars_, vts.fwdvolshifts_, 2);
+    writeBytes(&oh, sizeof(oh));
+    writeString(name);
+    writeCurve(*vts.fwdvars_);
+    writeBytes(vts.cumfwdvars_->memptr(), oh.size * sizeof(double));
+    writeBytes(vts.cumfwdvols_->memptr(), oh.size * sizeof(double));
+    if (oh.shiftSize > 0)
+      writeCurve(vts.fwdvolshifts_);
+    fh.fileSize += oh.recordSize;
+    ++fh.nObjects;
+  }
+
+  out.seekp(0);
+  writeBytes(&fh, sizeof(fh));
+  out.close();
+  QF_ASSERT(!out.fail(), "MarketFile: error writing " + tmpName);
+
+  // a file mapped by a running process keeps its old contents
+  error_code ec;
+  filesystem::rename(tmpName, fileName, ec);
+  QF_ASSERT(!ec, "MarketFile: cannot rename " + tmpName + " to " + fileName + ": " + ec.message());
+}
+
+size_t MarketFile::load(string const& fileName)
+{
+  Contents contents = read(fileName);
+  market().yieldCurves().assign(contents.yieldCurves.begin(), contents.yieldCurves.end());
+  market().volatilities().assign(contents.volatilities.begin(), contents.volatilities.end());
+  return contents.yieldCurves.size() + contents.volatilities.size();
+}
+
+MarketFile::Contents MarketFile::read(string const& fileName)
+{
+  auto file = make_shared<MappedFile>(fileName);
+  char* base = file->data();
+  uint64_t len = file->size();
+
+  QF_ASSERT(len >= sizeof(FileHeader), "MarketFile: " + fileName + " is not a market file");
+  FileHeader const* fh = reinterpret_cast<FileHeader const*>(base);
+  QF_ASSERT(memcmp(fh->magic, marketMagic, sizeof(marketMagic)) == 0,
+            "MarketFile: " + fileName + " is not a market file");
+  QF_ASSERT(fh->byteOrder == byteOrderMark, "MarketFile: " + fileName + " was written with another byte order");
+  QF_ASSERT(fh->format == formatVersion,
+            "MarketFile: " + fileName + " has format version " + to_string(fh->format)
+            + ", expected " + to_string(formatVersion));
+  QF_ASSERT(fh->fileSize == len, "MarketFile: " + fileName + " is truncated");
+
+  // the objects share the mapping, which is released with the last of them
+  auto viewCurve = [&file](double* x, uint64_t n, double* c, uint64_t order) {
+    return shared_ptr<PiecewisePolynomial>(new PiecewisePolynomial(x, n, c, order),
+                                           [file](PiecewisePolynomial* p) { delete p; });
+  };
+  auto viewVector = [&file](double* x, uint64_t n) {
+    return shared_ptr<Vector>(new Vector(x, n, false, true), [file](Vector* p) { delete p; });
+  };
+
+  Contents contents;
+  uint64_t pos = sizeof(FileHeader);
+  for (uint64_t k = 0; k < fh->nObjects; ++k) {
+    QF_ASSERT(len - pos >= sizeof(ObjectHeader), "MarketFile: " + fileName + " is corrupted");
+    ObjectHeader const* oh = reinterpret_cast<ObjectHeader const*>(base + pos);
+    ObjectType type = (ObjectType) oh->type;
+    QF_ASSERT(type == ObjectType::YIELDCURVE || type == ObjectType::VOLATILITY,
+              "MarketFile: " + fileName + " is corrupted");
+    // check the sizes one by one, so that the record size cannot overflow
+    uint64_t nCumulatives = type == ObjectType::YIELDCURVE ? 1 : 2;
+    uint64_t maxCount = len / sizeof(double);
+    QF_ASSERT(oh->nameSize < len && oh->ccySize < len && oh->size > 0 && oh->size < maxCount
+              && oh->order < 64 && oh->shiftSize < maxCount && oh->shiftOrder < 64
+              && oh->recordSize <= len - pos
+              && oh->recordSize == sizeof(ObjectHeader) + padded(oh->nameSize) + padded(oh->ccySize)
+                 + sizeof(double) * (oh->size * (oh->order + 2 + nCumulatives) + oh->shiftSize * (oh->shiftOrder + 2)),
+              "MarketFile: " + fileName + " is corrupted");
+
+    char* p = base + pos + sizeof(ObjectHeader);
+    string name(p, oh->nameSize);
+    p += padded(oh->nameSize);
+    string ccy(p, oh->ccySize);
+    p += padded(oh->ccySize);
+    double* x = reinterpret_cast<double*>(p);
+    double* c = x + oh->size;
+    double* cum = c + oh->size * (oh->order + 1);
+    double* sx = cum + oh->size * nCumulatives;
+    double* sc = sx + oh->shiftSize;
+    // the shifts are small and owned by the object
+    PiecewisePolynomial shifts;
+    if (oh->shiftSize > 0)
+      shifts = PiecewisePolynomial(sx, oh->shiftSize, sc, oh->shiftOrder);
+
+    if (type == ObjectType::YIELDCURVE) {
+      SPtrYieldCurve spyc(new YieldCurve(ccy, viewCurve(x, oh->size, c, oh->order),
+                                         viewVector(cum, oh->size), shifts));
+      contents.yieldCurves.push_back(make_pair(name, make_pair(spyc, (unsigned long) oh->version)));
+    }
+    else {
+      SPtrVolatilityTermStructure spvts(new VolatilityTermStructure(viewCurve(x, oh->size, c, oh->order),
+                                                                    viewVector(cum, oh->size),
+                                                                    viewVector(cum + oh->size, oh->size), shifts));
+      contents.volatilities.push_back(make_pair(name, make_pair(spvts, (unsigned long) oh->version)));
+    }
+    pos += oh->recordSize;
+  }
+  QF_ASSERT(pos == len, "MarketFile: " + fileName + " is corrupted");
+  return contents;
+}
+
+END_NAMESPACE(qf)
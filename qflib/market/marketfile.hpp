@@ -0,0 +1,87 @@
+/**
+@file  marketfile.hpp
+@brief Saving and loading the market objects in a binary file that is memory mapped
+*/
+
+#ifndef QF_MARKETFILE_HPP
+#define QF_MARKETFILE_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/market/market.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** The binary market file.
+    It holds the yield curves and volatility term structures of the market with their names and versions,
+    as the breakpoint, coefficient and cumulative integral arrays the curves are built from.
+    Loading maps the file into memory and the restored curves use the mapped arrays directly,
+    without parsing or copying them, so that the cost of loading does not depend on the size of the curves.
+    The file is mapped copy-on-write and stays mapped as long as any of its curves is alive.
+
+    The layout is a FileHeader followed by one record per object: an ObjectHeader, the name and currency
+    padded to 8 bytes, then the arrays of doubles. The file is in the byte order of the machine that wrote it,
+    and a file with a different byte order or format version is rejected.
+*/
+class MarketFile
+{
+public:
+  /** The current format version */
+  static const unsigned formatVersion = 1;
+
+  /** The objects in a file, with their names and versions */
+  struct Contents
+  {
+    std::vector<std::pair<std::string, SPtrMap<YieldCurve>::pair_type>> yieldCurves;
+    std::vector<std::pair<std::string, SPtrMap<VolatilityTermStructure>::pair_type>> volatilities;
+  };
+
+  /** Writes all the objects of the market to the file, from a single snapshot
+      The file is written under a temporary name and renamed, so that a file in use is never overwritten.
+  */
+  static void save(std::string const& fileName);
+
+  /** Replaces all the objects of the market with the ones in the file, publishing them at once with
+      their saved versions; returns the number of objects loaded
+  */
+  static size_t load(std::string const& fileName);
+
+  /** Maps the file and returns its objects without publishing them, e.g. to value a scenario
+      The file stays mapped as long as any of the objects is alive.
+  */
+  static Contents read(std::string const& fileName);
+
+private:
+  // the type of the objects
+  enum class ObjectType : uint64_t { YIELDCURVE = 1, VOLATILITY = 2 };
+
+  struct FileHeader
+  {
+    char magic[8];          // "QFMARKET"
+    uint32_t format;        // formatVersion
+    uint32_t byteOrder;     // 0x01020304 written in the byte order of the machine
+    uint64_t fileSize;      // the size of the whole file in bytes
+    uint64_t nObjects;      // the number of object records
+  };
+
+  struct ObjectHeader
+  {
+    uint64_t type;          // ObjectType
+    uint64_t version;       // the version in the market
+    uint64_t nameSize;      // the length of the name
+    uint64_t ccySize;       // the length of the currency, 0 for term structures
+    uint64_t size;          // the number of breakpoints of the curve
+    uint64_t order;         // the order of the curve
+    uint64_t shiftSize;     // the number of breakpoints of the shifts, 0 if not bumped
+    uint64_t shiftOrder;    // the order of the shifts
+    uint64_t recordSize;    // the size of the record in bytes, including this header
+  };
+};
+
+END_NAMESPACE(qf)
+
+#endif // QF_MARKETFILE_HPP
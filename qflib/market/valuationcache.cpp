@@ -0,0 +1,161 @@
+/**
+@file  valuationcache.cpp
+@brief Implementation of the ValuationCache class
+*/
+
+#include <qflib/market/valuationcache.hpp>
+#include <qflib/market/market.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+using namespace std;
+
+namespace {
+
+  // the reverse index key of a market object
+  string dependencyId(MarketDependency::Type type, string const& name)
+  {
+    string nm = trim(name);
+    transform(nm.begin(), nm.end(), nm.begin(), ::toupper);
+    return (type == MarketDependency::Type::YIELDCURVE ? "YC:" : "VOL:") + nm;
+  }
+
+} // anonymous namespace
+
+template<typename P>
+size_t ValuationCache::invalidateIf(string const& id, P isStale)
+{
+  auto dit = dependents_.find(id);
+  if (dit == dependents_.end())
+    return 0;
+  vector<string> keys(dit->second.begin(), dit->second.end());
+  size_t ndropped = 0;
+  for (string const& key : keys) {
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+      continue;
+    for (Dependency const& dep : it->second.deps) {
+      if (dep.id == id && isStale(dep)) {
+        erase(it);
+        ++ndropped;
+        break;
+      }
+    }
+  }
+  if (ndropped > 0) {
+    ++stats_.invalidations;
+    stats_.invalidatedEntries += ndropped;
+    stats_.maxFanout = max(stats_.maxFanout, ndropped);
+  }
+  return ndropped;
+}
+
+bool ValuationCache::lookup(string const& key, Vector& results)
+{
+  Market::Snapshot snap = market().snapshot();
+  lock_guard<mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return false;
+  }
+  auto isCurrent = [&snap](Dependency const& dep) {
+    return dep.type == MarketDependency::Type::YIELDCURVE ?
+      snap.yieldCurves.isCurrent(dep.ychandle) : snap.volatilities.isCurrent(dep.volhandle);
+  };
+  for (Dependency const& dep : it->second.deps) {
+    if (!isCurrent(dep)) {
+      // the object was replaced: drop what was computed on its old versions, keep what was recomputed since
+      ++stats_.stale;
+      ++stats_.misses;
+      invalidateIf(string(dep.id),   // copy, the entry holding dep is erased
+                   [&isCurrent](Dependency const& d) { return !isCurrent(d); });
+      return false;
+    }
+  }
+  ++stats_.hits;
+  results = it->second.results;
+  return true;
+}
+
+vector<ValuationCache::Dependency> ValuationCache::resolve(vector<MarketDependency> const& deps,
+                                                          MarketObjects& objs) const
+{
+  Market::Snapshot snap = market().snapshot();
+  vector<Dependency> resolved;
+  resolved.reserve(deps.size());
+  for (MarketDependency const& dep : deps) {
+    Dependency d;
+    d.id = dependencyId(dep.type, dep.name);
+    d.type = dep.type;
+    if (dep.type == MarketDependency::Type::YIELDCURVE) {
+      d.ychandle = snap.yieldCurves.handle(dep.name);
+      objs.yieldCurves.push_back(snap.yieldCurves.get(d.ychandle));
+      QF_ASSERT(objs.yieldCurves.back(), "ValuationCache: yield curve " + dep.name + " not found");
+    }
+    else {
+      d.volhandle = snap.volatilities.handle(dep.name);
+      objs.volatilities.push_back(snap.volatilities.get(d.volhandle));
+      QF_ASSERT(objs.volatilities.back(), "ValuationCache: vol curve " + dep.name + " not found");
+    }
+    resolved.push_back(move(d));
+  }
+  return resolved;
+}
+
+void ValuationCache::store(string const& key, vector<Dependency> deps, Vector const& results)
+{
+  lock_guard<mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end())
+    erase(it);   // computed concurrently by another thread
+  else if (maxEntries_ > 0 && entries_.size() >= maxEntries_) {
+    erase(entries_.begin());
+    ++stats_.evictions;
+  }
+  for (Dependency const& dep : deps)
+    dependents_[dep.id].insert(key);
+  entries_.emplace(key, Entry{ results, move(deps) });
+}
+
+void ValuationCache::erase(unordered_map<string, Entry>::iterator it)
+{
+  for (Dependency const& dep : it->second.deps) {
+    auto dit = dependents_.find(dep.id);
+    if (dit != dependents_.end()) {
+      dit->second.erase(it->first);
+      if (dit->second.empty())
+        dependents_.erase(dit);
+    }
+  }
+  entries_.erase(it);
+}
+
+size_t ValuationCache::invalidateId(string const& id)
+{
+  return invalidateIf(id, [](Dependency const&) { return true; });
+}
+
+size_t ValuationCache::invalidate(MarketDependency::Type type, string const& name)
+{
+  lock_guard<mutex> lock(mutex_);
+  return invalidateId(dependencyId(type, name));
+}
+
+void ValuationCache::clear()
+{
+  lock_guard<mutex> lock(mutex_);
+  entries_.clear();
+  dependents_.clear();
+  stats_ = Stats();
+}
+
+ValuationCache::Stats ValuationCache::stats() const
+{
+  lock_guard<mutex> lock(mutex_);
+  Stats s = stats_;
+  s.entries = entries_.size();
+  return s;
+}
+
+END_NAMESPACE(qf)
@@ -0,0 +1,189 @@
+/**
+@file  valuationcache.hpp
+@brief A cache of valuation results, invalidated by the versions of the market objects they depend on
+*/
+
+#ifndef QF_VALUATIONCACHE_HPP
+#define QF_VALUATIONCACHE_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/math/matrix.hpp>
+#include <qflib/sptrmap.hpp>
+#include <qflib/market/yieldcurve.hpp>
+#include <qflib/market/volatilitytermstructure.hpp>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** A market object that a valuation depends on */
+struct MarketDependency
+{
+  enum class Type { YIELDCURVE, VOLATILITY };
+
+  Type type;
+  std::string name;
+};
+
+/** The market objects a valuation is computed with, resolved from a single snapshot of the market
+    They are in the order of the dependencies of their type.
+*/
+struct MarketObjects
+{
+  std::vector<SPtrYieldCurve> yieldCurves;
+  std::vector<SPtrVolatilityTermStructure> volatilities;
+};
+
+/** Builds the key of a valuation from the product name and the inputs, which are appended as raw bytes
+    The inputs must be appended in the same order and with the same types for the same product.
+*/
+class ValuationKey
+{
+public:
+  /** Ctor from the product name */
+  explicit ValuationKey(std::string const& product) { *this << product; }
+
+  /** Appends a number */
+  template<typename X, typename = std::enable_if_t<std::is_arithmetic_v<X>>>
+  ValuationKey& operator<<(X x)
+  {
+    key_.append(reinterpret_cast<char const*>(&x), sizeof(X));
+    return *this;
+  }
+
+  /** Appends a string, prefixed by its length */
+  ValuationKey& operator<<(std::string const& s) { *this << s.size(); key_ += s; return *this; }
+
+  /** Appends a vector, prefixed by its length */
+  ValuationKey& operator<<(Vector const& v)
+  {
+    *this << size_t(v.n_elem);
+    key_.append(reinterpret_cast<char const*>(v.memptr()), v.n_elem * sizeof(double));
+    return *this;
+  }
+
+  /** Returns the key */
+  std::string const& str() const { return key_; }
+
+private:
+  std::string key_;
+};
+
+/** The valuation cache.
+    Results are stored under a key describing the product and the pricer parameters, together with
+    handles to the market objects they were computed with. A result is served in O(1) while all
+    those objects are still at the same version. The first request that finds a replaced object
+    drops the results computed on its old versions, using a reverse index from market objects to keys,
+    so that results on other objects, or already recomputed on the new version, stay cached. It is safe to use from several threads;
+    the results are computed outside the lock.
+*/
+class ValuationCache
+{
+public:
+  /** Counters of the cache activity */
+  struct Stats
+  {
+    size_t hits = 0;               // requests served from the cache
+    size_t misses = 0;             // requests computed, including the stale ones
+    size_t stale = 0;              // requests that found a result computed on replaced market objects
+    size_t invalidations = 0;      // market object updates acted upon
+    size_t invalidatedEntries = 0; // results dropped by the invalidations
+    size_t maxFanout = 0;          // the most results dropped by one invalidation
+    size_t evictions = 0;          // results dropped because the cache was full
+    size_t entries = 0;            // results currently cached
+
+    /** Returns the fraction of the requests served from the cache */
+    double hitRate() const { return hits + misses == 0 ? 0.0 : double(hits) / (hits + misses); }
+  };
+
+  /** Ctor with the maximum number of cached results */
+  explicit ValuationCache(size_t maxEntries = 100000) : maxEntries_(maxEntries) {}
+
+  /** Returns the results stored under key if the market objects they depend on are unchanged;
+      otherwise computes them by calling f(objs), which returns a Vector, and stores them.
+      objs are the MarketObjects of the dependencies, taken from the snapshot of the market that the stored
+      handles refer to; f must price with them, rather than with objects fetched from the market beforehand.
+  */
+  template<typename F>
+  Vector get(std::string const& key, std::vector<MarketDependency> const& deps, F f);
+
+  /** Drops the results depending on the market object; returns the number of results dropped */
+  size_t invalidate(MarketDependency::Type type, std::string const& name);
+
+  /** Drops all the results and resets the counters */
+  void clear();
+
+  /** Returns the counters */
+  Stats stats() const;
+
+private:
+  // a dependency as stored in an entry, with the handle to the version used
+  struct Dependency
+  {
+    std::string id;            // the type and processed name, the key of the reverse index
+    MarketDependency::Type type;
+    SPtrMap<YieldCurve>::Handle ychandle;
+    SPtrMap<VolatilityTermStructure>::Handle volhandle;
+  };
+
+  struct Entry
+  {
+    Vector results;
+    std::vector<Dependency> deps;
+  };
+
+  // Looks up the key; returns true and sets results if the entry is current.
+  // A stale entry triggers the invalidation of the entries on old versions of its stale dependency.
+  bool lookup(std::string const& key, Vector& results);
+
+  // Resolves the dependencies to handles to the current market objects, and fetches the objects
+  // from the same snapshot
+  std::vector<Dependency> resolve(std::vector<MarketDependency> const& deps, MarketObjects& objs) const;
+
+  // Stores the results under key
+  void store(std::string const& key, std::vector<Dependency> deps, Vector const& results);
+
+  // Removes an entry and its reverse index records; assumes the lock is held
+  void erase(std::unordered_map<std::string, Entry>::iterator it);
+
+  // Drops the entries depending on the object id; assumes the lock is held
+  size_t invalidateId(std::string const& id);
+
+  // Drops the entries whose dependency on the object id satisfies isStale; assumes the lock is held
+  template<typename P>
+  size_t invalidateIf(std::string const& id, P isStale);
+
+  // state
+  size_t maxEntries_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::unordered_map<std::string, std::unordered_set<std::string>> dependents_;  // object id -> keys
+  Stats stats_;
+  mutable std::mutex mutex_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+template<typename F>
+Vector ValuationCache::get(std::string const& key, std::vector<MarketDependency> const& deps, F f)
+{
+  Vector results;
+  if (lookup(key, results))
+    return results;
+  // the objects come from the snapshot the handles are resolved from, hence the results are stored
+  // under the versions they are computed with, and an update during the computation makes them stale
+  MarketObjects objs;
+  std::vector<Dependency> resolved = resolve(deps, objs);
+  results = f(static_cast<MarketObjects const&>(objs));
+  store(key, std::move(resolved), results);
+  return results;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_VALUATIONCACHE_HPP
@@ -4,6 +4,9 @@
 */
 
 #include <qflib/market/volatilitytermstructure.hpp>
+#include <qflib/math/interpol/hermitespline.hpp>
+#include <qflib/math/interpol/monotoneconvexspline.hpp>
+#include <vector>
 
 BEGIN_NAMESPACE(qf)
 
@@ -12,25 +15,25 @@ using namespace std;
 
 void VolatilityTermStructure::initFromSpotVols()
 {
-  auto cit = fwdvars_.coeff_begin(0);
+  auto cit = fwdvars_->coeff_begin(0);
 
-  double T1 = fwdvars_.breakPoint(0);  // the first maturity
+  double T1 = fwdvars_->breakPoint(0);  // the first maturity
   double V1 = *cit;                    // the first volatility
   double V1square = V1 * V1;
   *cit = V1square;                    // write back the first variance
   // remember, the ppoly object is right continuous
   // the first time break point must be zero, i.e. the first variance is effective from time zero to T1
-  fwdvars_.setBreakPoint(0, 0.0);     
+  fwdvars_->setBreakPoint(0, 0.0);     
   ++cit;
-  for (size_t i = 1; i < fwdvars_.size(); ++i, ++cit) {
-    double T2 = fwdvars_.breakPoint(i);
+  for (size_t i = 1; i < fwdvars_->size(); ++i, ++cit) {
+    double T2 = fwdvars_->breakPoint(i);
     double V2 = *cit;
     double V2square = V2 * V2;
     double fwdvar = V2square * T2 - V1square * T1;
     QF_ASSERT(fwdvar >= 0.0,
       "VolatilityTermStructure: negative variance between T1 = " + to_string(T1) + " and T2 = " + to_string(T2));
     fwdvar /= (T2 - T1);
-    fwdvars_.setBreakPoint(i, T1);  // store the T1 not the T2 breakpoint (right continuous)
+    fwdvars_->setBreakPoint(i, T1);  // store the T1 not the T2 breakpoint (right continuous)
     *cit = fwdvar;                  // store the variance between T1 and T2
     T1 = T2;                        // remember the T2 breakpoint for the next iteration
     V1square = V2square;            // remember the variance up to T2 for the next iteration
@@ -40,11 +43,11 @@ void VolatilityTermStructure::initFromSpotVols()
 void VolatilityTermStructure::initFromFwdVols()
 {
   // just validate the fwd vols
-  auto cit = fwdvars_.coeff_begin(0);
+  auto cit = fwdvars_->coeff_begin(0);
   double T1 = 0.0;
-  for (size_t i = 0; i < fwdvars_.size(); ++i, ++cit) {
-    double T2 = fwdvars_.breakPoints()(i);
-    fwdvars_.setBreakPoint(i, T1);  // store the T1 not the T2 breakpoint (remember ppoly is right continuous)
+  for (size_t i = 0; i < fwdvars_->size(); ++i, ++cit) {
+    double T2 = fwdvars_->breakPoints()(i);
+    fwdvars_->setBreakPoint(i, T1);  // store the T1 not the T2 breakpoint (remember ppoly is right continuous)
     double fwdvol = *cit;
     QF_ASSERT(fwdvol >= 0.0,
       "VolatilityTermStructure: negative volatility between T1 = " + to_string(T1)+" and T2 = " + to_string(T2));
@@ -53,13 +56,126 @@ void VolatilityTermStructure::initFromFwdVols()
   }
 }
 
+void VolatilityTermStructure::initInterpolation(double tMatLast, InterpType interp)
+{
+  // the flat forward curve does not store the last maturity; add it to the nodes
+  size_t n = fwdvars_->size();
+  Vector nodes(n + 1), fwdvars(n);
+  for (size_t i = 0; i < n; ++i) {
+    nodes[i] = fwdvars_->breakPoint(i);
+    fwdvars[i] = fwdvars_->coefficient(0, i);
+  }
+  nodes[n] = tMatLast;
+
+  switch (interp) {
+  case InterpType::MONOTONECONVEX:
+    // the flat forward variances are the averages of the forward variance curve between the maturities
+    fwdvars_ = std::make_shared<MonotoneConvexSpline>(nodes.begin(), nodes.end(), fwdvars.begin(), true);
+    break;
+  case InterpType::HERMITE: {
+    // interpolate the total variances, which are increasing
+    Vector totvars(n + 1);
+    totvars[0] = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      totvars[i + 1] = totvars[i] + fwdvars[i] * (nodes[i + 1] - nodes[i]);
+    HermiteSpline tvs(nodes.begin(), nodes.end(), totvars.begin(), true);
+    // the forward variances are its derivative
+    fwdvars_ = std::make_shared<PiecewisePolynomial>(tvs.firstDerivative());
+    break;
+  }
+  default:
+    QF_ASSERT(0, "VolatilityTermStructure: unknown interpolation type");
+  }
+}
+
+void VolatilityTermStructure::initCumulatives()
+{
+  cumfwdvars_->zeros(fwdvars_->size());
+  cumfwdvols_->zeros(fwdvars_->size());
+  for (size_t i = 1; i < fwdvars_->size(); ++i) {
+    double dt = fwdvars_->breakPoint(i) - fwdvars_->breakPoint(i - 1);
+    (*cumfwdvars_)[i] = (*cumfwdvars_)[i - 1] + fwdvars_->pieceIntegral(i - 1, 0.0, dt);
+    (*cumfwdvols_)[i] = (*cumfwdvols_)[i - 1] + fwdVolPieceIntegral(i - 1, 0.0, dt);
+  }
+}
+
+double VolatilityTermStructure::fwdVolPieceIntegral(size_t i, double h1, double h2) const
+{
+  PiecewisePolynomial const& fv = *fwdvars_;
+  if (fv.order() == 0 || i + 1 == fv.size())
+    return std::sqrt(fv.coefficient(0, i)) * (h2 - h1);
+  // the square root of a quadratic has no simple primitive; 5-point Gauss-Legendre quadrature
+  static const double nodes[] = { 0.0, 0.5384693101056831, 0.9061798459386640 };
+  static const double weights[] = { 0.5688888888888889, 0.4786286704993665, 0.2369268850561891 };
+  double mid = 0.5 * (h1 + h2);
+  double half = 0.5 * (h2 - h1);
+  double val = weights[0] * std::sqrt(std::max(fv.pieceValue(i, mid), 0.0));
+  for (size_t k = 1; k < 3; ++k) {
+    val += weights[k] * std::sqrt(std::max(fv.pieceValue(i, mid - half * nodes[k]), 0.0));
+    val += weights[k] * std::sqrt(std::max(fv.pieceValue(i, mid + half * nodes[k]), 0.0));
+  }
+  return val * half;
+}
+
+double VolatilityTermStructure::fwdVolIntegral(double tMat1, double tMat2) const
+{
+  PiecewisePolynomial const& fv = *fwdvars_;
+  Vector const& cum = *cumfwdvols_;
+  Vector const& x = fv.breakPoints();
+  size_t i1 = fv.index(tMat1);
+  size_t i2 = fv.index(tMat2, i1);
+  if (i1 == i2)  // same interval, avoid the cancellation error
+    return fwdVolPieceIntegral(i1, tMat1 - x[i1], tMat2 - x[i1]);
+  return cum[i2] - cum[i1] + fwdVolPieceIntegral(i2, 0.0, tMat2 - x[i2])
+    - fwdVolPieceIntegral(i1, 0.0, tMat1 - x[i1]);
+}
+
+double VolatilityTermStructure::fwdShiftVarIntegral(double tMat1, double tMat2) const
+{
+  // on each piece of the shifts, the shifted forward variance is (s + d)^2 = s^2 + d * (2 * s + d)
+  Vector const& xs = fwdvolshifts_.breakPoints();
+  size_t ns = xs.size();
+  double val = 0.0;
+  for (size_t j = fwdvolshifts_.index(tMat1); j < ns && xs[j] < tMat2; ++j) {
+    double lo = std::max(tMat1, xs[j]);
+    double hi = j + 1 < ns ? std::min(tMat2, xs[j + 1]) : tMat2;
+    double d = fwdvolshifts_.coefficient(0, j);
+    if (hi > lo && d != 0.0)
+      val += d * (2.0 * fwdVolIntegral(lo, hi) + d * (hi - lo));
+  }
+  return val;
+}
+
+VolatilityTermStructure VolatilityTermStructure::bumped(double shift, double tBegin, double tEnd) const
+{
+  QF_ASSERT(tBegin >= 0.0, "VolatilityTermStructure: bump times must be non-negative");
+  QF_ASSERT(tBegin < tEnd, "VolatilityTermStructure: bump times are out of order");
+
+  // the bucket is a piecewise constant curve starting at zero, like the forward variances
+  vector<double> times{ 0.0 }, shifts;
+  if (tBegin > 0.0) {
+    times.push_back(tBegin);
+    shifts.push_back(0.0);
+  }
+  shifts.push_back(shift);
+  if (tEnd < numeric_limits<double>::infinity()) {
+    times.push_back(tEnd);
+    shifts.push_back(0.0);
+  }
+  PiecewisePolynomial bucket(times.begin(), times.end(), shifts.begin(), 0);
+
+  VolatilityTermStructure vts(*this);  // shares the forward variances and their integrals
+  vts.fwdvolshifts_ = fwdvolshifts_.size() == 0 ? bucket : fwdvolshifts_ + bucket;
+  return vts;
+}
+
 
 double VolatilityTermStructure::spotVol(double tMat) const
 {
   QF_ASSERT(tMat >= 0.0, "spot volatilities for negative times not allowed");
   if (tMat == 0.0)
     tMat = 1.0e-16; // handle division by zero
-  double svar = fwdvars_.integral(0.0, tMat);
+  double svar = fwdVarIntegral(0.0, tMat);
   return std::sqrt(svar / tMat);  // return the annualized volatility
 }
 
@@ -67,9 +183,17 @@ double VolatilityTermStructure::fwdVol(double tMat1, double tMat2) const
 {
   QF_ASSERT(tMat1 >= 0.0, "forward volatilities for negative times not allowed");
   QF_ASSERT(tMat1 <= tMat2, "maturities are out of order");
-  if (tMat1 == tMat2)
-    tMat2 += 1.0e-16; // handle division by zero
-  double fvar = fwdvars_.integral(tMat1, tMat2);
+  if (tMat1 == tMat2) {  // the instantaneous forward vol
+    PiecewisePolynomial const& fv = *fwdvars_;
+    size_t i = fv.index(tMat1);
+    double fvar = fv.pieceValue(i, tMat1 - fv.breakPoints()[i]);
+    if (fwdvolshifts_.size() > 0) {
+      double d = fwdvolshifts_(tMat1);
+      fvar += d * (2.0 * std::sqrt(fvar) + d);
+    }
+    return std::sqrt(fvar);
+  }
+  double fvar = fwdVarIntegral(tMat1, tMat2);
   return std::sqrt(fvar / (tMat2 - tMat1));  // return the annualized volatility
 }
 
@@ -9,37 +9,99 @@
 #include <qflib/defines.hpp>
 #include <qflib/exception.hpp>
 #include <qflib/math/interpol/piecewisepolynomial.hpp>
+#include <limits>
 #include <memory>
 #include <string>
 
 BEGIN_NAMESPACE(qf)
 
+class MarketFile;
+
 /** The volatility term structure */
 class VolatilityTermStructure
 {
 public:
   enum class VolType { SPOTVOL, FWDVOL };
 
+  /** The interpolation of the forward variances between the maturities
+      FLATFWD: piecewise constant forward variances
+      MONOTONECONVEX: the monotone convex forward variance curve of Hagan and West, kept non-negative
+      HERMITE: monotone cubic Hermite interpolation of the total variances, i.e. quadratic forward variances
+      All of them reprice the spot vols at the maturities.
+  */
+  enum class InterpType { FLATFWD, MONOTONECONVEX, HERMITE };
+
   template <typename XITER, typename YITER>
   VolatilityTermStructure(XITER tMatBegin,
                           XITER tMatEnd,
                           YITER volBegin,
                           YITER volEnd,
-                          VolType vtype = VolType::SPOTVOL);
+                          VolType vtype = VolType::SPOTVOL,
+                          InterpType interp = InterpType::FLATFWD);
 
   /** Returns the spot rate at time tMat */
   double spotVol(double tMat) const;
 
-  /** Returns the forward rate between times tMat1 and tMat2 */
+  /** Returns the forward vol between times tMat1 and tMat2, or the instantaneous forward vol if they are equal */
   double fwdVol(double tMat1, double tMat2) const;
 
+  /** Returns the spot vols to each maturity in the sorted range [tMatFirst, tMatLast)
+      The results will be written by advancing volFirst.
+      The maturities and the breakpoints are merged in a single pass.
+  */
+  template<typename TITER, typename VITER>
+  void spotVol(TITER tMatFirst, TITER tMatLast, VITER volFirst) const;
+
+  /** Returns the forward vols between consecutive maturities in the sorted range [tMatFirst, tMatLast)
+      The first vol is between tMatStart and *tMatFirst; equal consecutive maturities give
+      the instantaneous forward vol, as in fwdVol(tMat1, tMat2). The results will be written by advancing volFirst.
+      The maturities and the breakpoints are merged in a single pass.
+  */
+  template<typename TITER, typename VITER>
+  void fwdVol(double tMatStart, TITER tMatFirst, TITER tMatLast, VITER volFirst) const;
+
+  /** Returns a copy of this term structure with the forward vols shifted by shift between tBegin and tEnd
+      The default times give a parallel shift; shifts of a shifted term structure add up.
+      The copy shares the breakpoints, variances and cumulative integrals of this term structure 
+      and stores only the shifts, so that bumping costs O(1) in the number of breakpoints.
+  */
+  VolatilityTermStructure bumped(double shift, double tBegin = 0.0,
+                                 double tEnd = std::numeric_limits<double>::infinity()) const;
+
 protected:
 private:
+  friend class MarketFile;
+
+  // Ctor from the built forward variances and integrals, used to restore a saved term structure
+  VolatilityTermStructure(std::shared_ptr<PiecewisePolynomial> fwdvars, std::shared_ptr<Vector> cumfwdvars,
+                          std::shared_ptr<Vector> cumfwdvols, PiecewisePolynomial const& fwdvolshifts)
+    : fwdvars_(std::move(fwdvars)), cumfwdvars_(std::move(cumfwdvars)), cumfwdvols_(std::move(cumfwdvols)),
+      fwdvolshifts_(fwdvolshifts) {}
+
   // helper functions
   void initFromSpotVols();
   void initFromFwdVols();
+  void initInterpolation(double tMatLast, InterpType interp);
+  void initCumulatives();
+
+  // integral of the forward variances between tMat1 and tMat2, in O(log n)
+  double fwdVarIntegral(double tMat1, double tMat2) const;
+
+  // integral of the unshifted forward vols between tMat1 and tMat2, in O(log n)
+  double fwdVolIntegral(double tMat1, double tMat2) const;
+
+  // integral of the forward vol on the ith piece of the forward variances, between offsets h1 and h2
+  double fwdVolPieceIntegral(size_t i, double h1, double h2) const;
+
+  // the variance added by the forward vol shifts between tMat1 and tMat2
+  double fwdShiftVarIntegral(double tMat1, double tMat2) const;
 
-  PiecewisePolynomial fwdvars_;  // the piecewise constant forward variances
+  // the piecewise polynomial forward variances, the total variances and the integrals of the forward vols 
+  // from 0 to each breakpoint; they are immutable once built, and shared with the bumped copies
+  std::shared_ptr<PiecewisePolynomial> fwdvars_;
+  std::shared_ptr<Vector> cumfwdvars_;
+  std::shared_ptr<Vector> cumfwdvols_;
+  PiecewisePolynomial fwdvolshifts_;  // the piecewise constant forward vol shifts, empty if not bumped
 };
 
 using SPtrVolatilityTermStructure = std::shared_ptr<VolatilityTermStructure>;
@@ -52,8 +114,11 @@ VolatilityTermStructure::VolatilityTermStructure(XITER tMatBegin,
                                                  XITER tMatEnd,
                                                  YITER volBegin,
                                                  YITER volEnd,
-                                                 VolType vtype)
-  : fwdvars_(tMatBegin, tMatEnd, volBegin, 0)
+                                                 VolType vtype,
+                                                 InterpType interp)
+  : fwdvars_(std::make_shared<PiecewisePolynomial>(tMatBegin, tMatEnd, volBegin, 0)),
+    cumfwdvars_(std::make_shared<Vector>()),
+    cumfwdvols_(std::make_shared<Vector>())
 {
   std::ptrdiff_t n = tMatEnd - tMatBegin;
   QF_ASSERT(n == volEnd - volBegin, "VolatilityTermStructure: different number of maturities and vols");
@@ -74,6 +139,96 @@ VolatilityTermStructure::VolatilityTermStructure(XITER tMatBegin,
   default:
     QF_ASSERT(0, "VolatilityTermStructure: unknown volatility input type");
   }
+  if (interp != InterpType::FLATFWD)
+    initInterpolation(*(tMatBegin + (n - 1)), interp);
+  initCumulatives();
+}
+
+inline double VolatilityTermStructure::fwdVarIntegral(double tMat1, double tMat2) const
+{
+  // the first breakpoint is 0.0 and tMat1 >= 0.0, hence both indices are valid
+  PiecewisePolynomial const& fv = *fwdvars_;
+  Vector const& cum = *cumfwdvars_;
+  Vector const& x = fv.breakPoints();
+  size_t i1 = fv.index(tMat1);
+  size_t i2 = fv.index(tMat2, i1);
+  double val;
+  if (i1 == i2)  // same interval, avoid the cancellation error
+    val = fv.pieceIntegral(i1, tMat1 - x[i1], tMat2 - x[i1]);
+  else
+    val = cum[i2] - cum[i1] + fv.pieceIntegral(i2, 0.0, tMat2 - x[i2]) - fv.pieceIntegral(i1, 0.0, tMat1 - x[i1]);
+  if (fwdvolshifts_.size() > 0)
+    val += fwdShiftVarIntegral(tMat1, tMat2);
+  return val;
+}
+
+template <typename TITER, typename VITER>
+void VolatilityTermStructure::spotVol(TITER tMatFirst, TITER tMatLast, VITER volFirst) const
+{
+  PiecewisePolynomial const& fv = *fwdvars_;
+  Vector const& cum = *cumfwdvars_;
+  Vector const& x = fv.breakPoints();
+  size_t n = x.size();
+  size_t i = 0;       // the breakpoint interval of the current maturity
+  double tprev = 0.0;
+  for (; tMatFirst != tMatLast; ++tMatFirst, ++volFirst) {
+    double t = *tMatFirst;
+    QF_ASSERT(t >= tprev, "maturities must be non-negative and sorted");
+    tprev = t;
+    if (t == 0.0)
+      t = 1.0e-16; // handle division by zero
+    while (i + 1 < n && x[i + 1] <= t)
+      ++i;
+    double svar = cum[i] + fv.pieceIntegral(i, 0.0, t - x[i]);
+    if (fwdvolshifts_.size() > 0)
+      svar += fwdShiftVarIntegral(0.0, t);
+    *volFirst = std::sqrt(svar / t);
+  }
+}
+
+template <typename TITER, typename VITER>
+void VolatilityTermStructure::fwdVol(double tMatStart, TITER tMatFirst, TITER tMatLast, VITER volFirst) const
+{
+  QF_ASSERT(tMatStart >= 0.0, "forward volatilities for negative times not allowed");
+  PiecewisePolynomial const& fv = *fwdvars_;
+  Vector const& cum = *cumfwdvars_;
+  Vector const& x = fv.breakPoints();
+  size_t n = x.size();
+  // locate the start once, then advance with the maturities
+  size_t i1 = fv.index(tMatStart);
+  double t1 = tMatStart;
+  double int1 = cum[i1] + fv.pieceIntegral(i1, 0.0, t1 - x[i1]);
+  for (; tMatFirst != tMatLast; ++tMatFirst, ++volFirst) {
+    double t2 = *tMatFirst;
+    QF_ASSERT(t2 >= t1, "maturities are out of order");
+    size_t i2 = i1;
+    while (i2 + 1 < n && x[i2 + 1] <= t2)
+      ++i2;
+    double h2 = t2 - x[i2];
+    double v2 = fv.pieceValue(i2, h2);
+    double int2 = cum[i2] + fv.pieceIntegral(i2, 0.0, h2);
+    // within one interval integrate the piece directly, avoiding the cancellation error
+    double fvar;
+    if (t2 == t1)
+      fvar = v2;
+    else if (i1 == i2)
+      fvar = fv.pieceIntegral(i2, t1 - x[i2], h2) / (t2 - t1);
+    else
+      fvar = (int2 - int1) / (t2 - t1);
+    if (fwdvolshifts_.size() > 0) {
+      if (t2 > t1) {
+        fvar += fwdShiftVarIntegral(t1, t2) / (t2 - t1);
+      }
+      else {
+        double d = fwdvolshifts_(t1);
+        fvar += d * (2.0 * std::sqrt(v2) + d);
+      }
+    }
+    *volFirst = std::sqrt(fvar);
+    i1 = i2;
+    t1 = t2;
+    int1 = int2;
+  }
 }
 
 END_NAMESPACE(qf)
@@ -4,6 +4,9 @@
 */
 
 #include <qflib/market/yieldcurve.hpp>
+#include <qflib/math/interpol/hermitespline.hpp>
+#include <qflib/math/interpol/monotoneconvexspline.hpp>
+#include <vector>
 
 BEGIN_NAMESPACE(qf)
 
@@ -11,12 +14,12 @@ using namespace std;
 
 void YieldCurve::initFromZeroBonds()
 {
-  auto cit = fwdrates_.coeff_begin(0);
+  auto cit = fwdrates_->coeff_begin(0);
 
   double T1 = 0.0;                  // the observation time is t = 0;
   double p1 = 1.0;                  // bond maturing at T1
-  for (size_t i = 0; i < fwdrates_.size(); ++i, ++cit) {
-    double T2 = fwdrates_.breakPoint(i);
+  for (size_t i = 0; i < fwdrates_->size(); ++i, ++cit) {
+    double T2 = fwdrates_->breakPoint(i);
     double p2 = *cit;
     QF_ASSERT(p2 <= 1.0 && p2 > 0, "YieldCurve: zero bond prices must in (0,1]");
     double fwdrate = std::log(p1 / p2);
@@ -24,7 +27,7 @@ void YieldCurve::initFromZeroBonds()
       "YieldCurve: negative fwd rate between T1 = " + to_string(T1) + " and T2 = " + to_string(T2));
     double dt = T2 - T1;          // calculate DeltaT for the next iteration
     fwdrate /= dt;
-    fwdrates_.setBreakPoint(i, T1); // remember, the ppoly object is right-continuous 
+    fwdrates_->setBreakPoint(i, T1); // remember, the ppoly object is right-continuous 
     *cit = fwdrate;                 // overwrite the zero bond with the fwd rate
     p1 = p2;                        // remember the bond price
     T1 = T2;                        // remember the maturity
@@ -33,20 +36,20 @@ void YieldCurve::initFromZeroBonds()
 
 void YieldCurve::initFromSpotRates()
 {
-  auto cit = fwdrates_.coeff_begin(0);
+  auto cit = fwdrates_->coeff_begin(0);
 
-  double T1 = fwdrates_.breakPoint(0);
+  double T1 = fwdrates_->breakPoint(0);
   double R1 = *cit;
-  fwdrates_.setBreakPoint(0, 0.0); // remember, the ppoly object is right-continuous
+  fwdrates_->setBreakPoint(0, 0.0); // remember, the ppoly object is right-continuous
   ++cit;
-  for (size_t i = 1; i < fwdrates_.size(); ++i, ++cit) {
-    double T2 = fwdrates_.breakPoint(i);
+  for (size_t i = 1; i < fwdrates_->size(); ++i, ++cit) {
+    double T2 = fwdrates_->breakPoint(i);
     double R2 = *cit;
     double F = R2 * T2 - R1 * T1;
     QF_ASSERT(F >= 0.0,
       "YieldCurve: negative fwd rate between T1 = " + to_string(T1) +" and T2 = " + to_string(T2));
     F /= (T2 - T1);
-    fwdrates_.setBreakPoint(i, T1);
+    fwdrates_->setBreakPoint(i, T1);
     *cit = F;
     T1 = T2;
     R1 = R2;
@@ -56,11 +59,11 @@ void YieldCurve::initFromSpotRates()
 void YieldCurve::initFromFwdRates()
 {
   // just validate the fwd rates
-  auto cit = fwdrates_.coeff_begin(0);
+  auto cit = fwdrates_->coeff_begin(0);
   double T1 = 0.0;
-  for (size_t i = 0; i < fwdrates_.size(); ++i, ++cit) {
-    double T2 = fwdrates_.breakPoints()(i);
-    fwdrates_.setBreakPoint(i, T1);  // remember, the ppoly object is right-continuous
+  for (size_t i = 0; i < fwdrates_->size(); ++i, ++cit) {
+    double T2 = fwdrates_->breakPoints()(i);
+    fwdrates_->setBreakPoint(i, T1);  // remember, the ppoly object is right-continuous
     double fwdrate = *cit;
     QF_ASSERT(fwdrate >= 0.0,
       "YieldCurve: negative fwd rate between T1 = " + to_string(T1) + " and T2 = " + to_string(T2));
@@ -68,11 +71,74 @@ void YieldCurve::initFromFwdRates()
   }
 }
 
+void YieldCurve::initInterpolation(double tMatLast, InterpType interp)
+{
+  // the flat forward curve does not store the last maturity; add it to the nodes
+  size_t n = fwdrates_->size();
+  Vector nodes(n + 1), fwds(n);
+  for (size_t i = 0; i < n; ++i) {
+    nodes[i] = fwdrates_->breakPoint(i);
+    fwds[i] = fwdrates_->coefficient(0, i);
+  }
+  nodes[n] = tMatLast;
+
+  switch (interp) {
+  case InterpType::MONOTONECONVEX:
+    // the flat forward rates are the averages of the forward curve between the maturities
+    fwdrates_ = std::make_shared<MonotoneConvexSpline>(nodes.begin(), nodes.end(), fwds.begin(), true);
+    break;
+  case InterpType::HERMITE: {
+    // interpolate the log discount factors, which are increasing for non-negative rates
+    Vector logdfs(n + 1);
+    logdfs[0] = 0.0;
+    for (size_t i = 0; i < n; ++i)
+      logdfs[i + 1] = logdfs[i] + fwds[i] * (nodes[i + 1] - nodes[i]);
+    HermiteSpline lds(nodes.begin(), nodes.end(), logdfs.begin(), true);
+    // the forward rates are its derivative
+    fwdrates_ = std::make_shared<PiecewisePolynomial>(lds.firstDerivative());
+    break;
+  }
+  default:
+    QF_ASSERT(0, "YieldCurve: unknown interpolation type");
+  }
+}
+
+void YieldCurve::initCumulatives()
+{
+  cumfwdrates_->zeros(fwdrates_->size());
+  for (size_t i = 1; i < fwdrates_->size(); ++i) {
+    double dt = fwdrates_->breakPoint(i) - fwdrates_->breakPoint(i - 1);
+    (*cumfwdrates_)[i] = (*cumfwdrates_)[i - 1] + fwdrates_->pieceIntegral(i - 1, 0.0, dt);
+  }
+}
+
+YieldCurve YieldCurve::bumped(double shift, double tBegin, double tEnd) const
+{
+  QF_ASSERT(tBegin >= 0.0, "YieldCurve: bump times must be non-negative");
+  QF_ASSERT(tBegin < tEnd, "YieldCurve: bump times are out of order");
+
+  // the bucket is a piecewise constant curve starting at zero, like the forward rates
+  vector<double> times{ 0.0 }, shifts;
+  if (tBegin > 0.0) {
+    times.push_back(tBegin);
+    shifts.push_back(0.0);
+  }
+  shifts.push_back(shift);
+  if (tEnd < numeric_limits<double>::infinity()) {
+    times.push_back(tEnd);
+    shifts.push_back(0.0);
+  }
+  PiecewisePolynomial bucket(times.begin(), times.end(), shifts.begin(), 0);
+
+  YieldCurve yc(*this);  // shares the forward rates and their integrals
+  yc.fwdshifts_ = fwdshifts_.size() == 0 ? bucket : fwdshifts_ + bucket;
+  return yc;
+}
 
 double YieldCurve::discount(double tMat) const
 {
   QF_ASSERT(tMat >= 0.0, "YieldCurve: negative times not allowed");
-  double ldf = -fwdrates_.integral(0.0, tMat);
+  double ldf = -fwdRateIntegral(0.0, tMat);
   return exp(ldf);
 }
 
@@ -80,14 +146,14 @@ double YieldCurve::fwdDiscount(double tMat1, double tMat2) const
 {
   QF_ASSERT(tMat1 >= 0.0, "YieldCurve: discount factors for negative times not allowed");
   QF_ASSERT(tMat1 <= tMat2, "YieldCurve: maturities are out of order");
-  double ldf = -fwdrates_.integral(tMat1, tMat2);
+  double ldf = -fwdRateIntegral(tMat1, tMat2);
   return exp(ldf);
 }
 
 double YieldCurve::spotRate(double tMat) const
 {
   QF_ASSERT(tMat >= 0.0, "YieldCurve: spot rates for negative times not allowed");
-  double srate = fwdrates_.integral(0.0, tMat);
+  double srate = fwdRateIntegral(0.0, tMat);
   return srate / tMat;  // return the annualized rate
 }
 
@@ -95,8 +161,69 @@ double YieldCurve::fwdRate(double tMat1, double tMat2) const
 {
   QF_ASSERT(tMat1 >= 0.0, "YieldCurve: discount factors for negative times not allowed");
   QF_ASSERT(tMat1 <= tMat2, "YieldCurve: maturities are out of order");
-  double frate = fwdrates_.integral(tMat1, tMat2);
+  if (tMat1 == tMat2) {  // the instantaneous forward rate
+    PiecewisePolynomial const& fr = *fwdrates_;
+    size_t i = fr.index(tMat1);
+    double frate = fr.pieceValue(i, tMat1 - fr.breakPoints()[i]);
+    return fwdshifts_.size() > 0 ? frate + fwdshifts_(tMat1) : frate;
+  }
+  double frate = fwdRateIntegral(tMat1, tMat2);
   return frate / (tMat2 - tMat1);  // return the annualized rate
 }
 
+double YieldCurve::swapRate(double tMat, SwapFreq freq) const
+{
+  return fwdSwapRate(0.0, tMat, freq);
+}
+
+double YieldCurve::fwdSwapRate(double tMat1, double tMat2, SwapFreq freq) const
+{
+  QF_ASSERT(tMat1 >= 0.0, "YieldCurve: swap rates for negative times not allowed");
+  QF_ASSERT(tMat1 < tMat2, "YieldCurve: maturities are out of order");
+  Vector paytimes = swapPayTimes(tMat1, tMat2, freq);
+  Vector dfs(paytimes.size());
+  discount(paytimes.begin(), paytimes.end(), dfs.begin());
+
+  // the annuity is the present value of the fixed leg paying 1
+  double annuity = 0.0;
+  double tprev = tMat1;
+  for (size_t i = 0; i < paytimes.size(); ++i) {
+    annuity += (paytimes[i] - tprev) * dfs[i];
+    tprev = paytimes[i];
+  }
+  return (discount(tMat1) - dfs[dfs.size() - 1]) / annuity;
+}
+
+size_t YieldCurve::paymentsPerYear(SwapFreq freq)
+{
+  switch (freq) {
+  case SwapFreq::ANNUAL:
+    return 1;
+  case SwapFreq::SEMIANNUAL:
+    return 2;
+  case SwapFreq::QUARTERLY:
+    return 4;
+  case SwapFreq::MONTHLY:
+    return 12;
+  case SwapFreq::WEEKLY:
+    return 52;
+  default:
+    QF_ASSERT(0, "YieldCurve: unknown swap frequency");
+  }
+  return 0;
+}
+
+Vector YieldCurve::swapPayTimes(double tMat1, double tMat2, SwapFreq freq)
+{
+  QF_ASSERT(tMat1 < tMat2, "YieldCurve: maturities are out of order");
+  double perYear = (double) paymentsPerYear(freq);
+  // a broken period shorter than a few seconds is merged with the next one
+  size_t npay = (size_t) std::ceil((tMat2 - tMat1) * perYear - 1.0e-7);
+  npay = npay > 0 ? npay : 1;
+  Vector paytimes(npay);
+  for (size_t i = 0; i < npay; ++i)
+    paytimes[i] = tMat2 - (npay - 1 - i) / perYear;
+  return paytimes;
+}
+
 END_NAMESPACE(qf)
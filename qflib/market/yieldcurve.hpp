@@ -10,10 +10,14 @@
 #include <qflib/exception.hpp>
 #include <qflib/math/interpol/piecewisepolynomial.hpp>
 #include <qflib/sptr.hpp>
+#include <limits>
+#include <memory>
 #include <string>
 
 BEGIN_NAMESPACE(qf)
 
+class MarketFile;
+
 /** The yield curve */
 class YieldCurve
 {
@@ -37,6 +41,19 @@ public:
     WEEKLY        // 52/year
   };
 
+  /** The interpolation of the forward rates between the maturities
+      FLATFWD: piecewise constant forward rates
+      MONOTONECONVEX: the monotone convex forward curve of Hagan and West, kept non-negative
+      HERMITE: monotone cubic Hermite interpolation of the log discount factors, i.e. quadratic forward rates
+      All of them reprice the discount factors at the maturities.
+  */
+  enum class InterpType
+  {
+    FLATFWD,
+    MONOTONECONVEX,
+    HERMITE
+  };
+
   /** The interest rate compounding frequency */
   enum class RateCmpd
   {
@@ -50,7 +67,8 @@ public:
              XITER tMatEnd,
              YITER rateBegin,
              YITER rateEnd,
-             InputType rtype = InputType::SPOTRATE);
+             InputType rtype = InputType::SPOTRATE,
+             InterpType interp = InterpType::FLATFWD);
 
   /** Returns the curve currency */
   std::string ccy() const { return ccy_; }
@@ -64,28 +82,83 @@ public:
   /** Returns the spot rate at time tMat */
   double spotRate(double tMat) const;
 
-  /** Returns the forward rate between times tMat1 and tMat2 */
+  /** Returns the forward rate between times tMat1 and tMat2, or the instantaneous forward rate if they are equal */
   double fwdRate(double tMat1, double tMat2) const;
 
-  /** Returns the swap rate at time tMat */
-  // TODO Not implemented yet, requires frequency arg
-  // double swapRate(double tMat1) const;
+  /** Returns the discount factors to each maturity in the sorted range [tMatFirst, tMatLast)
+      The results will be written by advancing dfFirst.
+      The maturities and the breakpoints are merged in a single pass.
+  */
+  template<typename TITER, typename DITER>
+  void discount(TITER tMatFirst, TITER tMatLast, DITER dfFirst) const;
+
+  /** Returns the spot rates to each maturity in the sorted range [tMatFirst, tMatLast)
+      The results will be written by advancing rateFirst.
+      The maturities and the breakpoints are merged in a single pass.
+  */
+  template<typename TITER, typename RITER>
+  void spotRate(TITER tMatFirst, TITER tMatLast, RITER rateFirst) const;
+
+  /** Returns the forward rates between consecutive maturities in the sorted range [tMatFirst, tMatLast)
+      The first rate is between tMatStart and *tMatFirst; equal consecutive maturities give
+      the instantaneous forward rate, as in fwdRate(tMat1, tMat2). The results will be written by advancing rateFirst.
+      The maturities and the breakpoints are merged in a single pass.
+  */
+  template<typename TITER, typename RITER>
+  void fwdRate(double tMatStart, TITER tMatFirst, TITER tMatLast, RITER rateFirst) const;
+
+  /** Returns a copy of this curve with the forward rates shifted by shift between tBegin and tEnd
+      The default times give a parallel shift; shifts of a shifted curve add up.
+      The copy shares the breakpoints, rates and cumulative integrals of this curve and stores only the shifts,
+      so that bumping costs O(1) in the number of breakpoints.
+  */
+  YieldCurve bumped(double shift, double tBegin = 0.0,
+                    double tEnd = std::numeric_limits<double>::infinity()) const;
+
+  /** Returns the par swap rate of a swap starting today and maturing at tMat */
+  double swapRate(double tMat, SwapFreq freq = SwapFreq::ANNUAL) const;
 
-  /** Returns the forward swap rate times tMat1 and tMat2 */
-  // TODO NOt implemented yet, requires frequency arg
-  // double fwdSwapRate(double tMat1, double tMat2) const;
+  /** Returns the forward par swap rate of a swap starting at tMat1 and maturing at tMat2 */
+  double fwdSwapRate(double tMat1, double tMat2, SwapFreq freq = SwapFreq::ANNUAL) const;
+
+  /** Returns the number of payments per year of the swap frequency */
+  static size_t paymentsPerYear(SwapFreq freq);
+
+  /** Returns the fixed leg payment times of a swap starting at tMat1 and maturing at tMat2
+      The times roll back from tMat2, so that a broken period is the first one.
+  */
+  static Vector swapPayTimes(double tMat1, double tMat2, SwapFreq freq);
 
 
 protected:
 
 private:
+  friend class MarketFile;
+
+  // Ctor from the built forward rates and integrals, used to restore a saved curve
+  YieldCurve(std::string const& ccy, std::shared_ptr<PiecewisePolynomial> fwdrates,
+             std::shared_ptr<Vector> cumfwdrates, PiecewisePolynomial const& fwdshifts)
+    : ccy_(ccy), fwdrates_(std::move(fwdrates)), cumfwdrates_(std::move(cumfwdrates)), fwdshifts_(fwdshifts) {}
+
   // helper functions
   void initFromZeroBonds();
   void initFromSpotRates();
   void initFromFwdRates();
+  void initInterpolation(double tMatLast, InterpType interp);
+  void initCumulatives();
+
+  // integral of the forward rates between tMat1 and tMat2, in O(log n)
+  double fwdRateIntegral(double tMat1, double tMat2) const;
+
+  // integral of the forward rate shifts between tMat1 and tMat2
+  double fwdShiftIntegral(double tMat1, double tMat2) const;
 
   std::string ccy_;  // the curve's currency
-  PiecewisePolynomial fwdrates_;  // the piecewise constant forward rates
+  // the piecewise polynomial forward rates and their integrals from 0 to each breakpoint;
+  // they are immutable once built, and shared with the bumped copies of the curve
+  std::shared_ptr<PiecewisePolynomial> fwdrates_;
+  std::shared_ptr<Vector> cumfwdrates_;
+  PiecewisePolynomial fwdshifts_;  // the piecewise constant forward rate shifts, empty if not bumped
 };
 
 using SPtrYieldCurve = std::shared_ptr<YieldCurve>;
@@ -98,8 +171,11 @@ YieldCurve::YieldCurve(XITER tMatBegin,
                        XITER tMatEnd,
                        YITER rateBegin,
                        YITER rateEnd,
-                       InputType intype)
-: ccy_("USD"), fwdrates_(tMatBegin, tMatEnd, rateBegin, 0)
+                       InputType intype,
+                       InterpType interp)
+: ccy_("USD"), 
+  fwdrates_(std::make_shared<PiecewisePolynomial>(tMatBegin, tMatEnd, rateBegin, 0)),
+  cumfwdrates_(std::make_shared<Vector>())
 {
   std::ptrdiff_t n = tMatEnd - tMatBegin;
   QF_ASSERT(n == rateEnd - rateBegin, "YieldCurve: different number of maturities and rates");
@@ -119,6 +195,103 @@ YieldCurve::YieldCurve(XITER tMatBegin,
   default:
     QF_ASSERT(0, "error: unknown yield curve input type");
   }
+  if (interp != InterpType::FLATFWD)
+    initInterpolation(*(tMatBegin + (n - 1)), interp);
+  initCumulatives();
+}
+
+inline double YieldCurve::fwdShiftIntegral(double tMat1, double tMat2) const
+{
+  return fwdshifts_.size() == 0 ? 0.0 : fwdshifts_.integral(tMat1, tMat2);
+}
+
+inline double YieldCurve::fwdRateIntegral(double tMat1, double tMat2) const
+{
+  // the first breakpoint is 0.0 and tMat1 >= 0.0, hence both indices are valid
+  PiecewisePolynomial const& fr = *fwdrates_;
+  Vector const& cum = *cumfwdrates_;
+  Vector const& x = fr.breakPoints();
+  size_t i1 = fr.index(tMat1);
+  size_t i2 = fr.index(tMat2, i1);
+  if (i1 == i2)  // same interval, avoid the cancellation error
+    return fr.pieceIntegral(i1, tMat1 - x[i1], tMat2 - x[i1]) + fwdShiftIntegral(tMat1, tMat2);
+  return cum[i2] - cum[i1] + fr.pieceIntegral(i2, 0.0, tMat2 - x[i2]) - fr.pieceIntegral(i1, 0.0, tMat1 - x[i1])
+    + fwdShiftIntegral(tMat1, tMat2);
+}
+
+template<typename TITER, typename DITER>
+void YieldCurve::discount(TITER tMatFirst, TITER tMatLast, DITER dfFirst) const
+{
+  PiecewisePolynomial const& fr = *fwdrates_;
+  Vector const& cum = *cumfwdrates_;
+  Vector const& x = fr.breakPoints();
+  size_t n = x.size();
+  size_t i = 0;       // the breakpoint interval of the current maturity
+  double tprev = 0.0;
+  for (; tMatFirst != tMatLast; ++tMatFirst, ++dfFirst) {
+    double t = *tMatFirst;
+    QF_ASSERT(t >= tprev, "YieldCurve: maturities must be non-negative and sorted");
+    while (i + 1 < n && x[i + 1] <= t)
+      ++i;
+    double ldf = cum[i] + fr.pieceIntegral(i, 0.0, t - x[i]) + fwdShiftIntegral(0.0, t);
+    *dfFirst = std::exp(-ldf);
+    tprev = t;
+  }
+}
+
+template<typename TITER, typename RITER>
+void YieldCurve::spotRate(TITER tMatFirst, TITER tMatLast, RITER rateFirst) const
+{
+  PiecewisePolynomial const& fr = *fwdrates_;
+  Vector const& cum = *cumfwdrates_;
+  Vector const& x = fr.breakPoints();
+  size_t n = x.size();
+  size_t i = 0;       // the breakpoint interval of the current maturity
+  double tprev = 0.0;
+  for (; tMatFirst != tMatLast; ++tMatFirst, ++rateFirst) {
+    double t = *tMatFirst;
+    QF_ASSERT(t >= tprev, "YieldCurve: maturities must be non-negative and sorted");
+    while (i + 1 < n && x[i + 1] <= t)
+      ++i;
+    double srate = cum[i] + fr.pieceIntegral(i, 0.0, t - x[i]) + fwdShiftIntegral(0.0, t);
+    *rateFirst = srate / t;
+    tprev = t;
+  }
+}
+
+template<typename TITER, typename RITER>
+void YieldCurve::fwdRate(double tMatStart, TITER tMatFirst, TITER tMatLast, RITER rateFirst) const
+{
+  QF_ASSERT(tMatStart >= 0.0, "YieldCurve: forward rates for negative times not allowed");
+  PiecewisePolynomial const& fr = *fwdrates_;
+  Vector const& cum = *cumfwdrates_;
+  Vector const& x = fr.breakPoints();
+  size_t n = x.size();
+  // locate the start once, then advance with the maturities
+  size_t i1 = fr.index(tMatStart);
+  double t1 = tMatStart;
+  double int1 = cum[i1] + fr.pieceIntegral(i1, 0.0, t1 - x[i1]);
+  for (; tMatFirst != tMatLast; ++tMatFirst, ++rateFirst) {
+    double t2 = *tMatFirst;
+    QF_ASSERT(t2 >= t1, "YieldCurve: maturities are out of order");
+    size_t i2 = i1;
+    while (i2 + 1 < n && x[i2 + 1] <= t2)
+      ++i2;
+    double h2 = t2 - x[i2];
+    double int2 = cum[i2] + fr.pieceIntegral(i2, 0.0, h2);
+    // within one interval integrate the piece directly, avoiding the cancellation error
+    if (t2 == t1)
+      *rateFirst = fr.pieceValue(i2, h2);
+    else if (i1 == i2)
+      *rateFirst = fr.pieceIntegral(i2, t1 - x[i2], h2) / (t2 - t1);
+    else
+      *rateFirst = (int2 - int1) / (t2 - t1);
+    if (fwdshifts_.size() > 0)
+      *rateFirst += t2 > t1 ? fwdshifts_.integral(t1, t2) / (t2 - t1) : fwdshifts_(t1);
+    i1 = i2;
+    t1 = t2;
+    int1 = int2;
+  }
 }
 
 END_NAMESPACE(qf)
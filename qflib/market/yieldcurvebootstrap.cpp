@@ -0,0 +1,181 @@
+/**
+@file  yieldcurvebootstrap.cpp
+@brief Implementation of the yield curve bootstrapping
+*/
+
+#include <qflib/market/yieldcurvebootstrap.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BEGIN_NAMESPACE(qf)
+
+using namespace std;
+
+namespace {
+
+  const size_t MAXITER = 50;        // maximum number of Newton iterations for a swap
+  const double TOLERANCE = 4.0 * numeric_limits<double>::epsilon(); // relative tolerance on the forward rate
+  const double NOISESTEP = 1.0e-10; // steps below this size that stop shrinking are round-off in g
+  const double MAXSTEP = 1.0;       // maximum change of the forward rate in one Newton iteration
+
+  // The curve bootstrapped so far: breakpoints T_0 = 0 < T_1 < ... < T_k,
+  // the forward rates f_i on (T_{i-1}, T_i] and the integrals I_i of the forward rates from 0 to T_i
+  class PartialCurve
+  {
+  public:
+    PartialCurve() : nodes_{ 0.0 }, cumints_{ 0.0 } {}
+
+    double lastNode() const { return nodes_.back(); }
+
+    // The integral of the forward rates from 0 to t is a + b * f, where f is the rate after the last node
+    void integral(double t, double& a, double& b) const
+    {
+      double tlast = nodes_.back();
+      if (t >= tlast) {
+        a = cumints_.back();
+        b = t - tlast;
+      }
+      else {
+        size_t i = upper_bound(nodes_.begin(), nodes_.end(), t) - nodes_.begin() - 1;
+        a = cumints_[i] + fwdrates_[i] * (t - nodes_[i]);
+        b = 0.0;
+      }
+    }
+
+    // Appends the node tMat, with forward rate fwdrate from the last node
+    void addNode(double tMat, double fwdrate)
+    {
+      cumints_.push_back(cumints_.back() + fwdrate * (tMat - nodes_.back()));
+      nodes_.push_back(tMat);
+      fwdrates_.push_back(fwdrate);
+    }
+
+    vector<double> const& nodes() const { return nodes_; }
+    vector<double> const& fwdRates() const { return fwdrates_; }
+
+  private:
+    vector<double> nodes_;
+    vector<double> cumints_;
+    vector<double> fwdrates_;
+  };
+
+  // The forward rate reproducing a deposit or FRA quote, in closed form
+  double solveDeposit(PartialCurve const& curve, RateInstrument const& inst)
+  {
+    double tau = inst.tMat - inst.tStart;
+    double target = inst.cmpd == YieldCurve::RateCmpd::SIMPLE ? log(1.0 + inst.rate * tau) : inst.rate * tau;
+    double a1, b1, a2, b2;
+    curve.integral(inst.tStart, a1, b1);
+    curve.integral(inst.tMat, a2, b2);
+    return (target - (a2 - a1)) / (b2 - b1);
+  }
+
+  // The forward rate reproducing a par swap quote, with Newton iterations on
+  // g(f) = P(t0) - P(tN) - rate * sum_i delta_i P(t_i), where P(t) = exp(-a(t) - b(t) f)
+  double solveSwap(PartialCurve const& curve, RateInstrument const& inst, double guess)
+  {
+    Vector paytimes = YieldCurve::swapPayTimes(inst.tStart, inst.tMat, inst.freq);
+    size_t npay = paytimes.size();
+
+    // coupons paid up to the last node have known discount factors; sum them once
+    double a0, b0;
+    curve.integral(inst.tStart, a0, b0);
+    double knownAnnuity = 0.0;
+    vector<double> deltas, as, bs;   // the coupons depending on f
+    double tprev = inst.tStart;
+    for (size_t i = 0; i < npay; ++i) {
+      double a, b;
+      curve.integral(paytimes[i], a, b);
+      double delta = paytimes[i] - tprev;
+      if (b == 0.0) {
+        knownAnnuity += delta * exp(-a);
+      }
+      else {
+        deltas.push_back(delta);
+        as.push_back(a);
+        bs.push_back(b);
+      }
+      tprev = paytimes[i];
+    }
+
+    // g increases with f towards P(t0) - rate * knownAnnuity, which must be positive for a solution
+    QF_ASSERT(b0 > 0.0 || exp(-a0) - inst.rate * knownAnnuity > 0.0,
+      "bootstrapYieldCurve: no forward rate reprices the swap maturing at " + to_string(inst.tMat));
+
+    double f = guess;
+    double dfprev = numeric_limits<double>::infinity();
+    for (size_t iter = 0; iter < MAXITER; ++iter) {
+      double p0 = exp(-a0 - b0 * f);
+      double g = p0 - inst.rate * knownAnnuity;
+      double dg = -b0 * p0;
+      for (size_t i = 0; i < deltas.size(); ++i) {
+        double p = exp(-as[i] - bs[i] * f);
+        g -= inst.rate * deltas[i] * p;
+        dg += inst.rate * deltas[i] * bs[i] * p;
+      }
+      // the floating leg pays 1 at maturity, which is the last coupon
+      double pn = exp(-as.back() - bs.back() * f);
+      g -= pn;
+      dg += bs.back() * pn;
+
+      // the round-off in g, divided by dg, limits the accuracy of f; once the steps are that small
+      // they stop shrinking, and f is as accurate as the swap value allows
+      double df = g / dg;
+      double fscale = max(1.0, fabs(f));
+      if (fabs(df) < NOISESTEP * fscale && fabs(df) >= 0.5 * fabs(dfprev))
+        return f;
+      // g is increasing and concave in f, so Newton steps from above the root overshoot below it;
+      // after a stub the guess can be far above, with a tiny dg, and the step is capped
+      f -= max(-MAXSTEP, min(df, MAXSTEP));
+      if (fabs(df) <= TOLERANCE * fscale)
+        return f;
+      dfprev = df;
+    }
+    QF_ASSERT(0, "bootstrapYieldCurve: no convergence for the swap maturing at " + to_string(inst.tMat));
+    return f;
+  }
+
+} // anonymous namespace
+
+
+SPtrYieldCurve bootstrapYieldCurve(vector<RateInstrument> const& instruments)
+{
+  QF_ASSERT(!instruments.empty(), "bootstrapYieldCurve: no instruments");
+  vector<RateInstrument> insts(instruments);
+  stable_sort(insts.begin(), insts.end(),
+    [](RateInstrument const& i1, RateInstrument const& i2) { return i1.tMat < i2.tMat; });
+
+  PartialCurve curve;
+  for (RateInstrument const& inst : insts) {
+    QF_ASSERT(inst.tStart >= 0.0, "bootstrapYieldCurve: start times must be non-negative");
+    QF_ASSERT(inst.tStart < inst.tMat, "bootstrapYieldCurve: start times must be before maturities");
+    QF_ASSERT(inst.tMat > curve.lastNode(),
+      "bootstrapYieldCurve: more than one instrument maturing at " + to_string(inst.tMat));
+
+    double fwdrate;
+    switch (inst.type) {
+    case RateInstrument::Type::DEPOSIT:
+    case RateInstrument::Type::FRA:
+      fwdrate = solveDeposit(curve, inst);
+      break;
+    case RateInstrument::Type::SWAP: {
+      // start from the previous forward rate, or the swap rate for the first node
+      double guess = curve.fwdRates().empty() ? inst.rate : curve.fwdRates().back();
+      fwdrate = solveSwap(curve, inst, guess);
+      break;
+    }
+    default:
+      QF_ASSERT(0, "bootstrapYieldCurve: unknown instrument type");
+    }
+    curve.addNode(inst.tMat, fwdrate);
+  }
+
+  vector<double> const& nodes = curve.nodes();
+  vector<double> const& fwdrates = curve.fwdRates();
+  return std::make_shared<YieldCurve>(nodes.begin() + 1, nodes.end(), fwdrates.begin(), fwdrates.end(),
+                                      YieldCurve::InputType::FWDRATE);
+}
+
+END_NAMESPACE(qf)
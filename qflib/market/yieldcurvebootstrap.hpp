@@ -0,0 +1,48 @@
+/**
+@file  yieldcurvebootstrap.hpp
+@brief Bootstrapping of a yield curve from deposits, FRAs and par swaps
+*/
+
+#ifndef QF_YIELDCURVEBOOTSTRAP_HPP
+#define QF_YIELDCURVEBOOTSTRAP_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/market/yieldcurve.hpp>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** A quoted instrument used for bootstrapping a yield curve */
+struct RateInstrument
+{
+  /** The instrument type */
+  enum class Type
+  {
+    DEPOSIT,     // pays (1 + rate * tau) at tMat for 1 invested at tStart
+    FRA,         // the same as a deposit, for a forward start tStart
+    SWAP         // par swap of a fixed leg paying rate at freq against a floating leg
+  };
+
+  Type type;
+  double tStart;  // start time; zero for spot starting instruments
+  double tMat;    // maturity, which becomes a breakpoint of the curve
+  double rate;    // the quoted rate
+  YieldCurve::RateCmpd cmpd = YieldCurve::RateCmpd::SIMPLE;  // compounding of deposit and FRA rates
+  YieldCurve::SwapFreq freq = YieldCurve::SwapFreq::ANNUAL;  // fixed leg frequency of swaps
+};
+
+/** Bootstraps a yield curve with piecewise constant forward rates, which reprices all the instruments.
+    The instruments are sorted by maturity, which must be distinct, and each one determines the forward rate
+    between the previous maturity and its own. Deposits and FRAs are solved in closed form, swaps with
+    Newton iterations using the analytic derivative of their value with respect to that forward rate,
+    until the forward rate is accurate to the round-off of the swap value. Throws if a swap rate cannot be
+    matched by any forward rate, i.e. if its coupons paid up to the previous maturity exceed its floating leg.
+    The integrals of the forward rates are accumulated as the breakpoints are added,
+    so the cost is linear in the number of instruments and swap payments.
+*/
+SPtrYieldCurve bootstrapYieldCurve(std::vector<RateInstrument> const& instruments);
+
+END_NAMESPACE(qf)
+
+#endif // QF_YIELDCURVEBOOTSTRAP_HPP
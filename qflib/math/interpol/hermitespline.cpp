@@ -0,0 +1,93 @@
+/**
+@file  hermitespline.cpp
+@brief Implementation of the HermiteSpline class
+*/
+
+#include <qflib/math/interpol/hermitespline.hpp>
+
+#include <cmath>
+
+BEGIN_NAMESPACE(qf)
+
+void HermiteSpline::setValue(size_t i, double y)
+{
+  size_t n = size();
+  QF_ASSERT(i < n, "HermiteSpline: breakpoint index out of range");
+  c_(0, i) = y;
+  // the interior slopes depend on the neighbouring values, the end slopes on the three end values
+  size_t iFirst = i <= 2 ? 0 : i - 1;
+  size_t iLast = i + 3 >= n ? n - 1 : i + 1;
+  update(iFirst, iLast);
+}
+
+PiecewisePolynomial HermiteSpline::firstDerivative() const
+{
+  PiecewisePolynomial d(x_.begin(), x_.end(), 2);
+  for (size_t j = 0; j < size(); ++j)
+    for (size_t k = 0; k <= 2; ++k)
+      d.setCoefficient(k, j, (k + 1) * c_(k + 1, j));
+  return d;
+}
+
+void HermiteSpline::update(size_t iFirst, size_t iLast)
+{
+  for (size_t i = iFirst; i <= iLast; ++i)
+    c_(1, i) = besselSlope(i);
+
+  // piece j depends on the slopes at j and j + 1
+  size_t jFirst = iFirst > 0 ? iFirst - 1 : 0;
+  size_t jLast = std::min(iLast, size() - 2);
+  for (size_t j = jFirst; j <= jLast; ++j) {
+    double h = x_(j + 1) - x_(j);
+    double s = (c_(0, j + 1) - c_(0, j)) / h;
+    double m0 = c_(1, j);
+    double m1 = c_(1, j + 1);
+    c_(2, j) = (3.0 * s - 2.0 * m0 - m1) / h;
+    c_(3, j) = (m0 + m1 - 2.0 * s) / (h * h);
+  }
+}
+
+double HermiteSpline::besselSlope(size_t i) const
+{
+  size_t n = size();
+  if (n == 2)
+    return (c_(0, 1) - c_(0, 0)) / (x_(1) - x_(0));
+
+  double m;
+  if (i == 0 || i == n - 1) {
+    // slope of the parabola through the three end points, at the end point
+    size_t k = i == 0 ? 0 : n - 2;     // the end interval
+    size_t l = i == 0 ? 1 : n - 3;     // its neighbour
+    double h0 = x_(k + 1) - x_(k);
+    double h1 = x_(l + 1) - x_(l);
+    double s0 = (c_(0, k + 1) - c_(0, k)) / h0;
+    double s1 = (c_(0, l + 1) - c_(0, l)) / h1;
+    m = ((2.0 * h0 + h1) * s0 - h0 * s1) / (h0 + h1);
+    if (monotone_) {
+      if (m * s0 <= 0.0)
+        m = 0.0;
+      else if (std::fabs(m) > 3.0 * std::fabs(s0))
+        m = 3.0 * s0;
+    }
+  }
+  else {
+    double h0 = x_(i) - x_(i - 1);
+    double h1 = x_(i + 1) - x_(i);
+    double s0 = (c_(0, i) - c_(0, i - 1)) / h0;
+    double s1 = (c_(0, i + 1) - c_(0, i)) / h1;
+    m = (h1 * s0 + h0 * s1) / (h0 + h1);
+    if (monotone_) {
+      // Hyman filter: flat at local extrema, and at most three times the smaller secant
+      if (s0 * s1 <= 0.0)
+        m = 0.0;
+      else {
+        double mmax = 3.0 * std::min(std::fabs(s0), std::fabs(s1));
+        if (std::fabs(m) > mmax)
+          m = std::copysign(mmax, m);
+      }
+    }
+  }
+  return m;
+}
+
+END_NAMESPACE(qf)
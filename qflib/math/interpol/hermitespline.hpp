@@ -0,0 +1,68 @@
+/**
+@file  hermitespline.hpp
+@brief Piecewise cubic Hermite interpolation with local slopes
+*/
+
+#ifndef QF_HERMITESPLINE_HPP
+#define QF_HERMITESPLINE_HPP
+
+#include <qflib/math/interpol/piecewisepolynomial.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+/** The piecewise cubic Hermite spline through a set of points (x_i, y_i).
+  The slope at each breakpoint is the Bessel slope, i.e. the slope of the parabola through the point
+  and its two neighbours. Optionally, the slopes are limited with the Hyman filter,
+  so that the spline is monotone wherever the data are monotone.
+  Since each slope depends only on the neighbouring points, changing one value
+  changes at most four pieces of the spline, and setValue updates only those.
+  Beyond the breakpoints eval and pieceValue extrapolate the spline flat at the end values, as for any
+  PiecewisePolynomial. The slope stored at the last breakpoint is its slope from the left, which shapes
+  the last piece; eval ignores it beyond the last breakpoint, but firstDerivative extrapolates with it.
+*/
+class HermiteSpline : public PiecewisePolynomial
+{
+public:
+  /** Ctor from breakpoints and values; at least two breakpoints are required */
+  template<typename XITER, typename YITER>
+  HermiteSpline(XITER xFirst, XITER xLast, YITER yFirst, bool monotone = false);
+
+  /** Returns the value at the ith breakpoint */
+  double value(size_t i) const { return c_(0, i); }
+
+  /** Returns the slope at the ith breakpoint */
+  double slope(size_t i) const { return c_(1, i); }
+
+  /** Sets the value at the ith breakpoint, updating the neighbouring slopes and pieces only */
+  void setValue(size_t i, double y);
+
+  /** Returns the derivative, a piecewise quadratic curve extrapolated flat at the end slopes */
+  PiecewisePolynomial firstDerivative() const;
+
+private:
+  // recomputes the slopes at breakpoints [iFirst, iLast] and the pieces depending on them
+  void update(size_t iFirst, size_t iLast);
+
+  // the Bessel slope at breakpoint i, limited if monotone_
+  double besselSlope(size_t i) const;
+
+  bool monotone_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+///////////////////////////////////////////////////////////////////////////////
+
+template<typename XITER, typename YITER>
+HermiteSpline::HermiteSpline(XITER xFirst, XITER xLast, YITER yFirst, bool monotone)
+  : PiecewisePolynomial(xFirst, xLast, 3), monotone_(monotone)
+{
+  QF_ASSERT(size() >= 2, "HermiteSpline: at least two breakpoints are required");
+  for (size_t j = 0; j < size(); ++j, ++yFirst)
+    c_(0, j) = *yFirst;
+  update(0, size() - 1);
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_HERMITESPLINE_HPP
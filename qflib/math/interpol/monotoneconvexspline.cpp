@@ -0,0 +1,143 @@
+/**
+@file  monotoneconvexspline.cpp
+@brief Implementation of the MonotoneConvexSpline class
+*/
+
+#include <qflib/math/interpol/monotoneconvexspline.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+namespace {
+
+  // re-expands the quadratic q[0] + q[1] x + q[2] x^2 around x = d
+  inline void shiftQuadratic(double* q, double d)
+  {
+    q[0] += (q[1] + q[2] * d) * d;
+    q[1] += 2.0 * q[2] * d;
+  }
+
+} // anonymous namespace
+
+void MonotoneConvexSpline::setAverage(size_t i, double avg)
+{
+  size_t n = intervals();
+  QF_ASSERT(i < n, "MonotoneConvexSpline: interval index out of range");
+  avgs_(i) = avg;
+  // the nodes i and i + 1 change, and the end nodes through their extrapolation from the inner ones
+  size_t nodeFirst = i <= 1 ? 0 : i;
+  size_t nodeLast = i + 2 >= n ? n : i + 1;
+  update(nodeFirst > 0 ? nodeFirst - 1 : 0, std::min(nodeLast, n - 1));
+}
+
+double MonotoneConvexSpline::innerNodeValue(size_t i) const
+{
+  double dl = x_(2 * i) - x_(2 * i - 2);
+  double dr = x_(2 * i + 2) - x_(2 * i);
+  double f = (dl * avgs_(i) + dr * avgs_(i - 1)) / (dl + dr);
+  if (positive_)
+    f = std::max(0.0, std::min(f, 2.0 * std::min(avgs_(i - 1), avgs_(i))));
+  return f;
+}
+
+double MonotoneConvexSpline::nodeValue(size_t i) const
+{
+  size_t n = intervals();
+  if (n == 1)
+    return avgs_(0);
+  if (i > 0 && i < n)
+    return innerNodeValue(i);
+
+  // the end nodes are chosen so that the curve is flat at the ends' midpoints
+  double a = i == 0 ? avgs_(0) : avgs_(n - 1);
+  double f = a - 0.5 * (innerNodeValue(i == 0 ? 1 : n - 1) - a);
+  if (positive_)
+    f = std::max(0.0, std::min(f, 2.0 * a));
+  return f;
+}
+
+void MonotoneConvexSpline::update(size_t iFirst, size_t iLast)
+{
+  size_t n = intervals();
+  double fnext = nodeValue(iFirst);
+  for (size_t i = iFirst; i <= iLast; ++i) {
+    double t0 = x_(2 * i);
+    double t1 = x_(2 * i + 2);
+    double dt = t1 - t0;
+    double a = avgs_(i);
+    double f0 = fnext;
+    double f1 = fnext = nodeValue(i + 1);
+
+    // the deviation g(x) from the average on x = (t - t0) / dt in [0, 1], with zero integral,
+    // as a quadratic gl on [0, eta) and a quadratic gr on [eta, 1], expanded around eta
+    double g0 = f0 - a;
+    double g1 = f1 - a;
+    double gl[3] = { 0.0, 0.0, 0.0 };
+    double gr[3] = { 0.0, 0.0, 0.0 };
+    double eta = 0.5;
+    if (g0 == 0.0 && g1 == 0.0) {
+      // the curve is flat at the average
+    }
+    else if ((g0 > 0.0 && g1 >= -2.0 * g0 && g1 <= -0.5 * g0) ||
+             (g0 < 0.0 && g1 <= -2.0 * g0 && g1 >= -0.5 * g0)) {
+      // a single monotone quadratic
+      gl[0] = g0;
+      gl[1] = -4.0 * g0 - 2.0 * g1;
+      gl[2] = 3.0 * (g0 + g1);
+      std::copy(gl, gl + 3, gr);
+      shiftQuadratic(gr, eta);
+    }
+    else if ((g0 > 0.0 && g1 < -2.0 * g0) || (g0 < 0.0 && g1 > -2.0 * g0)) {
+      // flat at g0, then a quadratic to g1
+      eta = (g1 + 2.0 * g0) / (g1 - g0);
+      gl[0] = gr[0] = g0;
+      gr[2] = (g1 - g0) / ((1.0 - eta) * (1.0 - eta));
+    }
+    else if ((g0 > 0.0 && g1 < 0.0) || (g0 < 0.0 && g1 > 0.0)) {
+      // a quadratic from g0 to g1, then flat at g1
+      eta = 3.0 * g1 / (g1 - g0);
+      gl[0] = g0;
+      gl[1] = -2.0 * (g0 - g1) / eta;
+      gl[2] = (g0 - g1) / (eta * eta);
+      gr[0] = g1;
+    }
+    else {
+      // g0 and g1 have the same sign: two quadratics meeting with zero slope at eta
+      double amin = -g0 * g1 / (g0 + g1);
+      eta = g1 / (g0 + g1);
+      gl[0] = g0;
+      gl[1] = -2.0 * (g0 - amin) / eta;
+      gl[2] = (g0 - amin) / (eta * eta);
+      gr[0] = amin;
+      gr[2] = (g1 - amin) / ((1.0 - eta) * (1.0 - eta));
+    }
+
+    // keep the inner breakpoint strictly inside the interval; if eta rounds to an end,
+    // the other quadratic covers the whole interval
+    double s = t0 + eta * dt;
+    if (s <= t0) {
+      std::copy(gr, gr + 3, gl);
+      shiftQuadratic(gl, -eta);
+      shiftQuadratic(gr, 0.5 - eta);
+      eta = 0.5;
+    }
+    else if (s >= t1) {
+      std::copy(gl, gl + 3, gr);
+      shiftQuadratic(gr, 0.5);
+      eta = 0.5;
+    }
+    x_(2 * i + 1) = t0 + eta * dt;
+
+    // scale from x to t
+    c_(0, 2 * i) = a + gl[0];
+    c_(1, 2 * i) = gl[1] / dt;
+    c_(2, 2 * i) = gl[2] / (dt * dt);
+    c_(0, 2 * i + 1) = a + gr[0];
+    c_(1, 2 * i + 1) = gr[1] / dt;
+    c_(2, 2 * i + 1) = gr[2] / (dt * dt);
+  }
+  // the last breakpoint holds the value extrapolated flat
+  if (iLast == n - 1)
+    c_(0, 2 * n) = fnext;
+}
+
+END_NAMESPACE(qf)
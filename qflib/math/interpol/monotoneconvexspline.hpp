@@ -0,0 +1,86 @@
+/**
+@file  monotoneconvexspline.hpp
+@brief The monotone convex interpolation of Hagan and West
+*/
+
+#ifndef QF_MONOTONECONVEXSPLINE_HPP
+#define QF_MONOTONECONVEXSPLINE_HPP
+
+#include <qflib/math/interpol/piecewisepolynomial.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+/** The monotone convex spline of Hagan and West (2006).
+  Given nodes t_0 < t_1 < ... < t_n and the averages a_1, ..., a_n of a curve on each interval (t_{i-1}, t_i],
+  e.g. the discrete forward rates of a yield curve, it is the continuous curve that preserves the averages,
+  and is monotone and convex where the averages are.
+  The value at each inner node is interpolated from the two adjacent averages,
+  and on each interval the curve is one or two quadratic pieces.
+  Each interval is stored as two pieces, so that the breakpoints are t_0, s_1, t_1, s_2, ..., s_n, t_n,
+  with s_i in (t_{i-1}, t_i); the curve is extrapolated flat after t_n.
+  With the positive flag set, the node values are bounded so that the curve stays non-negative
+  if all the averages are. Since each node value depends only on the adjacent averages,
+  setAverage updates at most three intervals.
+*/
+class MonotoneConvexSpline : public PiecewisePolynomial
+{
+public:
+  /** Ctor from the nodes [tFirst, tLast) and the averages between them, one fewer than the nodes */
+  template<typename TITER, typename AITER>
+  MonotoneConvexSpline(TITER tFirst, TITER tLast, AITER aFirst, bool positive = false);
+
+  /** Returns the number of intervals between the nodes */
+  size_t intervals() const { return avgs_.size(); }
+
+  /** Returns the ith node */
+  double node(size_t i) const { return x_(2 * i); }
+
+  /** Returns the average on the ith interval, between node(i) and node(i + 1) */
+  double average(size_t i) const { return avgs_(i); }
+
+  /** Sets the average on the ith interval, updating the neighbouring intervals only */
+  void setAverage(size_t i, double avg);
+
+private:
+  // recomputes the intervals [iFirst, iLast]
+  void update(size_t iFirst, size_t iLast);
+
+  // the curve value at the ith node
+  double nodeValue(size_t i) const;
+
+  // the same, at an inner node before the end correction
+  double innerNodeValue(size_t i) const;
+
+  Vector avgs_;     // the averages on the intervals
+  bool positive_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+///////////////////////////////////////////////////////////////////////////////
+
+template<typename TITER, typename AITER>
+MonotoneConvexSpline::MonotoneConvexSpline(TITER tFirst, TITER tLast, AITER aFirst, bool positive)
+  : positive_(positive)
+{
+  size_t n = tLast - tFirst;
+  QF_ASSERT(n >= 2, "MonotoneConvexSpline: at least two nodes are required");
+  avgs_.set_size(n - 1);
+  std::copy(aFirst, aFirst + (n - 1), avgs_.begin());
+
+  // the inner breakpoints are placed at the midpoints for now; update moves them
+  Vector bkpts(2 * n - 1);
+  for (size_t i = 0; i < n; ++i, ++tFirst) {
+    bkpts[2 * i] = *tFirst;
+    if (i > 0)
+      bkpts[2 * i - 1] = 0.5 * (bkpts[2 * i - 2] + bkpts[2 * i]);
+  }
+  x_ = bkpts;
+  c_.zeros(3, bkpts.size());
+  assertBreakpointOrder();
+  update(0, n - 2);
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_MONOTONECONVEXSPLINE_HPP
@@ -42,6 +42,18 @@ double PiecewisePolynomial::eval(double x, size_t k) const
   return val;
 }
 
+double PiecewisePolynomial::eval(double x, size_t k, ptrdiff_t& hint) const
+{
+  hint = index(x, hint);
+  if (hint < 0) {
+    hint = 0;
+    return (k == 0) ? c_(0, 0) : 0.0;   // flat extrapolation to the left
+  }
+  if (size_t(hint) == size() - 1)
+    return (k == 0) ? c_(0, hint) : 0.0;   // flat extrapolation to the right
+  return derivative(hint, x - x_(hint), k);
+}
+
 double PiecewisePolynomial::integral(double a, double b) const
 {
   int isign(1);     // the sign of the integral
@@ -87,63 +99,85 @@ double PiecewisePolynomial::integral(double a, double b) const
 }
 
 
-PiecewisePolynomial PiecewisePolynomial::operator+(PiecewisePolynomial const& p) const
+void PiecewisePolynomial::taylorCoefficients(ptrdiff_t xIdx, double x, double* d) const
 {
-  size_t n = size() + p.size();               // the sum has at most n breakpoints
-  size_t ord = std::max(order(), p.order());  // the sum has order the max of the two orders
-  Vector bkpts(n);                            // the breakpoints of the sum
-  // merge the breakpoints
+  size_t ord = order();
+  if (xIdx < 0 || size_t(xIdx) == size() - 1) {
+    // flat extrapolation
+    d[0] = c_(0, xIdx < 0 ? 0 : xIdx);
+    for (size_t i = 1; i <= ord; ++i)
+      d[i] = 0.0;
+    return;
+  }
+  for (size_t i = 0; i <= ord; ++i)
+    d[i] = c_(i, xIdx);
+  // shift the expansion point from x_(xIdx) to x by repeated synthetic division
+  double h = x - x_(xIdx);
+  if (h == 0.0)
+    return;
+  for (size_t k = 0; k < ord; ++k)
+    for (size_t i = ord - 1; i + 1 > k; --i)
+      d[i] += h * d[i + 1];
+}
+
+Vector PiecewisePolynomial::mergeBreakPoints(PiecewisePolynomial const& p) const
+{
+  Vector bkpts(size() + p.size());  // the union has at most that many breakpoints
   Vector::const_iterator bkend = std::set_union(x_.begin(), x_.end(),
     p.breakPoints().begin(), p.breakPoints().end(), bkpts.begin());
-  Vector::const_iterator bkbeg = bkpts.begin();
-
-  PiecewisePolynomial psum(bkbeg, bkend, ord);
-  size_t nbks = psum.size();        // number of unique breakpoints
-  Vector tval(nbks), pval(nbks);
-
-  // polynomial summation; compute derivatives of all orders and add them
-  for (size_t i = 0; i <= ord; ++i) {
-    eval(bkbeg, bkend, tval.begin(), i);
-    p.eval(bkbeg, bkend, pval.begin(), i);
-    size_t fct = factorial(i);
-    Matrix::row_iterator rit = psum.coeff_begin(i);
-    for (size_t j = 0; j < nbks; ++j) {
-      *rit += (tval(j) + pval(j)) / fct;
-      ++rit;
-    }
+  bkpts.resize(bkend - bkpts.begin());
+  return bkpts;
+}
+
+PiecewisePolynomial PiecewisePolynomial::operator+(PiecewisePolynomial const& p) const
+{
+  size_t ord = std::max(order(), p.order());  // the sum has order the max of the two orders
+  Vector bkpts = mergeBreakPoints(p);         // the breakpoints of the sum
+  PiecewisePolynomial psum(bkpts.begin(), bkpts.end(), ord);
+
+  // single pass over the merged breakpoints, advancing the interval index of each operand;
+  // at each breakpoint the Taylor coefficients of the two operands are added
+  Vector tcoef(order() + 1), pcoef(p.order() + 1);
+  ptrdiff_t tidx = -1, pidx = -1;
+  ptrdiff_t tn = size(), pn = p.size();
+  for (size_t j = 0; j < psum.size(); ++j) {
+    double b = bkpts[j];
+    while (tidx + 1 < tn && x_(tidx + 1) <= b)
+      ++tidx;
+    while (pidx + 1 < pn && p.x_(pidx + 1) <= b)
+      ++pidx;
+    taylorCoefficients(tidx, b, tcoef.memptr());
+    p.taylorCoefficients(pidx, b, pcoef.memptr());
+    for (size_t i = 0; i <= order(); ++i)
+      psum.c_(i, j) += tcoef[i];
+    for (size_t i = 0; i <= p.order(); ++i)
+      psum.c_(i, j) += pcoef[i];
   }
   return psum;
 }
 
 PiecewisePolynomial PiecewisePolynomial::operator*(PiecewisePolynomial const& p) const
 {
-  size_t n = size() + p.size();               // the product has at most n breakpoints
   size_t ord = order() + p.order();           // the product has order the sum of the orders
-  Vector bkpts(n);                            // the breakpoints of the product
-  // merge the breakpoints
-  Vector::const_iterator bkend = std::set_union(x_.begin(), x_.end(),
-    p.breakPoints().begin(), p.breakPoints().end(), bkpts.begin());
-  Vector::const_iterator bkbeg = bkpts.begin();
-
-  PiecewisePolynomial pprod(bkbeg, bkend, ord);
-  size_t nbks = pprod.size();        // number of unique breakpoints
-  Vector tval(nbks), pval(nbks);
-
-  // polynomial multiplication: using convolution of coefficients
-  for (size_t i = 0; i <= ord; ++i) {
-    Matrix::row_iterator rit = pprod.coeff_begin(i);
-    for (size_t k = 0; k <= i; ++k) {
-      eval(bkbeg, bkend, tval.begin(), k);
-      p.eval(bkbeg, bkend, pval.begin(), i - k);
-      size_t fact1 = factorial(i);
-      size_t fact2 = factorial(i - k);
-      for (size_t j = 0; j < nbks; ++j) {
-        double tmp = tval[j] / fact1;
-        tmp *= pval[j] / fact2;
-        *rit += tmp;
-        ++rit;
-      }
-    }
+  Vector bkpts = mergeBreakPoints(p);         // the breakpoints of the product
+  PiecewisePolynomial pprod(bkpts.begin(), bkpts.end(), ord);
+
+  // single pass over the merged breakpoints, advancing the interval index of each operand;
+  // at each breakpoint the Taylor coefficients of the two operands are convolved
+  Vector tcoef(order() + 1), pcoef(p.order() + 1);
+  ptrdiff_t tidx = -1, pidx = -1;
+  ptrdiff_t tn = size(), pn = p.size();
+  for (size_t j = 0; j < pprod.size(); ++j) {
+    double b = bkpts[j];
+    while (tidx + 1 < tn && x_(tidx + 1) <= b)
+      ++tidx;
+    while (pidx + 1 < pn && p.x_(pidx + 1) <= b)
+      ++pidx;
+    taylorCoefficients(tidx, b, tcoef.memptr());
+    p.taylorCoefficients(pidx, b, pcoef.memptr());
+    for (size_t k = 0; k <= order(); ++k)
+      for (size_t l = 0; l <= p.order(); ++l)
+        pprod.c_(k + l, j) += tcoef[k] * pcoef[l];
   }
   return pprod;
 }
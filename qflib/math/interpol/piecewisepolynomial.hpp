@@ -40,6 +40,16 @@ public:
   template<typename XITER, typename YITER>
   PiecewisePolynomial(XITER xFirst, XITER xLast, YITER yFirst, size_t order);
 
+  /** Ctor viewing n breakpoints and their coefficients in external memory, without copying them
+      The coefficients are stored by breakpoint, order + 1 for each, as in coefficients().
+      The memory must outlive the curve and stay unchanged; copies of the curve own their data.
+  */
+  PiecewisePolynomial(double* x, size_t n, double* c, size_t order)
+    : x_(x, n, false, true), c_(c, order + 1, n, false, true)
+  {
+    assertBreakpointOrder();
+  }
+
   // Dtor
   virtual ~PiecewisePolynomial() {}
 
@@ -95,6 +105,12 @@ public:
   template<typename XITER, typename YITER>
   void eval(XITER const xFirst, XITER const xLast, YITER yFirst, size_t k = 0) const;
 
+  /** Value or derivative at one point x, for monotone or clustered queries
+    The breakpoint search starts from hint, which is then updated to the index of the interval containing x.
+    Start with hint = 0.
+  */
+  double eval(double x, size_t k, ptrdiff_t& hint) const;
+
   /** Integrate between a and b */
   double integral(double a, double b) const;
 
@@ -106,6 +122,29 @@ public:
   template<typename XITER, typename YITER>
   void integral(double xStart, XITER xFirst, XITER xLast, YITER yFirst, bool stepwise = false) const;
 
+  /** Value of the ith piece at breakPoint(i) + h, for h >= 0
+    The last piece is extrapolated flat. It skips the breakpoint search when the index is known.
+  */
+  double pieceValue(size_t i, double h) const;
+
+  /** Integral of the ith piece from breakPoint(i) + h1 to breakPoint(i) + h2, for 0 <= h1 <= h2
+    The last piece is extrapolated flat. The result has no cancellation error when h1 and h2 are close.
+  */
+  double pieceIntegral(size_t i, double h1, double h2) const;
+
+  // Search
+
+  /** Returns the greatest index i such that breakPoint(i) <= x; it returns -1 if x < breakPoint(0)
+    It is a branchless binary search. 
+  */
+  ptrdiff_t index(double x) const;
+
+  /** Same as index(x), but the search gallops outwards from hint, e.g. the result of the previous query.
+    It costs O(1) when successive queries move by few breakpoints, as in time stepping, 
+    and O(log d) when they move by d breakpoints.
+  */
+  ptrdiff_t index(double x, ptrdiff_t hint) const;
+
   // Computed assignments
 
   /** Add a constant value to this */
@@ -141,13 +180,6 @@ protected:
     QF_ASSERT(it == x_.end(), "PiecewisePolynomial: breakpoints must be in strict increasing order");
   }
 
-  // Returns the greatest index in the vector x_ such that x_[idx] <= x;
-  // It returns -1 if x < x[0] 
-  inline ptrdiff_t index(double x) const
-  {
-    return std::upper_bound(x_.begin(), x_.end(), x) - x_.begin() - 1;
-  }
-
   // Helper function for computing factorials
   inline size_t factorial(size_t n) const {
     return n == 0 ? 1 : n * factorial(n - 1);
@@ -160,6 +192,13 @@ protected:
   // Helper function for computing primitives. It returns the integral of p at x_[xIdx] + h
   double primitive(size_t xIdx, double h, size_t k) const;
 
+  // Helper function for the polynomial algebra. It writes to d[0..order()] the Taylor coefficients 
+  // of the curve at x, where xIdx = index(x), consistently with eval(x, k) / k!
+  void taylorCoefficients(ptrdiff_t xIdx, double x, double* d) const;
+
+  // Helper function for the polynomial algebra. It returns the union of the breakpoints of this and p
+  Vector mergeBreakPoints(PiecewisePolynomial const& p) const;
+
   // state
   Vector x_;  // breakpoints
   Matrix c_;  // polynomial coefficients
@@ -170,6 +209,101 @@ protected:
 // Inline definitions
 ///////////////////////////////////////////////////////////////////////////////
 
+inline ptrdiff_t PiecewisePolynomial::index(double x) const
+{
+  double const* first = x_.memptr();
+  double const* base = first;
+  size_t n = size();
+  if (n == 0)
+    return -1;
+  // halve the range with a conditional move instead of a branch,
+  // prefetching both candidate midpoints of the next step
+  while (n > 1) {
+    size_t half = n / 2;
+#if defined(__GNUC__)
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+#endif
+    base = base[half] <= x ? base + half : base;
+    n -= half;
+  }
+  // base only moves onto breakpoints <= x, so *base > x means that x is left of x_[0]
+  return (base - first) - (x < *base ? 1 : 0);
+}
+
+inline ptrdiff_t PiecewisePolynomial::index(double x, ptrdiff_t hint) const
+{
+  double const* xp = x_.memptr();
+  ptrdiff_t n = size();
+  if (n == 0)
+    return -1;
+  hint = std::min(std::max(hint, ptrdiff_t(0)), n - 1);
+
+  // gallop from the hint until x is bracketed by xp[lo] <= x < xp[hi]
+  ptrdiff_t lo, hi;
+  ptrdiff_t step = 1;
+  if (xp[hint] <= x) {
+    lo = hint;
+    hi = hint + 1;
+    while (hi < n && xp[hi] <= x) {
+      lo = hi;
+      step *= 2;
+      hi = lo + step;
+    }
+    hi = std::min(hi, n);
+  }
+  else {
+    hi = hint;
+    lo = hint - 1;
+    while (lo >= 0 && x < xp[lo]) {
+      hi = lo;
+      step *= 2;
+      lo = hi - step;
+    }
+    if (lo < 0) {
+      if (x < xp[0])
+        return -1;
+      lo = 0;
+    }
+  }
+
+  // then bisect within the bracket
+  while (hi - lo > 1) {
+    ptrdiff_t mid = lo + (hi - lo) / 2;
+    if (xp[mid] <= x)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+inline double PiecewisePolynomial::pieceValue(size_t i, double h) const
+{
+  double const* c = c_.colptr(i);
+  if (i + 1 == size())
+    return c[0];   // flat extrapolation
+  double val = 0.0;
+  for (ptrdiff_t k = order(); k >= 0; --k)
+    val = val * h + c[k];
+  return val;
+}
+
+inline double PiecewisePolynomial::pieceIntegral(size_t i, double h1, double h2) const
+{
+  double const* c = c_.colptr(i);
+  size_t ord = i + 1 == size() ? 0 : order();  // flat extrapolation after the last breakpoint
+  // (h2^(k+1) - h1^(k+1)) / (k+1) = (h2 - h1) * s_k / (k+1), with s_k = sum_j h2^j h1^(k-j)
+  double val = c[0];
+  double s = 1.0, h1k = 1.0;
+  for (size_t k = 1; k <= ord; ++k) {
+    h1k *= h1;
+    s = s * h2 + h1k;
+    val += c[k] * s / (k + 1);
+  }
+  return val * (h2 - h1);
+}
+
 inline double PiecewisePolynomial::derivative(size_t xIdx, double h, size_t k) const
 {
   double val(0.0);
@@ -198,14 +332,13 @@ inline double PiecewisePolynomial::primitive(size_t xIdx, double h, size_t k) co
   }
   else {
     //  the integration range is inside the breakpoint domain
-    ptrdiff_t i;
-    size_t factnp1 = factorial(order() + 1);
-    for (i = ord + ik; i >= ik; --i) {
-      factnp1 /= (i + k + 1);
-      val = c_(i - ik, xIdx) + val * h / (i + 1);
+    //  the coefficients are Taylor coefficients, as in derivative(), so that 
+    //  the k-th primitive is the sum of c_i h^(i+k) i! / (i+k)!
+    double term = std::pow(h, ik) / factorial(k);
+    for (size_t i = 0; i <= ord; ++i) {
+      val += c_(i, xIdx) * term;
+      term *= h * (i + 1) / (i + k + 1);
     }
-    for (; i >= 0; --i)
-      val = val * h / (i + 1);
   }
   return val;
 }
@@ -74,7 +74,7 @@ double ErrorFunction::inverfc(double p)
   double x = -0.70711 * ((2.30753 + t * 0.27061) / (1. + t * (0.99229 + t * 0.04481)) - t);
   for (int j = 0; j < 2; j++) {
     double err = erfc(x) - pp;
-    x += err / (1.12837916709551257*exp(-sqrt(x)) - x*err); // Halley.
+    x += err / (1.12837916709551257*exp(-x * x) - x*err); // Halley.
     x = x < 0 ? 0 : x;  // NOTE added to prevent NAN at p = 1 
   }
   return (p < 1.0 ? x : -x);
@@ -0,0 +1,111 @@
+/**
+@file  quantilecalculator.hpp
+@brief Calculates empirical quantiles and tail means of a set of samples
+*/
+
+#ifndef QF_QUANTILECALCULATOR_HPP
+#define QF_QUANTILECALCULATOR_HPP
+
+#include <qflib/math/stats/statisticscalculator.hpp>
+#include <qflib/exception.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** Quantile calculator
+    For each probability p, it computes the empirical quantile of each variable, i.e. the kth smallest sample
+    with k = ceil(p * nSamples()), and the mean of the k smallest samples, the lower tail mean.
+    With the samples being P&Ls and p = 1 - confidence level, these are minus the historical VaR and
+    expected shortfall. The results have one row per quantile followed by one row per tail mean.
+    The samples are kept, one double per sample and variable.
+*/
+template <typename ITER>
+class QuantileCalculator : public StatisticsCalculator < ITER >
+{
+  using StatisticsCalculator<ITER>::nVariables;
+  using StatisticsCalculator<ITER>::nsamples_;
+  using StatisticsCalculator<ITER>::results_;
+
+public:
+
+  /** Ctor from the number of variables and the probabilities, in (0, 1] */
+  QuantileCalculator(size_t nvars, Vector const& probs);
+
+  virtual ~QuantileCalculator() {}
+
+  virtual void addSample(ITER begin, ITER end) override;
+
+  virtual void reset() override;
+
+  virtual Matrix const & results() override;
+
+  /** Returns the probabilities */
+  Vector const& probabilities() const { return probs_; }
+
+protected:
+
+  // state
+  Vector probs_;
+  std::vector<std::vector<double>> samples_;   // the samples of each variable
+  std::vector<double> work_;                   // scratch array for the partial sorts
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+template <typename ITER>
+QuantileCalculator<ITER>::QuantileCalculator(size_t nvars, Vector const& probs)
+  : StatisticsCalculator<ITER>(nvars, 2 * probs.size()), probs_(probs), samples_(nvars)
+{
+  for (size_t k = 0; k < probs_.size(); ++k)
+    QF_ASSERT(probs_[k] > 0.0 && probs_[k] <= 1.0, "QuantileCalculator: probabilities must be in (0, 1]");
+}
+
+template <typename ITER>
+void QuantileCalculator<ITER>::addSample(ITER begin, ITER end)
+{
+  QF_ASSERT(size_t(end - begin) == nVariables(), "missing variable values!");
+
+  ITER it = begin;
+  for (size_t j = 0; j < nVariables(); ++j, ++it)
+    samples_[j].push_back(*it);
+
+  ++nsamples_;
+}
+
+template <typename ITER>
+Matrix const & QuantileCalculator<ITER>::results()
+{
+  QF_ASSERT(nsamples_ > 0, "QuantileCalculator: no samples");
+  size_t nprobs = probs_.size();
+  for (size_t j = 0; j < nVariables(); ++j) {
+    work_.assign(samples_[j].begin(), samples_[j].end());
+    for (size_t k = 0; k < nprobs; ++k) {
+      size_t rank = (size_t) std::ceil(probs_[k] * nsamples_ - 1.0e-9);
+      rank = std::max(rank, size_t(1));
+      // the rank - 1 smallest samples end up before the quantile, in no particular order
+      std::nth_element(work_.begin(), work_.begin() + (rank - 1), work_.end());
+      double sum = 0.0;
+      for (size_t i = 0; i < rank; ++i)
+        sum += work_[i];
+      results_(k, j) = work_[rank - 1];
+      results_(nprobs + k, j) = sum / rank;
+    }
+  }
+
+  return results_;
+}
+
+template <typename ITER>
+void QuantileCalculator<ITER>::reset()
+{
+  StatisticsCalculator<ITER>::reset();
+  for (size_t j = 0; j < nVariables(); ++j)
+    samples_[j].clear();
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_QUANTILECALCULATOR_HPP
@@ -79,6 +79,7 @@ void StatisticsCalculator<ITER>::reset()
       results_(i, j) = 0.0;
     }
   }
+  nsamples_ = 0;
 }
 
 
@@ -0,0 +1,79 @@
+/**
+@file  bscharfunction.hpp
+@brief Characteristic function of the log-return in the Black-Scholes model
+*/
+
+#ifndef QF_BSCHARFUNCTION_HPP
+#define QF_BSCHARFUNCTION_HPP
+
+#include <qflib/methods/fourier/characteristicfunction.hpp>
+#include <qflib/market/volatilitytermstructure.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+/** Characteristic function in the Black-Scholes model with constant or term-structure volatility.
+    X_T is normal with mean -w/2 and variance w, where w is the total variance to T.
+*/
+class BsCharFunction : public CharacteristicFunction
+{
+public:
+  /** Ctor for constant volatility */
+  explicit BsCharFunction(double vol);
+
+  /** Ctor for volatility term structure */
+  explicit BsCharFunction(SPtrVolatilityTermStructure volTS);
+
+  virtual std::complex<double> operator()(std::complex<double> u, double tMat) const override;
+
+  virtual void cumulants(double tMat, double& c1, double& c2, double& c4) const override;
+
+protected:
+  /** Returns the total variance from 0 to tMat */
+  double totalVariance(double tMat) const;
+
+private:
+  double vol_;                         // the constant volatility
+  SPtrVolatilityTermStructure volTS_;  // pointer to the volatility term structure
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+BsCharFunction::BsCharFunction(double vol)
+  : vol_(vol), volTS_(nullptr)
+{
+  QF_ASSERT(vol >= 0.0, "BsCharFunction: volatility must be non-negative");
+}
+
+inline
+BsCharFunction::BsCharFunction(SPtrVolatilityTermStructure volTS)
+  : vol_(0.0), volTS_(volTS)
+{
+  QF_ASSERT(volTS_, "BsCharFunction: null volatility term structure");
+}
+
+inline double BsCharFunction::totalVariance(double tMat) const
+{
+  double vol = volTS_ ? volTS_->spotVol(tMat) : vol_;
+  return vol * vol * tMat;
+}
+
+inline std::complex<double> BsCharFunction::operator()(std::complex<double> u, double tMat) const
+{
+  const std::complex<double> i(0.0, 1.0);
+  double w = totalVariance(tMat);
+  return std::exp(-0.5 * w * (u * u + i * u));
+}
+
+inline void BsCharFunction::cumulants(double tMat, double& c1, double& c2, double& c4) const
+{
+  double w = totalVariance(tMat);
+  c1 = -0.5 * w;
+  c2 = w;
+  c4 = 0.0;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_BSCHARFUNCTION_HPP
@@ -0,0 +1,64 @@
+/**
+@file  characteristicfunction.hpp
+@brief Base class for characteristic functions used by the Fourier pricing methods
+*/
+
+#ifndef QF_CHARACTERISTICFUNCTION_HPP
+#define QF_CHARACTERISTICFUNCTION_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/sptr.hpp>
+#include <complex>
+#include <cmath>
+
+BEGIN_NAMESPACE(qf)
+
+/** The abstract base class for characteristic functions of the log-return X_T = ln(S_T / F(0,T)),
+    where F(0,T) is the forward price of the asset to time T.
+    Working relative to the forward keeps rates and dividends out of the model, 
+    they enter the Fourier pricers only via the forward and the discount factor.
+*/
+class CharacteristicFunction
+{
+public:
+  /** Dtor */
+  virtual ~CharacteristicFunction() {}
+
+  /** Returns E[exp(i u X_T)] under the T-forward measure.
+      The argument u may be complex; the Carr-Madan method evaluates it off the real axis.
+  */
+  virtual std::complex<double> operator()(std::complex<double> u, double tMat) const = 0;
+
+  /** Returns the first, second and fourth cumulants of X_T.
+      They are used for setting the truncation range of the COS method.
+      The default implementation differentiates the cumulant generating function ln E[exp(s X_T)]
+      numerically; models with closed-form cumulants should override it.
+  */
+  virtual void cumulants(double tMat, double& c1, double& c2, double& c4) const;
+};
+
+using SPtrCharacteristicFunction = std::shared_ptr<CharacteristicFunction>;
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline void CharacteristicFunction::cumulants(double tMat, double& c1, double& c2, double& c4) const
+{
+  // central differences of K(s) = ln phi(-i s) on a stencil of five points
+  const double h = 0.05;
+  double k[5];
+  for (int j = 0; j < 5; ++j) {
+    std::complex<double> phi = (*this)(std::complex<double>(0.0, -(j - 2) * h), tMat);
+    k[j] = std::log(phi.real());
+  }
+  c1 = (k[0] - 8.0 * k[1] + 8.0 * k[3] - k[4]) / (12.0 * h);
+  c2 = (-k[0] + 16.0 * k[1] - 30.0 * k[2] + 16.0 * k[3] - k[4]) / (12.0 * h * h);
+  c4 = (k[0] - 4.0 * k[1] + 6.0 * k[2] - 4.0 * k[3] + k[4]) / (h * h * h * h);
+  c2 = std::abs(c2);
+  c4 = std::abs(c4);
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_CHARACTERISTICFUNCTION_HPP
@@ -0,0 +1,174 @@
+/**
+@file  fourierpricer.cpp
+@brief Implementation of the FourierPricer class
+*/
+
+#include <qflib/methods/fourier/fourierpricer.hpp>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+BEGIN_NAMESPACE(qf)
+
+namespace {
+
+  const size_t MINCOSTERMS = 256;        // minimum number of automatic cosine terms
+  const double COSTERMSPERWIDTH = 4.0;   // automatic cosine terms per sqrt(c2 + sqrt(c4)) of the truncation range
+
+} // anonymous namespace
+
+FourierPricer::FourierPricer(SPtrCharacteristicFunction charFunc,
+                             SPtrYieldCurve discountCurve,
+                             double divYield,
+                             double spot)
+: charfunc_(charFunc), discyc_(discountCurve), divyld_(divYield), spot_(spot)
+{
+  QF_ASSERT(charfunc_, "FourierPricer: null characteristic function");
+  QF_ASSERT(discyc_, "FourierPricer: null discount curve");
+  QF_ASSERT(spot_ > 0.0, "FourierPricer: spot must be positive");
+}
+
+
+Vector FourierPricer::cosPrices(int payoffType, double timeToExp, Vector const& strikes,
+                                size_t nterms, double truncWidth) const
+{
+  QF_ASSERT(payoffType == 1 || payoffType == -1, "FourierPricer: payoffType must be 1 or -1");
+  QF_ASSERT(timeToExp > 0.0, "FourierPricer: time to expiration must be positive");
+  QF_ASSERT(nterms != 1, "FourierPricer: at least two cosine terms are required");
+  QF_ASSERT(truncWidth > 0.0, "FourierPricer: truncation width must be positive");
+
+  size_t nstrikes = strikes.size();
+  Vector prices(nstrikes);
+  if (nstrikes == 0)
+    return prices;
+
+  double df = discyc_->discount(timeToExp);
+  double fwd = spot_ * std::exp(-divyld_ * timeToExp) / df;
+
+  // log-moneyness x = ln(F/K) of each strike; the terminal value is y = ln(S_T/K) = x + X_T
+  Vector x(nstrikes);
+  for (size_t j = 0; j < nstrikes; ++j) {
+    QF_ASSERT(strikes[j] > 0.0, "FourierPricer: strikes must be positive");
+    x[j] = std::log(fwd / strikes[j]);
+  }
+  double xmin = *std::min_element(x.begin(), x.end());
+  double xmax = *std::max_element(x.begin(), x.end());
+
+  // one truncation range [a, b] for y, wide enough for all strikes,
+  // so that the payoff coefficients are shared by the whole strip
+  double c1, c2, c4;
+  charfunc_->cumulants(timeToExp, c1, c2, c4);
+  double scale = std::sqrt(c2 + std::sqrt(c4));
+  double halfwidth = truncWidth * scale;
+  double a = xmin + c1 - halfwidth;
+  double b = xmax + c1 + halfwidth;
+  double bma = b - a;
+  if (nterms == 0)
+    nterms = std::max(MINCOSTERMS, (size_t) std::ceil(COSTERMSPERWIDTH * bma / scale));
+  double d = std::min(b, 0.0);    // the put pays K(1 - e^y) for y < 0
+
+  // coefficients A_k = phi(u_k) exp(-i u_k a) U_k, where U_k are the cosine coefficients of the unit put payoff
+  vector<double> ar(nterms), ai(nterms);
+  for (size_t k = 0; k < nterms; ++k) {
+    double u = k * M_PI / bma;
+    double uk = 0.0;
+    if (d > a) {
+      double chi = (std::cos(u * (d - a)) * std::exp(d) - std::exp(a)
+                    + u * std::sin(u * (d - a)) * std::exp(d)) / (1.0 + u * u);
+      double psi = (k == 0) ? d - a : std::sin(u * (d - a)) / u;
+      uk = 2.0 / bma * (psi - chi);
+    }
+    complex<double> ak = (*charfunc_)(u, timeToExp) * std::polar(1.0, -u * a) * uk;
+    ar[k] = ak.real();
+    ai[k] = ak.imag();
+  }
+  ar[0] *= 0.5;   // the first term of the cosine sum has half weight
+  ai[0] *= 0.5;
+
+  // sum Re(A_k exp(i u_k x_j)) over k for all strikes at once;
+  // the powers of exp(i pi x_j / (b - a)) are generated by rotation, no trigonometric calls in the loop
+  vector<double> zr(nstrikes), zi(nstrikes), pr(nstrikes, 1.0), pi(nstrikes, 0.0), acc(nstrikes, 0.0);
+  for (size_t j = 0; j < nstrikes; ++j) {
+    zr[j] = std::cos(M_PI * x[j] / bma);
+    zi[j] = std::sin(M_PI * x[j] / bma);
+  }
+  for (size_t k = 0; k < nterms; ++k) {
+    double akr = ar[k], aki = ai[k];
+    for (size_t j = 0; j < nstrikes; ++j) {
+      acc[j] += akr * pr[j] - aki * pi[j];
+      double tmp = pr[j] * zr[j] - pi[j] * zi[j];
+      pi[j] = pr[j] * zi[j] + pi[j] * zr[j];
+      pr[j] = tmp;
+    }
+  }
+
+  for (size_t j = 0; j < nstrikes; ++j) {
+    double put = std::max(strikes[j] * df * acc[j], 0.0);
+    prices[j] = payoffType == -1 ? put : put + df * (fwd - strikes[j]);  // put-call parity
+  }
+  return prices;
+}
+
+
+Vector FourierPricer::fftPrices(int payoffType, double timeToExp, Vector const& strikes,
+                                size_t nfft, double eta, double alpha) const
+{
+  QF_ASSERT(payoffType == 1 || payoffType == -1, "FourierPricer: payoffType must be 1 or -1");
+  QF_ASSERT(timeToExp > 0.0, "FourierPricer: time to expiration must be positive");
+  QF_ASSERT(nfft > 1, "FourierPricer: at least two FFT points are required");
+  QF_ASSERT(eta > 0.0, "FourierPricer: integration grid spacing must be positive");
+  QF_ASSERT(alpha > 0.0, "FourierPricer: damping factor must be positive");
+
+  size_t nstrikes = strikes.size();
+  Vector prices(nstrikes);
+  if (nstrikes == 0)
+    return prices;
+
+  double df = discyc_->discount(timeToExp);
+  double fwd = spot_ * std::exp(-divyld_ * timeToExp) / df;
+
+  // log-strike grid k_u = -bnd + lambda * u, relative to the forward
+  double lambda = 2.0 * M_PI / (nfft * eta);
+  double bnd = 0.5 * nfft * lambda;
+
+  // damped, Simpson weighted integrand
+  const complex<double> i(0.0, 1.0);
+  arma::cx_vec integrand(nfft);
+  for (size_t j = 0; j < nfft; ++j) {
+    double v = j * eta;
+    complex<double> phi = (*charfunc_)(complex<double>(v, -(alpha + 1.0)), timeToExp);
+    complex<double> psi = df * phi / complex<double>(alpha * alpha + alpha - v * v, (2.0 * alpha + 1.0) * v);
+    double simpson = (j == 0) ? 1.0 : (j % 2 == 1 ? 4.0 : 2.0);
+    integrand[j] = std::polar(1.0, v * bnd) * psi * (simpson * eta / 3.0);
+  }
+  arma::cx_vec transf = arma::fft(integrand);
+
+  // undamped call prices on the log-strike grid, for unit forward
+  Vector calls(nfft);
+  for (size_t u = 0; u < nfft; ++u) {
+    double k = -bnd + lambda * u;
+    calls[u] = std::exp(-alpha * k) / M_PI * transf[u].real();
+  }
+
+  // interpolate in log-strike with cubic Lagrange polynomials through the four nearest grid points
+  for (size_t j = 0; j < nstrikes; ++j) {
+    QF_ASSERT(strikes[j] > 0.0, "FourierPricer: strikes must be positive");
+    double k = std::log(strikes[j] / fwd);
+    double pos = (k + bnd) / lambda;
+    QF_ASSERT(pos >= 1.0 && pos < nfft - 2, "FourierPricer: strike outside of the FFT log-strike grid");
+    size_t u = (size_t) pos;
+    double w = pos - u;
+    double call = -w * (w - 1.0) * (w - 2.0) / 6.0 * calls[u - 1]
+                + (w + 1.0) * (w - 1.0) * (w - 2.0) / 2.0 * calls[u]
+                - (w + 1.0) * w * (w - 2.0) / 2.0 * calls[u + 1]
+                + (w + 1.0) * w * (w - 1.0) / 6.0 * calls[u + 2];
+    call *= fwd;
+    call = std::max(call, 0.0);
+    prices[j] = payoffType == 1 ? call : call - df * (fwd - strikes[j]);  // put-call parity
+  }
+  return prices;
+}
+
+END_NAMESPACE(qf)
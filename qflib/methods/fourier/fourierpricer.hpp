@@ -0,0 +1,58 @@
+/**
+@file  fourierpricer.hpp
+@brief Semi-analytic pricing of European options from the characteristic function
+*/
+
+#ifndef QF_FOURIERPRICER_HPP
+#define QF_FOURIERPRICER_HPP
+
+#include <qflib/methods/fourier/characteristicfunction.hpp>
+#include <qflib/market/yieldcurve.hpp>
+#include <qflib/math/matrix.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+/** Prices European calls/puts on a whole strip of strikes in one pass, given the
+    characteristic function of the log-return relative to the forward.
+    Two methods are available:
+      - the COS method of Fang and Oosterlee (2008), a Fourier-cosine expansion of the density;
+      - the FFT method of Carr and Madan (1999), which prices a log-strike grid and interpolates.
+    In both cases the characteristic function is evaluated once per maturity,
+    independently of the number of strikes.
+*/
+class FourierPricer
+{
+public:
+  /** Initializing ctor */
+  FourierPricer(SPtrCharacteristicFunction charFunc,
+                SPtrYieldCurve discountYieldCurve,
+                double divYield,
+                double spot);
+
+  /** Prices of European options with expiration timeToExp for each of the strikes, using the COS method.
+      truncWidth is the half-width of the truncation range around the strikes, in units of sqrt(c2 + sqrt(c4))
+      where c2, c4 are the cumulants of the log-return, and nterms the number of cosine terms.
+      The range spans the whole strip, so wide strips at short expirations need more terms; if nterms is 0,
+      it is chosen as 4 terms per unit of the range, and at least 256.
+      Puts are priced by the expansion and calls by put-call parity.
+  */
+  Vector cosPrices(int payoffType, double timeToExp, Vector const& strikes,
+                   size_t nterms = 0, double truncWidth = 10.0) const;
+
+  /** Prices of European options with expiration timeToExp for each of the strikes, using the Carr-Madan FFT method.
+      nfft is the number of FFT points (preferably a power of 2), eta the spacing of the integration grid and
+      alpha the damping factor. Prices at the strikes are interpolated (cubic) from the log-strike grid.
+  */
+  Vector fftPrices(int payoffType, double timeToExp, Vector const& strikes,
+                   size_t nfft = 4096, double eta = 0.25, double alpha = 1.5) const;
+
+private:
+  SPtrCharacteristicFunction charfunc_;  // pointer to the characteristic function
+  SPtrYieldCurve discyc_;                // pointer to the discount curve
+  double divyld_;                        // the constant dividend yield
+  double spot_;                          // the initial spot
+};
+
+END_NAMESPACE(qf)
+
+#endif // QF_FOURIERPRICER_HPP
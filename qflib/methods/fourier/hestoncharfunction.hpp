@@ -0,0 +1,67 @@
+/**
+@file  hestoncharfunction.hpp
+@brief Characteristic function of the log-return in the Heston stochastic volatility model
+*/
+
+#ifndef QF_HESTONCHARFUNCTION_HPP
+#define QF_HESTONCHARFUNCTION_HPP
+
+#include <qflib/methods/fourier/characteristicfunction.hpp>
+#include <cmath>
+
+BEGIN_NAMESPACE(qf)
+
+/** Characteristic function in the Heston model
+      dS/S = (r - q) dt + sqrt(v) dW1
+      dv   = kappa (theta - v) dt + sigma sqrt(v) dW2,  <dW1, dW2> = rho dt
+    It uses the "little Heston trap" formulation of Albrecher et al. which avoids
+    the branch cut discontinuity of the complex logarithm for long maturities.
+    The cumulants are computed numerically by the base class.
+*/
+class HestonCharFunction : public CharacteristicFunction
+{
+public:
+  /** Initializing ctor */
+  HestonCharFunction(double v0, double kappa, double theta, double sigma, double rho);
+
+  virtual std::complex<double> operator()(std::complex<double> u, double tMat) const override;
+
+private:
+  double v0_;      // initial variance
+  double kappa_;   // mean reversion speed
+  double theta_;   // long term variance
+  double sigma_;   // volatility of variance
+  double rho_;     // spot-variance correlation
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+HestonCharFunction::HestonCharFunction(double v0, double kappa, double theta, double sigma, double rho)
+  : v0_(v0), kappa_(kappa), theta_(theta), sigma_(sigma), rho_(rho)
+{
+  QF_ASSERT(v0 >= 0.0, "HestonCharFunction: initial variance must be non-negative");
+  QF_ASSERT(kappa > 0.0, "HestonCharFunction: mean reversion speed must be positive");
+  QF_ASSERT(theta >= 0.0, "HestonCharFunction: long term variance must be non-negative");
+  QF_ASSERT(sigma > 0.0, "HestonCharFunction: volatility of variance must be positive");
+  QF_ASSERT(rho >= -1.0 && rho <= 1.0, "HestonCharFunction: correlation must be in [-1, 1]");
+}
+
+inline std::complex<double> HestonCharFunction::operator()(std::complex<double> u, double tMat) const
+{
+  const std::complex<double> i(0.0, 1.0);
+  double sig2 = sigma_ * sigma_;
+  std::complex<double> beta = kappa_ - rho_ * sigma_ * i * u;
+  std::complex<double> d = std::sqrt(beta * beta + sig2 * (i * u + u * u));
+  std::complex<double> bmd = beta - d;
+  std::complex<double> g = bmd / (beta + d);
+  std::complex<double> edt = std::exp(-d * tMat);
+  std::complex<double> C = (kappa_ * theta_ / sig2) * (bmd * tMat - 2.0 * std::log((1.0 - g * edt) / (1.0 - g)));
+  std::complex<double> D = (bmd / sig2) * (1.0 - edt) / (1.0 - g * edt);
+  return std::exp(C + D * v0_);
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_HESTONCHARFUNCTION_HPP
@@ -0,0 +1,58 @@
+/**
+@file  backwardinduction.hpp
+@brief Building blocks for backward induction on recombining trees
+*/
+
+#ifndef QF_BACKWARDINDUCTION_HPP
+#define QF_BACKWARDINDUCTION_HPP
+
+#include <qflib/defines.hpp>
+#include <algorithm>
+#include <cmath>
+
+BEGIN_NAMESPACE(qf)
+
+/** One binomial backward step, in place on the values of n + 1 nodes:
+      v[j] = pd * v[j] + pu * v[j+1],  j = 0, ..., n-1
+    The probabilities include the one-step discount factor.
+    Each v[j] only reads v[j+1], which is not yet overwritten, so the loop vectorizes.
+*/
+inline void binomialStep(double* v, size_t n, double pu, double pd)
+{
+  for (size_t j = 0; j < n; ++j)
+    v[j] = pd * v[j] + pu * v[j + 1];
+}
+
+/** One trinomial backward step, in place on the values of n + 2 nodes:
+      v[k] = pd * v[k] + pm * v[k+1] + pu * v[k+2],  k = 0, ..., n-1
+    The probabilities include the one-step discount factor.
+*/
+inline void trinomialStep(double* v, size_t n, double pu, double pm, double pd)
+{
+  for (size_t k = 0; k < n; ++k)
+    v[k] = pd * v[k] + pm * v[k + 1] + pu * v[k + 2];
+}
+
+/** Applies early exercise on n nodes whose spots are scale * pw[j]:
+      v[j] = max(v[j], max(payoffType * (scale * pw[j] - strike), 0))
+*/
+inline void applyExercise(double* v, double const* pw, size_t n, double scale, double strike, int payoffType)
+{
+  double phi = payoffType;
+  for (size_t j = 0; j < n; ++j) {
+    double exer = phi * (scale * pw[j] - strike);
+    v[j] = std::max(v[j], std::max(exer, 0.0));
+  }
+}
+
+/** Peizer-Pratt method 2 inversion of the normal cdf, used by the Leisen-Reimer tree with n steps (n odd) */
+inline double peizerPrattInversion(double z, size_t n)
+{
+  double a = z / (n + 1.0 / 3.0 + 0.1 / (n + 1.0));
+  double h = 0.5 * std::sqrt(1.0 - std::exp(-a * a * (n + 1.0 / 6.0)));
+  return z >= 0.0 ? 0.5 + h : 0.5 - h;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_BACKWARDINDUCTION_HPP
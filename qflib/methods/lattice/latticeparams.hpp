@@ -0,0 +1,47 @@
+/**
+@file  latticeparams.hpp
+@brief Recombining tree parameters
+*/
+
+#ifndef QF_LATTICEPARAMS_HPP
+#define QF_LATTICEPARAMS_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+
+/** Recombining tree parameters
+*/
+struct LatticeParams
+{
+  /** The known tree types */
+  enum class TreeType
+  {
+    CRR,           // Cox-Ross-Rubinstein binomial
+    LEISENREIMER,  // Leisen-Reimer binomial (the number of steps is rounded up to an odd number)
+    TRINOMIAL      // moment matched trinomial
+  };
+
+  /** Default ctor */
+  LatticeParams(TreeType t = TreeType::LEISENREIMER, size_t nsteps = 201);
+
+  // state
+  TreeType treeType;
+  size_t nSteps;     // number of time steps
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+LatticeParams::LatticeParams(TreeType t, size_t nsteps)
+: treeType(t), nSteps(nsteps)
+{
+  QF_ASSERT(nSteps >= 3, "LatticeParams: at least 3 time steps are required");
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_LATTICEPARAMS_HPP
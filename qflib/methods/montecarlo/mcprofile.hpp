@@ -0,0 +1,152 @@
+/**
+@file  mcprofile.hpp
+@brief Timing of the phases of a Monte Carlo simulation
+*/
+
+#ifndef QF_MCPROFILE_HPP
+#define QF_MCPROFILE_HPP
+
+#include <qflib/defines.hpp>
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define QF_MC_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QF_MC_RDTSC
+#endif
+
+/** Macro marking the end of a phase of a Monte Carlo path, e.g. QF_MC_MARK(timer_, RNG)
+    It compiles to nothing unless QF_MC_PROFILE is defined, e.g. with cmake -DQF_MC_PROFILE=ON.
+*/
+#ifdef QF_MC_PROFILE
+#define QF_MC_MARK(timer, phase) (timer).mark(qf::McPhaseTimer::phase)
+#else
+#define QF_MC_MARK(timer, phase) ((void) 0)
+#endif
+
+BEGIN_NAMESPACE(qf)
+
+/** Where the time of the Monte Carlo simulations went, accumulated over the calls to simulate.
+    It is filled only when the library is compiled with QF_MC_PROFILE defined; otherwise it stays empty.
+*/
+struct McProfile
+{
+  /** True if the library was compiled with the profiling */
+#ifdef QF_MC_PROFILE
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  double rngTime = 0.0;       // seconds spent generating the normal deviates
+  double pathTime = 0.0;      // seconds spent building the price paths from the deviates
+  double productTime = 0.0;   // seconds spent evaluating the product and discounting its payments
+  double statsTime = 0.0;     // seconds spent accumulating the statistics
+  double totalTime = 0.0;     // wall time of the simulations
+  unsigned long nPaths = 0;
+  unsigned long nNormals = 0;
+
+  /** Returns the number of paths simulated per second */
+  double pathsPerSec() const { return totalTime > 0.0 ? nPaths / totalTime : 0.0; }
+
+  /** Returns the number of normal deviates drawn per second */
+  double normalsPerSec() const { return totalTime > 0.0 ? nNormals / totalTime : 0.0; }
+
+  /** Clears the profile */
+  void reset() { *this = McProfile(); }
+};
+
+/** Splits the wall time of a simulation among its phases.
+    One path in SAMPLING is timed: each of its marks charges the time since the previous mark to a phase,
+    reading the time stamp counter where available; the marks of the other paths only test a flag.
+    stop splits the wall time of the whole simulation in proportion to the sampled times.
+*/
+class McPhaseTimer
+{
+public:
+  /** The phases of a path */
+  enum Phase { RNG, PATH, PRODUCT, STATS, NPHASES };
+
+  /** The sampling period */
+  static const unsigned long SAMPLING = 16;
+
+  /** Starts timing a simulation */
+  void start();
+
+  /** Starts path i; the marks of the path are timed if i is a multiple of SAMPLING */
+  void beginPath(unsigned long i);
+
+  /** Charges the time since the previous mark of the path, or since beginPath, to the phase */
+  void mark(Phase phase);
+
+  /** Stops timing and adds the times and the counts of the simulation to the profile */
+  void stop(McProfile& profile, unsigned long npaths, unsigned long nnormals);
+
+private:
+  // returns the current count of the time stamp counter, or of the steady clock
+  static std::uint64_t ticks();
+
+  std::chrono::steady_clock::time_point wallStart_;
+  bool active_ = false;
+  std::uint64_t last_ = 0;
+  std::uint64_t phaseTicks_[NPHASES] = {};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline std::uint64_t McPhaseTimer::ticks()
+{
+#ifdef QF_MC_RDTSC
+  return __rdtsc();
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+inline void McPhaseTimer::start()
+{
+  for (std::uint64_t& t : phaseTicks_)
+    t = 0;
+  active_ = false;
+  wallStart_ = std::chrono::steady_clock::now();
+}
+
+inline void McPhaseTimer::beginPath(unsigned long i)
+{
+  active_ = i % SAMPLING == 0;
+  if (active_)
+    last_ = ticks();
+}
+
+inline void McPhaseTimer::mark(Phase phase)
+{
+  if (!active_)
+    return;
+  std::uint64_t now = ticks();
+  phaseTicks_[phase] += now - last_;
+  last_ = now;
+}
+
+inline void McPhaseTimer::stop(McProfile& profile, unsigned long npaths, unsigned long nnormals)
+{
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart_).count();
+  std::uint64_t sampled = 0;
+  for (std::uint64_t t : phaseTicks_)
+    sampled += t;
+  double secsPerTick = sampled > 0 ? wall / sampled : 0.0;
+  profile.rngTime += phaseTicks_[RNG] * secsPerTick;
+  profile.pathTime += phaseTicks_[PATH] * secsPerTick;
+  profile.productTime += phaseTicks_[PRODUCT] * secsPerTick;
+  profile.statsTime += phaseTicks_[STATS] * secsPerTick;
+  profile.totalTime += wall;
+  profile.nPaths += npaths;
+  profile.nNormals += nnormals;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_MCPROFILE_HPP
@@ -0,0 +1,75 @@
+/**
+@file  pdegrid.hpp
+@brief Non-uniform one dimensional grids for finite difference methods
+*/
+
+#ifndef QF_PDEGRID_HPP
+#define QF_PDEGRID_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/math/matrix.hpp>
+#include <cmath>
+
+BEGIN_NAMESPACE(qf)
+
+/** Returns a grid of n nodes on [xmin, xmax], concentrated around the critical points [ptsFirst, ptsLast).
+    The node density is proportional to 
+      rho(x) = 1 + intensity * sum_k 1 / sqrt(1 + ((x - p_k) / width)^2),
+    i.e. it is (1 + intensity) times higher at an isolated critical point than far away from all of them.
+    The nodes are x_i = G^{-1}(i / (n - 1)), where G is the normalized integral of rho.
+    The end points are reproduced exactly; intensity = 0 gives a uniform grid.
+*/
+template<typename ITER>
+Vector concentratedGrid(double xmin, double xmax, size_t n,
+                        ITER ptsFirst, ITER ptsLast, double intensity, double width)
+{
+  QF_ASSERT(xmin < xmax, "concentratedGrid: xmin must be less than xmax");
+  QF_ASSERT(n >= 2, "concentratedGrid: at least two nodes are required");
+  QF_ASSERT(width > 0.0, "concentratedGrid: the concentration width must be positive");
+
+  // the primitive of rho, zero at xmin
+  auto G = [&](double x) {
+    double g = x - xmin;
+    for (ITER it = ptsFirst; it != ptsLast; ++it)
+      g += intensity * width * (std::asinh((x - *it) / width) - std::asinh((xmin - *it) / width));
+    return g;
+  };
+  auto rho = [&](double x) {
+    double r = 1.0;
+    for (ITER it = ptsFirst; it != ptsLast; ++it) {
+      double z = (x - *it) / width;
+      r += intensity / std::sqrt(1.0 + z * z);
+    }
+    return r;
+  };
+
+  Vector grid(n);
+  grid[0] = xmin;
+  grid[n - 1] = xmax;
+  double gmax = G(xmax);
+  double x = xmin;
+  for (size_t i = 1; i < n - 1; ++i) {
+    // G is increasing; solve G(x) = target with safeguarded Newton steps starting from the previous node
+    double target = gmax * i / (n - 1);
+    double lo = grid[i - 1], hi = xmax;
+    for (int iter = 0; iter < 50; ++iter) {
+      double f = G(x) - target;
+      if (f > 0.0) hi = x; else lo = x;
+      double xnew = x - f / rho(x);
+      if (xnew <= lo || xnew >= hi)
+        xnew = 0.5 * (lo + hi);
+      if (std::abs(xnew - x) < 1.0e-14 * (1.0 + std::abs(x))) {
+        x = xnew;
+        break;
+      }
+      x = xnew;
+    }
+    grid[i] = x;
+  }
+  return grid;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_PDEGRID_HPP
@@ -0,0 +1,47 @@
+/**
+@file  pdeparams.hpp
+@brief Finite difference PDE parameters
+*/
+
+#ifndef QF_PDEPARAMS_HPP
+#define QF_PDEPARAMS_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+
+/** Finite difference PDE parameters
+*/
+struct PdeParams
+{
+  /** Default ctor */
+  PdeParams(size_t nspace = 401, size_t ntime = 200, size_t nrannacher = 2,
+            double nstdevs = 5.0, double concentration = 5.0);
+
+  // state
+  size_t nSpaceNodes;      // number of nodes of the spatial grid, including the boundaries
+  size_t nTimeSteps;       // number of time steps
+  size_t nRannacherSteps;  // number of initial Crank-Nicolson steps replaced by two implicit half steps
+  double nStdevs;          // half-width of the grid in standard deviations of the log-spot
+  double concentration;    // grid density at the critical points relative to the density far away, minus one
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+PdeParams::PdeParams(size_t nspace, size_t ntime, size_t nrannacher, double nstdevs, double concentration)
+: nSpaceNodes(nspace), nTimeSteps(ntime), nRannacherSteps(nrannacher), 
+  nStdevs(nstdevs), concentration(concentration)
+{
+  QF_ASSERT(nSpaceNodes >= 5, "PdeParams: at least 5 space nodes are required");
+  QF_ASSERT(nTimeSteps >= 1, "PdeParams: at least one time step is required");
+  QF_ASSERT(nStdevs > 0.0, "PdeParams: the grid width must be positive");
+  QF_ASSERT(concentration >= 0.0, "PdeParams: the grid concentration must be non-negative");
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_PDEPARAMS_HPP
@@ -0,0 +1,119 @@
+/**
+@file  tridiagonalsolver.hpp
+@brief Thomas algorithm for tridiagonal linear systems, with an optional early exercise constraint
+*/
+
+#ifndef QF_TRIDIAGONALSOLVER_HPP
+#define QF_TRIDIAGONALSOLVER_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/math/matrix.hpp>
+#include <algorithm>
+
+BEGIN_NAMESPACE(qf)
+
+/** Solves the tridiagonal system 
+      lower[i] * x[i-1] + diag[i] * x[i] + upper[i] * x[i+1] = rhs[i],  i = 0, ..., n-1
+    with the Thomas algorithm; lower[0] and upper[n-1] are ignored.
+    The scratch buffers are allocated once at construction, so that repeated solves 
+    (e.g. one per time step) do not allocate.
+*/
+class TridiagonalSolver
+{
+public:
+  /** Ctor for systems of size n */
+  explicit TridiagonalSolver(size_t n);
+
+  /** Returns the size of the system */
+  size_t size() const;
+
+  /** Solves the system; x must have size n and may not alias the inputs */
+  void solve(Vector const& lower, Vector const& diag, Vector const& upper,
+             Vector const& rhs, Vector& x);
+
+  /** Solves the linear complementarity problem x >= obstacle with the Brennan-Schwartz algorithm.
+      If exerciseBelow is true the exercise region is assumed to lie at the low end of the grid (e.g. puts),
+      otherwise at the high end (e.g. calls). The elimination starts from the continuation side and
+      the constraint is applied during substitution.
+  */
+  void solveProjected(Vector const& lower, Vector const& diag, Vector const& upper,
+                      Vector const& rhs, Vector const& obstacle, bool exerciseBelow, Vector& x);
+
+private:
+  Vector cp_;  // modified off-diagonal coefficients
+  Vector dp_;  // modified right hand side
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+TridiagonalSolver::TridiagonalSolver(size_t n)
+  : cp_(n), dp_(n)
+{
+  QF_ASSERT(n >= 1, "TridiagonalSolver: empty system");
+}
+
+inline size_t TridiagonalSolver::size() const
+{
+  return cp_.size();
+}
+
+inline void TridiagonalSolver::solve(Vector const& lower, Vector const& diag, Vector const& upper,
+                                     Vector const& rhs, Vector& x)
+{
+  size_t n = size();
+  // forward elimination
+  double m = diag[0];
+  cp_[0] = upper[0] / m;
+  dp_[0] = rhs[0] / m;
+  for (size_t i = 1; i < n; ++i) {
+    m = diag[i] - lower[i] * cp_[i - 1];
+    cp_[i] = upper[i] / m;
+    dp_[i] = (rhs[i] - lower[i] * dp_[i - 1]) / m;
+  }
+  // back substitution
+  x[n - 1] = dp_[n - 1];
+  for (size_t i = n - 1; i-- > 0; )
+    x[i] = dp_[i] - cp_[i] * x[i + 1];
+}
+
+inline void TridiagonalSolver::solveProjected(Vector const& lower, Vector const& diag, Vector const& upper,
+                                              Vector const& rhs, Vector const& obstacle, 
+                                              bool exerciseBelow, Vector& x)
+{
+  size_t n = size();
+  if (!exerciseBelow) {
+    // eliminate from the bottom, substitute from the top
+    double m = diag[0];
+    cp_[0] = upper[0] / m;
+    dp_[0] = rhs[0] / m;
+    for (size_t i = 1; i < n; ++i) {
+      m = diag[i] - lower[i] * cp_[i - 1];
+      cp_[i] = upper[i] / m;
+      dp_[i] = (rhs[i] - lower[i] * dp_[i - 1]) / m;
+    }
+    x[n - 1] = std::max(dp_[n - 1], obstacle[n - 1]);
+    for (size_t i = n - 1; i-- > 0; )
+      x[i] = std::max(dp_[i] - cp_[i] * x[i + 1], obstacle[i]);
+  }
+  else {
+    // eliminate from the top, substitute from the bottom; cp_ now holds the coefficients of x[i-1]
+    double m = diag[n - 1];
+    cp_[n - 1] = lower[n - 1] / m;
+    dp_[n - 1] = rhs[n - 1] / m;
+    for (size_t i = n - 1; i-- > 0; ) {
+      m = diag[i] - upper[i] * cp_[i + 1];
+      cp_[i] = lower[i] / m;
+      dp_[i] = (rhs[i] - upper[i] * dp_[i + 1]) / m;
+    }
+    x[0] = std::max(dp_[0], obstacle[0]);
+    for (size_t i = 1; i < n; ++i)
+      x[i] = std::max(dp_[i] - cp_[i] * x[i - 1], obstacle[i]);
+  }
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_TRIDIAGONALSOLVER_HPP
@@ -0,0 +1,224 @@
+/**
+@file  batchpricers.cpp
+@brief Implementation of pricing functions over arrays of trades
+*/
+
+#include <qflib/pricers/batchpricers.hpp>
+#include <qflib/math/stats/normalkernels.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+BEGIN_NAMESPACE(qf)
+
+namespace {
+
+  // number of options per block; the block scratch arrays live on the stack
+  const size_t BLOCKSIZE = 256;
+
+  /** Prices one block of m <= BLOCKSIZE options starting at offset i0 */
+  void europeanOptionBSBlock(size_t i0, size_t m, int const* payoffType, double const* spot, double const* strike,
+                             double const* timeToExp, double const* intRate, double const* divYield,
+                             double const* volatility,
+                             double* price, double* delta, double* gamma, double* theta, double* vega)
+  {
+    const double epsilon = 1.0e-012;  // a very small hard-coded number
+
+    double phi[BLOCKSIZE], sqrtT[BLOCKSIZE], d1[BLOCKSIZE], d2[BLOCKSIZE];
+    double df[BLOCKSIZE], qf[BLOCKSIZE], nd1[BLOCKSIZE], nd2[BLOCKSIZE], nprd1[BLOCKSIZE];
+
+    // stage 1: forwards, discount factors and d1, d2
+    QF_SIMD
+    for (size_t j = 0; j < m; ++j) {
+      size_t i = i0 + j;
+      double t = timeToExp[i];
+      phi[j] = payoffType[i];
+      sqrtT[j] = std::sqrt(t);
+      double sigT = volatility[i] * sqrtT[j];
+      df[j] = fastExp(-intRate[i] * t);
+      qf[j] = fastExp(-divYield[i] * t);
+      double lnfk = fastLog(spot[i] * qf[j] / (df[j] * strike[i]));
+      d1[j] = lnfk / sigT + 0.5 * sigT;
+      d2[j] = d1[j] - sigT;
+    }
+
+    // stage 2: the normal cdf and density, with the branch-free kernels
+    QF_SIMD
+    for (size_t j = 0; j < m; ++j) {
+      nd1[j] = normalCdf(phi[j] * d1[j]);
+      nd2[j] = normalCdf(phi[j] * d2[j]);
+      nprd1[j] = normalPdf(d1[j]);
+    }
+
+    // stage 3: price and Greeks, one loop per requested output
+    if (price) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        price[i] = phi[j] * (qf[j] * spot[i] * nd1[j] - df[j] * strike[i] * nd2[j]);
+      }
+    }
+    if (delta) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j)
+        delta[i0 + j] = phi[j] * qf[j] * nd1[j];
+    }
+    if (gamma) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        double sigT = volatility[i] * sqrtT[j];
+        double g = qf[j] * nprd1[j] / (spot[i] * sigT);
+        gamma[i] = sigT < epsilon ? 0.0 : g;
+      }
+    }
+    if (theta) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        double qs = qf[j] * spot[i];
+        double th = -qs * nprd1[j] * volatility[i] / (2.0 * sqrtT[j]);
+        th += phi[j] * divYield[i] * qs * nd1[j];
+        th -= phi[j] * intRate[i] * df[j] * strike[i] * nd2[j];
+        theta[i] = sqrtT[j] < epsilon ? 0.0 : th;
+      }
+    }
+    if (vega) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        vega[i] = qf[j] * spot[i] * sqrtT[j] * nprd1[j];
+      }
+    }
+  }
+
+  /** Prices one block of m <= BLOCKSIZE digital options starting at offset i0 */
+  void digitalOptionBSBlock(size_t i0, size_t m, int const* payoffType, double const* spot, double const* strike,
+                            double const* timeToExp, double const* intRate, double const* divYield,
+                            double const* volatility,
+                            double* price, double* delta, double* gamma, double* theta, double* vega)
+  {
+    const double epsilon = 1.0e-012;  // a very small hard-coded number
+
+    double phi[BLOCKSIZE], sqrtT[BLOCKSIZE], sigT[BLOCKSIZE], fwd[BLOCKSIZE], lnfk[BLOCKSIZE];
+    double df[BLOCKSIZE], nd2[BLOCKSIZE], nprd2[BLOCKSIZE];
+
+    // stage 1: forwards, discount factors and d2
+    QF_SIMD
+    for (size_t j = 0; j < m; ++j) {
+      size_t i = i0 + j;
+      double t = timeToExp[i];
+      phi[j] = payoffType[i];
+      sqrtT[j] = std::sqrt(t);
+      sigT[j] = volatility[i] * sqrtT[j];
+      df[j] = fastExp(-intRate[i] * t);
+      fwd[j] = spot[i] * fastExp(-divYield[i] * t) / df[j];
+      lnfk[j] = fastLog(fwd[j] / strike[i]);
+    }
+
+    // stage 2: the normal cdf and density, with the branch-free kernels
+    QF_SIMD
+    for (size_t j = 0; j < m; ++j) {
+      double d2 = lnfk[j] / sigT[j] - 0.5 * sigT[j];
+      nd2[j] = normalCdf(phi[j] * d2);
+      nprd2[j] = normalPdf(d2);
+    }
+
+    // stage 3: price and Greeks, one loop per requested output; as in digitalOptionBSGreeks,
+    // the Greeks are zero when the total volatility vanishes
+    if (price) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j)
+        price[i0 + j] = df[j] * nd2[j];
+    }
+    if (delta) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        double d = phi[j] * df[j] * nprd2[j] / (spot[i] * sigT[j]);
+        delta[i] = sigT[j] < epsilon ? 0.0 : d;
+      }
+    }
+    if (gamma) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        double d1 = fastLog(fwd[j] / (strike[i] + epsilon)) / sigT[j] + 0.5 * sigT[j];
+        double g = -phi[j] * df[j] * d1 * nprd2[j] / (spot[i] * spot[i] * sigT[j] * sigT[j]);
+        gamma[i] = sigT[j] < epsilon ? 0.0 : g;
+      }
+    }
+    if (theta) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        double t = timeToExp[i];
+        double sig2 = volatility[i] * volatility[i];
+        double th = intRate[i] * df[j] * nd2[j];
+        th += phi[j] * df[j] * nprd2[j] * (fastLog(spot[i] / (strike[i] + epsilon)) / t
+                                           - (intRate[i] - divYield[i] - sig2 / 2)) / 2.0 / sigT[j];
+        theta[i] = sigT[j] < epsilon ? 0.0 : th;
+      }
+    }
+    if (vega) {
+      QF_SIMD
+      for (size_t j = 0; j < m; ++j) {
+        size_t i = i0 + j;
+        double v = -phi[j] * df[j] * strike[i] * sqrtT[j] * nprd2[j];
+        v *= 0.5 + lnfk[j] / (sigT[j] * sigT[j]);
+        vega[i] = sigT[j] < epsilon ? 0.0 : v;
+      }
+    }
+  }
+
+} // anonymous namespace
+
+void europeanOptionBSBatch(size_t n, int const* payoffType, double const* spot, double const* strike,
+                           double const* timeToExp, double const* intRate, double const* divYield,
+                           double const* volatility,
+                           double* price, double* delta, double* gamma, double* theta, double* vega)
+{
+  // validate up front, so that no exception can escape from the parallel region
+  for (size_t i = 0; i < n; ++i) {
+    bool ok = (payoffType[i] == 1 || payoffType[i] == -1) && spot[i] >= 0.0 && strike[i] >= 0.0
+      && timeToExp[i] >= 0.0 && intRate[i] >= 0.0 && divYield[i] >= 0.0 && volatility[i] >= 0.0;
+    QF_ASSERT(ok, "europeanOptionBSBatch: invalid inputs for option " + std::to_string(i));
+  }
+
+  long nblocks = static_cast<long>((n + BLOCKSIZE - 1) / BLOCKSIZE);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (long b = 0; b < nblocks; ++b) {
+    size_t i0 = static_cast<size_t>(b) * BLOCKSIZE;
+    size_t m = std::min(BLOCKSIZE, n - i0);
+    europeanOptionBSBlock(i0, m, payoffType, spot, strike, timeToExp, intRate, divYield, volatility,
+                          price, delta, gamma, theta, vega);
+  }
+}
+
+void digitalOptionBSBatch(size_t n, int const* payoffType, double const* spot, double const* strike,
+                          double const* timeToExp, double const* intRate, double const* divYield,
+                          double const* volatility,
+                          double* price, double* delta, double* gamma, double* theta, double* vega)
+{
+  // validate up front, so that no exception can escape from the parallel region
+  for (size_t i = 0; i < n; ++i) {
+    bool ok = (payoffType[i] == 1 || payoffType[i] == -1) && spot[i] >= 0.0 && strike[i] >= 0.0
+      && timeToExp[i] >= 0.0 && intRate[i] >= 0.0 && divYield[i] >= 0.0 && volatility[i] >= 0.0;
+    QF_ASSERT(ok, "digitalOptionBSBatch: invalid inputs for option " + std::to_string(i));
+  }
+
+  long nblocks = static_cast<long>((n + BLOCKSIZE - 1) / BLOCKSIZE);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (long b = 0; b < nblocks; ++b) {
+    size_t i0 = static_cast<size_t>(b) * BLOCKSIZE;
+    size_t m = std::min(BLOCKSIZE, n - i0);
+    digitalOptionBSBlock(i0, m, payoffType, spot, strike, timeToExp, intRate, divYield, volatility,
+                         price, delta, gamma, theta, vega);
+  }
+}
+
+END_NAMESPACE(qf)
@@ -0,0 +1,36 @@
+/**
+@file  batchpricers.hpp
+@brief Declaration of pricing functions over arrays of trades
+*/
+
+#ifndef QF_BATCHPRICERS_HPP
+#define QF_BATCHPRICERS_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <cstddef>
+
+BEGIN_NAMESPACE(qf)
+
+/** Prices and Greeks of n European options in the Black-Scholes model.
+    The inputs are arrays of size n (structure of arrays), with the same conventions as europeanOptionBS.
+    The results are written to caller-owned arrays of size n; a null output pointer skips that output.
+    The options are processed in blocks, in parallel when OpenMP is available, without allocating.
+    All inputs are validated before any output is written.
+*/
+void europeanOptionBSBatch(size_t n, int const* payoffType, double const* spot, double const* strike,
+                           double const* timeToExp, double const* intRate, double const* divYield,
+                           double const* volatility,
+                           double* price, double* delta, double* gamma, double* theta, double* vega);
+
+/** Prices and Greeks of n European digital options in the Black-Scholes model.
+    The inputs, outputs and processing are as in europeanOptionBSBatch, with the conventions of digitalOptionBS.
+*/
+void digitalOptionBSBatch(size_t n, int const* payoffType, double const* spot, double const* strike,
+                          double const* timeToExp, double const* intRate, double const* divYield,
+                          double const* volatility,
+                          double* price, double* delta, double* gamma, double* theta, double* vega);
+
+END_NAMESPACE(qf)
+
+#endif // QF_BATCHPRICERS_HPP
@@ -0,0 +1,245 @@
+/**
+@file  bslatticepricer.cpp
+@brief Implementation of the BsLatticePricer class
+*/
+
+#include <qflib/pricers/bslatticepricer.hpp>
+#include <qflib/methods/lattice/backwardinduction.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+BEGIN_NAMESPACE(qf)
+
+// Constructor for constant volatility
+BsLatticePricer::BsLatticePricer(
+    int payoffType,
+    double strike,
+    double timeToExp,
+    ExerciseType exerType,
+    Vector const& exerTimes,
+    SPtrYieldCurve discountCurve,
+    double divYield,
+    double vol,
+    double spot,
+    LatticeParams latticeparams)
+: payoffType_(payoffType), strike_(strike), texp_(timeToExp), exerType_(exerType),
+  discyc_(discountCurve), divyld_(divYield), vol_(vol), volTS_(nullptr),
+  spot_(spot), params_(latticeparams)
+{
+  QF_ASSERT(vol_ > 0.0, "BsLatticePricer: the volatility must be positive");
+  init(exerTimes);
+}
+
+// Constructor for a volatility term structure
+BsLatticePricer::BsLatticePricer(
+    int payoffType,
+    double strike,
+    double timeToExp,
+    ExerciseType exerType,
+    Vector const& exerTimes,
+    SPtrYieldCurve discountCurve,
+    double divYield,
+    SPtrVolatilityTermStructure volTS,
+    double spot,
+    LatticeParams latticeparams)
+: payoffType_(payoffType), strike_(strike), texp_(timeToExp), exerType_(exerType),
+  discyc_(discountCurve), divyld_(divYield), vol_(0.0), volTS_(volTS),
+  spot_(spot), params_(latticeparams)
+{
+  QF_ASSERT(volTS_, "BsLatticePricer: null volatility term structure");
+  init(exerTimes);
+}
+
+double BsLatticePricer::totalVariance(double t) const
+{
+  if (!volTS_)
+    return vol_ * vol_ * t;
+  double sig = volTS_->spotVol(t);
+  return sig * sig * t;
+}
+
+void BsLatticePricer::init(Vector const& exerTimes)
+{
+  QF_ASSERT(payoffType_ == 1 || payoffType_ == -1, "BsLatticePricer: payoff type must be 1 or -1");
+  QF_ASSERT(strike_ > 0.0, "BsLatticePricer: strike must be positive");
+  QF_ASSERT(texp_ > 0.0, "BsLatticePricer: time to expiration must be positive");
+  QF_ASSERT(spot_ > 0.0, "BsLatticePricer: spot must be positive");
+  QF_ASSERT(discyc_, "BsLatticePricer: null discount curve");
+
+  bool trinomial = params_.treeType == LatticeParams::TreeType::TRINOMIAL;
+  nsteps_ = params_.nSteps;
+  if (params_.treeType == LatticeParams::TreeType::LEISENREIMER && nsteps_ % 2 == 0)
+    ++nsteps_;
+  size_t n = nsteps_;
+
+  // time steps of equal variance; the total variance is piecewise linear in time for the 
+  // piecewise constant forward variances, so the Illinois method converges in a few iterations
+  double wtot = totalVariance(texp_);
+  QF_ASSERT(wtot > 0.0, "BsLatticePricer: the total variance must be positive");
+  double dw = wtot / n;
+  times_.resize(n + 1);
+  times_[0] = 0.0;
+  times_[n] = texp_;
+  if (!volTS_) {
+    for (size_t i = 1; i < n; ++i)
+      times_[i] = texp_ * i / n;
+  }
+  else {
+    double a = 0.0, wa = 0.0;
+    for (size_t i = 1; i < n; ++i) {
+      double target = dw * i;
+      double b = texp_, wb = wtot;
+      double t = a;
+      int side = 0;
+      for (int iter = 0; iter < 100; ++iter) {
+        t = a + (target - wa) * (b - a) / (wb - wa);
+        double f = totalVariance(t) - target;
+        if (abs(f) <= 1.0e-14 * wtot || b - a <= 1.0e-14 * texp_)
+          break;
+        if (f > 0.0) {
+          b = t; wb = f + target;
+          if (side == 1) wa = target + 0.5 * (wa - target);
+          side = 1;
+        }
+        else {
+          a = t; wa = f + target;
+          if (side == -1) wb = target + 0.5 * (wb - target);
+          side = -1;
+        }
+      }
+      times_[i] = t;
+      a = t;
+      wa = totalVariance(t);
+    }
+  }
+
+  // branching for the driftless ratio X = S / F
+  double lnu, lnd;
+  if (params_.treeType == LatticeParams::TreeType::CRR) {
+    lnu = sqrt(dw);
+    lnd = -lnu;
+    pu_ = (1.0 - exp(lnd)) / (exp(lnu) - exp(lnd));
+    pd_ = 1.0 - pu_;
+    pm_ = 0.0;
+  }
+  else if (params_.treeType == LatticeParams::TreeType::LEISENREIMER) {
+    double fwd = spot_ * exp(-divyld_ * texp_) / discyc_->discount(texp_);
+    double d1 = (log(fwd / strike_) + 0.5 * wtot) / sqrt(wtot);
+    double d2 = d1 - sqrt(wtot);
+    pu_ = peizerPrattInversion(d2, n);
+    double u = peizerPrattInversion(d1, n) / pu_;
+    double d = (1.0 - pu_ * u) / (1.0 - pu_);
+    lnu = log(u);
+    lnd = log(d);
+    pd_ = 1.0 - pu_;
+    pm_ = 0.0;
+  }
+  else {
+    // log step sqrt(3 dw); the price is a martingale and the log variance matches dw + dw^2 / 4
+    lnu = sqrt(3.0 * dw);
+    lnd = -lnu;
+    double u = exp(lnu);
+    double s = (dw + 0.25 * dw * dw) / (lnu * lnu);
+    pu_ = s / (1.0 + u);
+    pd_ = s * u / (1.0 + u);
+    pm_ = 1.0 - s;
+  }
+
+  // discount factors, forwards and node spots: the lowest node at step i is F_i d^i
+  size_t nnodes = trinomial ? 2 * n + 1 : n + 1;
+  disc_.resize(n);
+  scale_.resize(n + 1);
+  double df1 = 1.0;
+  for (size_t i = 0; i <= n; ++i) {
+    double t = times_[i];
+    double df2 = discyc_->discount(t);
+    if (i > 0)
+      disc_[i - 1] = df2 / df1;
+    df1 = df2;
+    scale_[i] = spot_ * exp(-divyld_ * t) / df2 * exp(lnd * i);
+  }
+  pw_.resize(nnodes);
+  double lnstep = trinomial ? lnu : lnu - lnd;
+  for (size_t j = 0; j < nnodes; ++j)
+    pw_[j] = exp(lnstep * j);
+
+  // exercise steps
+  exercisable_.assign(n + 1, 0);
+  exercisable_[n] = 1;
+  if (exerType_ == ExerciseType::AMERICAN) {
+    std::fill(exercisable_.begin(), exercisable_.end(), 1);
+  }
+  else if (exerType_ == ExerciseType::BERMUDAN) {
+    for (double t : exerTimes) {
+      QF_ASSERT(t >= 0.0 && t <= texp_, "BsLatticePricer: exercise times must be between 0 and expiration");
+      size_t i = upper_bound(times_.begin(), times_.end(), t) - times_.begin();
+      if (i > n || (i > 0 && t - times_[i - 1] < times_[i] - t))
+        --i;
+      exercisable_[i] = 1;
+    }
+  }
+
+  v_.resize(nnodes);
+}
+
+Vector BsLatticePricer::solve()
+{
+  bool trinomial = params_.treeType == LatticeParams::TreeType::TRINOMIAL;
+  size_t n = nsteps_;
+  double* v = v_.memptr();
+  double const* pw = pw_.memptr();
+
+  // terminal payoff
+  size_t nnodes = trinomial ? 2 * n + 1 : n + 1;
+  std::fill(v, v + nnodes, 0.0);
+  applyExercise(v, pw, nnodes, scale_[n], strike_, payoffType_);
+
+  // backward induction, keeping the values of the first two steps for the Greeks
+  double v1[3] = { 0.0, 0.0, 0.0 }, v2[3] = { 0.0, 0.0, 0.0 };
+  for (size_t i = n; i-- > 0; ) {
+    double df = disc_[i];
+    size_t m = trinomial ? 2 * i + 1 : i + 1;  // number of nodes at step i
+    if (trinomial)
+      trinomialStep(v, m, df * pu_, df * pm_, df * pd_);
+    else
+      binomialStep(v, m, df * pu_, df * pd_);
+    if (exercisable_[i])
+      applyExercise(v, pw, m, scale_[i], strike_, payoffType_);
+    if (i == 2)
+      std::copy(v, v + 3, v2);
+    else if (i == 1)
+      std::copy(v, v + min(m, size_t(3)), v1);
+  }
+  double price = v[0];
+
+  double delta, gamma, theta;
+  if (trinomial) {
+    // three nodes at step 1, the middle one at the forward F_1
+    double s0 = scale_[1], s1 = scale_[1] * pw[1], s2 = scale_[1] * pw[2];
+    double dl = (v1[1] - v1[0]) / (s1 - s0), du = (v1[2] - v1[1]) / (s2 - s1);
+    gamma = (du - dl) / (0.5 * (s2 - s0));
+    delta = (dl * (s2 - s1) + du * (s1 - s0)) / (s2 - s0);
+    double ds = s1 - spot_;
+    theta = (v1[1] - price - delta * ds - 0.5 * gamma * ds * ds) / times_[1];
+  }
+  else {
+    double s10 = scale_[1], s11 = scale_[1] * pw[1];
+    delta = (v1[1] - v1[0]) / (s11 - s10);
+    double s20 = scale_[2], s21 = scale_[2] * pw[1], s22 = scale_[2] * pw[2];
+    double dl = (v2[1] - v2[0]) / (s21 - s20), du = (v2[2] - v2[1]) / (s22 - s21);
+    gamma = (du - dl) / (0.5 * (s22 - s20));
+    double ds = s21 - spot_;
+    theta = (v2[1] - price - delta * ds - 0.5 * gamma * ds * ds) / times_[2];
+  }
+
+  Vector results(4);
+  results[0] = price;
+  results[1] = delta;
+  results[2] = gamma;
+  results[3] = theta;
+  return results;
+}
+
+END_NAMESPACE(qf)
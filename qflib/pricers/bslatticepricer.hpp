@@ -0,0 +1,105 @@
+/**
+@file  bslatticepricer.hpp
+@brief Recombining tree pricer in the Black Scholes model
+*/
+
+#ifndef QF_BSLATTICEPRICER_HPP
+#define QF_BSLATTICEPRICER_HPP
+
+#include <qflib/market/yieldcurve.hpp>
+#include <qflib/market/volatilitytermstructure.hpp>
+#include <qflib/methods/lattice/latticeparams.hpp>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** Binomial and trinomial tree pricer for European, American and Bermudan options 
+    in the Black-Scholes model (deterministic rates and vols).
+    The tree is built for the driftless ratio X = S / F(t) of the spot to its forward, with time steps 
+    of equal variance, so that it recombines for any vol term structure; the nodes are mapped back to 
+    spots through the forwards, and each step is discounted with the forward rate of the curve.
+    Backward induction runs in place on a single buffer of O(N) values.
+*/
+class BsLatticePricer
+{
+public:
+  /** The exercise types */
+  enum class ExerciseType
+  {
+    EUROPEAN,
+    AMERICAN,
+    BERMUDAN
+  };
+
+  /** Ctor with a constant volatility.
+      exerTimes are the early exercise times of a Bermudan option, ignored otherwise;
+      each is mapped to the nearest tree time. Exercise at expiration is always allowed.
+  */
+  BsLatticePricer(int payoffType,
+                  double strike,
+                  double timeToExp,
+                  ExerciseType exerType,
+                  Vector const& exerTimes,
+                  SPtrYieldCurve discountYieldCurve,
+                  double divYield,
+                  double vol,
+                  double spot,
+                  LatticeParams latticeparams);
+
+  /** Ctor with a volatility term structure */
+  BsLatticePricer(int payoffType,
+                  double strike,
+                  double timeToExp,
+                  ExerciseType exerType,
+                  Vector const& exerTimes,
+                  SPtrYieldCurve discountYieldCurve,
+                  double divYield,
+                  SPtrVolatilityTermStructure volTS,
+                  double spot,
+                  LatticeParams latticeparams);
+
+  /** Runs the backward induction and returns the price, delta, gamma and theta.
+      The Greeks are read off the first two time steps of the tree.
+  */
+  Vector solve();
+
+  /** Returns the tree times */
+  Vector const& times() const;
+
+private:
+  void init(Vector const& exerTimes);
+  double totalVariance(double t) const;
+
+  int payoffType_;         // 1 for call, -1 for put
+  double strike_;          // the strike
+  double texp_;            // the time to expiration
+  ExerciseType exerType_;  // the exercise type
+  SPtrYieldCurve discyc_;  // pointer to the discount curve
+  double divyld_;          // the constant dividend yield
+  double vol_;             // the constant volatility
+  SPtrVolatilityTermStructure volTS_; // pointer to the volatility term structure
+  double spot_;            // the initial spot
+  LatticeParams params_;   // the tree parameters
+
+  size_t nsteps_;          // the number of steps (odd for Leisen-Reimer)
+  double pu_, pm_, pd_;    // the branching probabilities (pm_ is zero for binomial trees)
+  Vector times_;           // the tree times, nsteps_ + 1
+  Vector disc_;            // the one-step discount factors, nsteps_
+  Vector scale_;           // the spot of the lowest node at each step, nsteps_ + 1
+  Vector pw_;              // the spot of node j relative to the lowest node
+  std::vector<char> exercisable_;  // whether exercise is allowed at each step
+  Vector v_;               // the option values, updated in place
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+Vector const& BsLatticePricer::times() const
+{
+  return times_;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_BSLATTICEPRICER_HPP
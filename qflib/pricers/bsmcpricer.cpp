@@ -56,11 +56,13 @@ BsMcPricer::BsMcPricer(
   // Pre-compute stdevs and drifts from time step to time step
   drifts_.resize(ntimesteps);
   stdevs_.resize(ntimesteps);
+  Vector fwdrates(ntimesteps);
+  discyc_->fwdRate(0.0, fixtimes.begin(), fixtimes.end(), fwdrates.begin());
 
   double t1 = 0.0;
   for (size_t i = 0; i < ntimesteps; ++i) {
     double t2 = fixtimes[i];
-    double fwdrate = discyc_->fwdRate(t1, t2);
+    double fwdrate = fwdrates[i];
 
     double var = vol_ * vol_ * (t2 - t1); 
     stdevs_[i] = std::sqrt(var);
@@ -116,13 +118,16 @@ BsMcPricer::BsMcPricer(
   // Pre-compute stdevs and drifts from time step to time step
   drifts_.resize(ntimesteps);
   stdevs_.resize(ntimesteps);
+  Vector fwdrates(ntimesteps), fwdvols(ntimesteps);
+  discyc_->fwdRate(0.0, fixtimes.begin(), fixtimes.end(), fwdrates.begin());
+  volTS_->fwdVol(0.0, fixtimes.begin(), fixtimes.end(), fwdvols.begin());
 
   double t1 = 0.0;
   for (size_t i = 0; i < ntimesteps; ++i) {
     double t2 = fixtimes[i];
-    double fwdrate = discyc_->fwdRate(t1, t2);
+    double fwdrate = fwdrates[i];
 
-    double fwdVol = volTS_->fwdVol(t1, t2);
+    double fwdVol = fwdvols[i];
     double var = fwdVol * fwdVol * (t2 - t1);
     stdevs_[i] = std::sqrt(var);
     drifts_[i] = (fwdrate - divyld_) * (t2 - t1) - 0.5 * var;
@@ -137,13 +142,14 @@ double BsMcPricer::processOnePath(Matrix& pricePath)
 {
   // generate standard normal increments
   pathgen_->next(pricePath);
+  QF_MC_MARK(timer_, RNG);
   double spot = spot_;
   for (size_t i = 0; i < pricePath.n_rows; ++i) {
     double normaldeviate = pricePath(i, 0);
     pricePath(i, 0) = spot * std::exp(drifts_[i] + stdevs_[i] * normaldeviate);
     spot = pricePath(i, 0);
   }
-
+  QF_MC_MARK(timer_, PATH);
 
   prod_->eval(pricePath);
   payamts_ = prod_->payAmounts();
@@ -151,6 +157,7 @@ double BsMcPricer::processOnePath(Matrix& pricePath)
   for (size_t i = 0; i < payamts_.size(); ++i) {
     pv += discfactors_[i] * payamts_[i];
   }
+  QF_MC_MARK(timer_, PRODUCT);
 
   return pv;
 }
@@ -11,6 +11,7 @@
 #include <qflib/methods/montecarlo/mcparams.hpp>
 #include <qflib/methods/montecarlo/pathgenerator.hpp>
 #include <qflib/methods/montecarlo/eulerpathgenerator.hpp>
+#include <qflib/methods/montecarlo/mcprofile.hpp>
 #include <qflib/math/stats/statisticscalculator.hpp>
 #include <qflib/market/volatilitytermstructure.hpp>
 
@@ -50,6 +51,14 @@ public:
   template<typename ITER>
   void simulate(StatisticsCalculator<ITER>& statsCalc, unsigned long npaths);
 
+  /** Returns the time spent in each phase of the simulations so far
+      It is empty unless the library is compiled with QF_MC_PROFILE defined.
+  */
+  McProfile const& profile() const { return profile_; }
+
+  /** Clears the profile */
+  void resetProfile() { profile_.reset(); }
+
 protected:
 
   /** Creates and processes one price path.
@@ -72,6 +81,9 @@ private:
   Vector stdevs_;              // caches the pre-computed standard deviations 
 
   Vector payamts_;             // scratch array for writing the payments after each simulation
+
+  McPhaseTimer timer_;         // splits the time of simulate among its phases, with QF_MC_PROFILE
+  McProfile profile_;          // the accumulated times
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -91,11 +103,21 @@ void BsMcPricer::simulate(StatisticsCalculator<ITER>& statsCalc, unsigned long n
   // check the size of the statistics calcuilator
   QF_ASSERT(statsCalc.nVariables() == nVariables(), "the statistics calculator must track only one variable!");
 
+#ifdef QF_MC_PROFILE
+  timer_.start();
+#endif
   // This is the HOT loop
   for (unsigned long i = 0; i < npaths; ++i) {
+#ifdef QF_MC_PROFILE
+    timer_.beginPath(i);
+#endif
     double pv = processOnePath(pricePath);
     statsCalc.addSample(&pv, &pv + 1);
+    QF_MC_MARK(timer_, STATS);
   }
+#ifdef QF_MC_PROFILE
+  timer_.stop(profile_, npaths, npaths * static_cast<unsigned long>(pricePath.n_elem));
+#endif
 }
 
 END_NAMESPACE(qf)
@@ -0,0 +1,234 @@
+/**
+@file  bspdepricer.cpp
+@brief Implementation of the BsPdePricer class
+*/
+
+#include <qflib/pricers/bspdepricer.hpp>
+#include <qflib/methods/pde/pdegrid.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+BEGIN_NAMESPACE(qf)
+
+// Constructor for constant volatility
+BsPdePricer::BsPdePricer(
+    int payoffType,
+    double strike,
+    double timeToExp,
+    ExerciseType exerType,
+    double lowerBarrier,
+    double upperBarrier,
+    SPtrYieldCurve discountCurve,
+    double divYield,
+    double vol,
+    double spot,
+    PdeParams pdeparams)
+: payoffType_(payoffType), strike_(strike), texp_(timeToExp), exerType_(exerType),
+  lobar_(lowerBarrier), upbar_(upperBarrier),
+  discyc_(discountCurve), divyld_(divYield), vol_(vol), volTS_(nullptr),
+  spot_(spot), pdeparams_(pdeparams), solver_(pdeparams.nSpaceNodes)
+{
+  QF_ASSERT(vol_ > 0.0, "BsPdePricer: the volatility must be positive");
+  init();
+}
+
+// Constructor for a volatility term structure
+BsPdePricer::BsPdePricer(
+    int payoffType,
+    double strike,
+    double timeToExp,
+    ExerciseType exerType,
+    double lowerBarrier,
+    double upperBarrier,
+    SPtrYieldCurve discountCurve,
+    double divYield,
+    SPtrVolatilityTermStructure volTS,
+    double spot,
+    PdeParams pdeparams)
+: payoffType_(payoffType), strike_(strike), texp_(timeToExp), exerType_(exerType),
+  lobar_(lowerBarrier), upbar_(upperBarrier),
+  discyc_(discountCurve), divyld_(divYield), vol_(0.0), volTS_(volTS),
+  spot_(spot), pdeparams_(pdeparams), solver_(pdeparams.nSpaceNodes)
+{
+  QF_ASSERT(volTS_, "BsPdePricer: null volatility term structure");
+  init();
+}
+
+void BsPdePricer::init()
+{
+  QF_ASSERT(payoffType_ == 1 || payoffType_ == -1, "BsPdePricer: payoff type must be 1 or -1");
+  QF_ASSERT(strike_ > 0.0, "BsPdePricer: strike must be positive");
+  QF_ASSERT(texp_ > 0.0, "BsPdePricer: time to expiration must be positive");
+  QF_ASSERT(spot_ > 0.0, "BsPdePricer: spot must be positive");
+  QF_ASSERT(discyc_, "BsPdePricer: null discount curve");
+  QF_ASSERT(lobar_ >= 0.0, "BsPdePricer: lower barrier must be non-negative");
+  QF_ASSERT(lobar_ == 0.0 || lobar_ < spot_, "BsPdePricer: lower barrier must be below the spot");
+  QF_ASSERT(upbar_ >= 0.0, "BsPdePricer: upper barrier must be non-negative");
+  QF_ASSERT(upbar_ == 0.0 || upbar_ > spot_, "BsPdePricer: upper barrier must be above the spot");
+
+  // grid boundaries: nStdevs standard deviations beyond spot and strike, or the barriers
+  double xspot = log(spot_);
+  double xstrike = log(strike_);
+  // at low or zero vol, the grid still covers the drift to the forward and a minimum standard deviation
+  const double MINSTDEV = 0.01;
+  double drift = fabs(discyc_->spotRate(texp_) - divyld_) * texp_;
+  double width = max(pdeparams_.nStdevs * fwdVol(0.0, texp_) * sqrt(texp_),
+                     pdeparams_.nStdevs * MINSTDEV + drift);
+  double xmin = lobar_ > 0.0 ? log(lobar_) : min(xspot, xstrike) - width;
+  double xmax = upbar_ > 0.0 ? log(upbar_) : max(xspot, xstrike) + width;
+
+  // critical points: the spot, the strike if inside the grid, and the barriers
+  double pts[4];
+  size_t npts = 0;
+  pts[npts++] = xspot;
+  if (xstrike > xmin && xstrike < xmax)
+    pts[npts++] = xstrike;
+  if (lobar_ > 0.0)
+    pts[npts++] = xmin;
+  if (upbar_ > 0.0)
+    pts[npts++] = xmax;
+  x_ = concentratedGrid(xmin, xmax, pdeparams_.nSpaceNodes, pts, pts + npts,
+                        pdeparams_.concentration, 0.05 * (xmax - xmin));
+
+  size_t n = x_.size();
+  dxm_.zeros(n);
+  dxp_.zeros(n);
+  for (size_t i = 1; i < n - 1; ++i) {
+    dxm_[i] = x_[i] - x_[i - 1];
+    dxp_[i] = x_[i + 1] - x_[i];
+  }
+
+  // exercise values; knocked-out nodes are worthless
+  exer_.resize(n);
+  for (size_t i = 0; i < n; ++i)
+    exer_[i] = payoff(exp(x_[i]));
+  if (lobar_ > 0.0)
+    exer_[0] = 0.0;
+  if (upbar_ > 0.0)
+    exer_[n - 1] = 0.0;
+
+  v_.resize(n);
+  vprev_.resize(n);
+  rhs_.resize(n);
+  lo_.zeros(n);
+  di_.ones(n);
+  up_.zeros(n);
+}
+
+double BsPdePricer::fwdVol(double t1, double t2) const
+{
+  return volTS_ ? volTS_->fwdVol(t1, t2) : vol_;
+}
+
+double BsPdePricer::payoff(double s) const
+{
+  return max(payoffType_ * (s - strike_), 0.0);
+}
+
+void BsPdePricer::step(double r, double sig, double dt, double theta, double df, double qf)
+{
+  size_t n = x_.size();
+  double a = 0.5 * sig * sig;
+  double mu = r - divyld_ - a;
+
+  // interior rows: discretize a V_xx + mu V_x - r V with three-point non-uniform differences
+  for (size_t i = 1; i < n - 1; ++i) {
+    double hm = dxm_[i], hp = dxp_[i];
+    double lm = (2.0 * a - mu * hp) / (hm * (hm + hp));
+    double lp = (2.0 * a + mu * hm) / (hp * (hm + hp));
+    double l0 = (-2.0 * a + mu * (hp - hm)) / (hm * hp) - r;
+    rhs_[i] = v_[i] + (1.0 - theta) * dt * (lm * v_[i - 1] + l0 * v_[i] + lp * v_[i + 1]);
+    lo_[i] = -theta * dt * lm;
+    di_[i] = 1.0 - theta * dt * l0;
+    up_[i] = -theta * dt * lp;
+  }
+
+  // Dirichlet boundaries: zero at the barriers, asymptotic values otherwise
+  bool american = exerType_ == ExerciseType::AMERICAN;
+  double smin = exp(x_[0]), smax = exp(x_[n - 1]);
+  double vmin = 0.0, vmax = 0.0;
+  if (lobar_ == 0.0 && payoffType_ == -1) {
+    vmin = strike_ * df - smin * qf;
+    if (american)
+      vmin = max(vmin, strike_ - smin);
+  }
+  if (upbar_ == 0.0 && payoffType_ == 1) {
+    vmax = smax * qf - strike_ * df;
+    if (american)
+      vmax = max(vmax, smax - strike_);
+  }
+  rhs_[0] = vmin;
+  rhs_[n - 1] = vmax;
+
+  if (american)
+    solver_.solveProjected(lo_, di_, up_, rhs_, exer_, payoffType_ == -1, v_);
+  else
+    solver_.solve(lo_, di_, up_, rhs_, v_);
+}
+
+Vector BsPdePricer::solve()
+{
+  size_t n = x_.size();
+  size_t nsteps = pdeparams_.nTimeSteps;
+  double dt = texp_ / nsteps;
+
+  // terminal condition
+  v_ = exer_;
+
+  // march backwards from expiration; df and qf accumulate from the current level to expiration
+  double df = 1.0, qf = 1.0;
+  double tlast = dt;
+  for (size_t k = 0; k < nsteps; ++k) {
+    double t2 = texp_ - k * dt;
+    double t1 = (k + 1 == nsteps) ? 0.0 : t2 - dt;
+    double h = t2 - t1;
+    double r = discyc_->fwdRate(t1, t2);
+    double sig = fwdVol(t1, t2);
+    if (k + 1 == nsteps) {
+      vprev_ = v_;
+      tlast = h;
+    }
+    if (k < pdeparams_.nRannacherSteps) {
+      // Rannacher smoothing: two implicit Euler half steps damp the payoff discontinuities
+      double dfh = df * exp(-0.5 * r * h), qfh = qf * exp(-0.5 * divyld_ * h);
+      step(r, sig, 0.5 * h, 1.0, dfh, qfh);
+      df *= exp(-r * h);
+      qf *= exp(-divyld_ * h);
+      step(r, sig, 0.5 * h, 1.0, df, qf);
+    }
+    else {
+      df *= exp(-r * h);
+      qf *= exp(-divyld_ * h);
+      step(r, sig, h, 0.5, df, qf);
+    }
+  }
+
+  // Greeks off the grid: quadratic interpolation through the three nodes closest to the spot
+  double xs = log(spot_);
+  size_t j = upper_bound(x_.begin(), x_.end(), xs) - x_.begin();
+  j = (j == 0) ? 0 : j - 1;
+  if (j + 1 < n && xs - x_[j] > x_[j + 1] - xs)
+    ++j;
+  j = min(max(j, size_t(1)), n - 2);
+  double xa = x_[j - 1], xb = x_[j], xc = x_[j + 1];
+  double da = (xa - xb) * (xa - xc), db = (xb - xa) * (xb - xc), dc = (xc - xa) * (xc - xb);
+  double la = (xs - xb) * (xs - xc) / da, lb = (xs - xa) * (xs - xc) / db, lc = (xs - xa) * (xs - xb) / dc;
+  double d1a = (2.0 * xs - xb - xc) / da, d1b = (2.0 * xs - xa - xc) / db, d1c = (2.0 * xs - xa - xb) / dc;
+  double d2a = 2.0 / da, d2b = 2.0 / db, d2c = 2.0 / dc;
+
+  double price = la * v_[j - 1] + lb * v_[j] + lc * v_[j + 1];
+  double vx = d1a * v_[j - 1] + d1b * v_[j] + d1c * v_[j + 1];
+  double vxx = d2a * v_[j - 1] + d2b * v_[j] + d2c * v_[j + 1];
+  double pricePrev = la * vprev_[j - 1] + lb * vprev_[j] + lc * vprev_[j + 1];
+
+  Vector results(4);
+  results[0] = price;
+  results[1] = vx / spot_;
+  results[2] = (vxx - vx) / (spot_ * spot_);
+  results[3] = (pricePrev - price) / tlast;
+  return results;
+}
+
+END_NAMESPACE(qf)
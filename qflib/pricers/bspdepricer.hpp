@@ -0,0 +1,121 @@
+/**
+@file  bspdepricer.hpp
+@brief Finite difference PDE pricer in the Black Scholes model
+*/
+
+#ifndef QF_BSPDEPRICER_HPP
+#define QF_BSPDEPRICER_HPP
+
+#include <qflib/market/yieldcurve.hpp>
+#include <qflib/market/volatilitytermstructure.hpp>
+#include <qflib/methods/pde/pdeparams.hpp>
+#include <qflib/methods/pde/tridiagonalsolver.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+/** Finite difference pricer for vanilla and knock-out barrier options in the Black-Scholes model
+    (deterministic rates and vols).
+    The PDE is solved in the log-spot on a non-uniform grid concentrated at the strike, the spot
+    and the barriers, with the Crank-Nicolson scheme and Rannacher start-up steps.
+    The short rate and the volatility are taken from the curves for each time step.
+    Barriers are monitored continuously and carry no rebate.
+*/
+class BsPdePricer
+{
+public:
+  /** The exercise types */
+  enum class ExerciseType
+  {
+    EUROPEAN,
+    AMERICAN
+  };
+
+  /** Ctor with a constant volatility.
+      A zero lower (upper) barrier means no lower (upper) barrier.
+  */
+  BsPdePricer(int payoffType,
+              double strike,
+              double timeToExp,
+              ExerciseType exerType,
+              double lowerBarrier,
+              double upperBarrier,
+              SPtrYieldCurve discountYieldCurve,
+              double divYield,
+              double vol,
+              double spot,
+              PdeParams pdeparams);
+
+  /** Ctor with a volatility term structure */
+  BsPdePricer(int payoffType,
+              double strike,
+              double timeToExp,
+              ExerciseType exerType,
+              double lowerBarrier,
+              double upperBarrier,
+              SPtrYieldCurve discountYieldCurve,
+              double divYield,
+              SPtrVolatilityTermStructure volTS,
+              double spot,
+              PdeParams pdeparams);
+
+  /** Solves the PDE and returns the price, delta, gamma and theta.
+      The Greeks are read off the grid at the spot.
+  */
+  Vector solve();
+
+  /** Returns the spatial grid (the log-spot nodes) */
+  Vector const& grid() const;
+
+  /** Returns the option values at time zero on the grid nodes; valid after solve() */
+  Vector const& values() const;
+
+private:
+  void init();
+  double fwdVol(double t1, double t2) const;
+  double payoff(double s) const;
+  
+  /** Advances the values by one theta-scheme step of length dt backwards in time.
+      df and qf are the discount and dividend factors from the new time level to expiration.
+  */
+  void step(double r, double sig, double dt, double theta, double df, double qf);
+
+  int payoffType_;         // 1 for call, -1 for put
+  double strike_;          // the strike
+  double texp_;            // the time to expiration
+  ExerciseType exerType_;  // the exercise type
+  double lobar_;           // the lower barrier, zero if none
+  double upbar_;           // the upper barrier, zero if none
+  SPtrYieldCurve discyc_;  // pointer to the discount curve
+  double divyld_;          // the constant dividend yield
+  double vol_;             // the constant volatility
+  SPtrVolatilityTermStructure volTS_; // pointer to the volatility term structure
+  double spot_;            // the initial spot
+  PdeParams pdeparams_;    // the PDE parameters
+
+  Vector x_;          // the log-spot grid
+  Vector dxm_, dxp_;  // the grid spacings to the left and right of each node
+  Vector exer_;       // the exercise values on the grid
+  Vector v_, vprev_;  // the option values at the current and previous time levels
+  Vector rhs_;        // scratch right hand side
+  Vector lo_, di_, up_;  // the implicit tridiagonal matrix
+  TridiagonalSolver solver_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline 
+Vector const& BsPdePricer::grid() const
+{
+  return x_;
+}
+
+inline 
+Vector const& BsPdePricer::values() const
+{
+  return v_;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_BSPDEPRICER_HPP
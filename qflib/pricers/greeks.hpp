@@ -0,0 +1,72 @@
+/**
+@file  greeks.hpp
+@brief Fixed-size value types for the results of the closed-form pricers
+*/
+
+#ifndef QF_GREEKS_HPP
+#define QF_GREEKS_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/math/matrix.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+/** Price and Greeks of an option, returned by value without allocating */
+struct Greeks
+{
+  /** Flags selecting the outputs to compute; they can be or-ed together */
+  enum : unsigned
+  {
+    PRICE = 1u << 0,
+    DELTA = 1u << 1,
+    GAMMA = 1u << 2,
+    THETA = 1u << 3,
+    VEGA  = 1u << 4,
+    ALL   = PRICE | DELTA | GAMMA | THETA | VEGA
+  };
+
+  double price = 0.0;
+  double delta = 0.0;
+  double gamma = 0.0;
+  double theta = 0.0;
+  double vega  = 0.0;
+
+  /** Returns the vector [price, delta, gamma, theta, vega] */
+  Vector toVector() const;
+};
+
+/** Present values of the two legs of a credit default swap */
+struct CdsLegs
+{
+  double defaultLeg = 0.0;   // the protection (default) leg
+  double premiumLeg = 0.0;   // the premium leg
+
+  /** Returns the vector [defaultLeg, premiumLeg] */
+  Vector toVector() const;
+};
+
+////////////////////////////////////////////////////////////////////////////.//
+// Inline definitions
+
+inline Vector Greeks::toVector() const
+{
+  Vector vec(5);
+  vec[0] = price;
+  vec[1] = delta;
+  vec[2] = gamma;
+  vec[3] = theta;
+  vec[4] = vega;
+  return vec;
+}
+
+inline Vector CdsLegs::toVector() const
+{
+  Vector vec(2);
+  vec[0] = defaultLeg;
+  vec[1] = premiumLeg;
+  return vec;
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_GREEKS_HPP
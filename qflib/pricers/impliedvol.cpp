@@ -0,0 +1,149 @@
+/**
+@file  impliedvol.cpp
+@brief Implementation of the Black-Scholes implied volatility
+*/
+
+#include <qflib/pricers/impliedvol.hpp>
+#include <qflib/math/stats/normalkernels.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BEGIN_NAMESPACE(qf)
+
+namespace {
+
+  // number of Halley iterations from the initial guess; the loop below is unrolled to match
+  const int NHALLEY = 4;
+  // number of options per block in the batch version
+  const size_t BLOCKSIZE = 256;
+
+  /** Normalized out-of-the-money Black call price for x <= 0 and total stdev s > 0:
+        b(x, s) = exp(x/2) N(x/s + s/2) - exp(-x/2) N(x/s - s/2)
+      The two terms nearly cancel at small s: the relative error is about 1e-15 / s near the money
+      and grows with |x| / s^2 out of the money, e.g. 6e-13 at s = 0.001 and x = 0, 8e-11 at x = -8 s.
+      It is below 1e-14 for s >= 0.1 and |x| <= s.
+  */
+  QF_FORCEINLINE double normalizedBlack(double x, double s, double ex2, double emx2)
+  {
+    return ex2 * normalCdf(x / s + 0.5 * s) - emx2 * normalCdf(x / s - 0.5 * s);
+  }
+
+  /** Returns the total standard deviation s such that b(x, s) = beta, for x <= 0 and 0 < beta < exp(x/2).
+      Below the inflection point sc = sqrt(2|x|) Halley steps are taken on log(b) - log(beta), above it
+      on b - beta. Four steps from the better of two asymptotic initial guesses converge; the result is then
+      limited by the rounding of b above, to a relative error of about 3e-14 / s at low s.
+  */
+  QF_FORCEINLINE double normalizedImpliedStdev(double x, double beta)
+  {
+    double ex2 = fastExp(0.5 * x), emx2 = fastExp(-0.5 * x);
+    double sc = std::sqrt(-2.0 * x);
+    double bc = sc > 0.0 ? normalizedBlack(x, sc, ex2, emx2) : 0.0;
+    bool lower = beta < bc;
+
+    // initial guesses from the asymptotes: b ~ n(x/s) s^3 / x^2 for small s,
+    // b ~ exp(x/2) - (exp(x/2) + exp(-x/2)) N(-s/2) for large s; keep the one closer in log price
+    double lnbeta = fastLog(beta);
+    double slo = std::sqrt(2.0 * x * x / std::max(-x - 4.0 * fastLog(beta / bc), 1.0e-300));
+    double lnx = fastLog(-x);
+#if defined(__GNUC__)
+#pragma GCC unroll 2
+#endif
+    for (int k = 0; k < 2; ++k) {
+      // fixed point iteration on log b = -x^2 / (2 s^2) - s^2 / 8 + 3 log s - 2 log|x| - log sqrt(2 pi)
+      double den = 2.0 * (3.0 * fastLog(slo) - 2.0 * lnx - 0.91893853320467274 - lnbeta - 0.125 * slo * slo);
+      slo = den > 0.0 ? std::sqrt(x * x / den) : slo;
+    }
+    double shi = -2.0 * normalInvCdf((ex2 - beta) / (ex2 + emx2));
+    double elo = std::abs(fastLog(normalizedBlack(x, slo, ex2, emx2)) - lnbeta);
+    double ehi = std::abs(fastLog(normalizedBlack(x, shi, ex2, emx2)) - lnbeta);
+    elo = slo > 0.0 ? elo : std::numeric_limits<double>::infinity();
+    double s = elo < ehi ? slo : shi;
+
+#if defined(__GNUC__)
+#pragma GCC unroll 4
+#endif
+    for (int iter = 0; iter < NHALLEY; ++iter) {
+      double b = normalizedBlack(x, s, ex2, emx2);
+      double d1 = x / s + 0.5 * s;
+      double vega = ex2 * normalPdf(d1);                  // db/ds
+      double volga = vega * (x * x / (s * s * s) - 0.25 * s);  // d2b/ds2
+      // Newton step and relative curvature of the objective function, selected without branching
+      double g1 = vega / b;
+      double nulo = (fastLog(b) - lnbeta) / g1;
+      double curvlo = (volga / b - g1 * g1) / g1;
+      double nuhi = (b - beta) / vega;
+      double curvhi = volga / vega;
+      double nu = lower ? nulo : nuhi;
+      double curv = lower ? curvlo : curvhi;
+      double ds = nu / std::max(1.0 - 0.5 * nu * curv, 0.5);
+      s = std::max(s - ds, 0.5 * s);
+    }
+    return s;
+  }
+
+  /** Implied volatility, or NaN if the inputs are invalid */
+  QF_FORCEINLINE double impliedVolBSKernel(int payoffType, double price, double spot, double strike,
+                                           double timeToExp, double intRate, double divYield)
+  {
+    double theta = payoffType;
+    double df = fastExp(-intRate * timeToExp);
+    double fwd = spot * fastExp(-divYield * timeToExp) / df;
+    double x = fastLog(fwd / strike);
+    double sqrtfk = std::sqrt(fwd * strike);
+    double beta = price / (df * sqrtfk);
+    // remove the intrinsic value of in-the-money options, leaving the out-of-the-money call form with x <= 0
+    double ex2 = fastExp(0.5 * x), emx2 = fastExp(-0.5 * x);
+    // the rounding of the price and of the intrinsic value scales with the forward and the strike,
+    // i.e. with ex2 + emx2 in normalized units, not with the time value left below
+    double tol = 8.0 * std::numeric_limits<double>::epsilon() * (ex2 + emx2);
+    double intrinsic = std::max(theta * (ex2 - emx2), 0.0);
+    beta -= intrinsic;
+    // a time value lost in rounding means zero volatility
+    beta = beta < 0.0 && beta > -tol ? 0.0 : beta;
+    double xn = -std::abs(x);
+    double bmax = fastExp(0.5 * xn);
+
+    // invalid prices are clamped for the computation and flagged below
+    double s = normalizedImpliedStdev(xn, std::min(std::max(beta, std::numeric_limits<double>::min()), bmax));
+    double vol = s / std::sqrt(timeToExp);
+
+    bool valid = (payoffType == 1 || payoffType == -1) && spot > 0.0 && strike > 0.0 && timeToExp > 0.0
+      && beta >= 0.0 && beta < bmax;
+    vol = beta == 0.0 ? 0.0 : vol;
+    return valid ? vol : std::numeric_limits<double>::quiet_NaN();
+  }
+
+} // anonymous namespace
+
+double impliedVolBS(int payoffType, double price, double spot, double strike, double timeToExp,
+                    double intRate, double divYield)
+{
+  QF_ASSERT(payoffType == 1 || payoffType == -1, "payoffType must be 1 or -1");
+  QF_ASSERT(spot > 0.0, "spot must be positive");
+  QF_ASSERT(strike > 0.0, "strike must be positive");
+  QF_ASSERT(timeToExp > 0.0, "time to expiration must be positive");
+
+  double vol = impliedVolBSKernel(payoffType, price, spot, strike, timeToExp, intRate, divYield);
+  QF_ASSERT(!std::isnan(vol), "option price is outside the no-arbitrage bounds");
+  return vol;
+}
+
+void impliedVolBSBatch(size_t n, int const* payoffType, double const* price, double const* spot,
+                       double const* strike, double const* timeToExp, double const* intRate,
+                       double const* divYield, double* vol)
+{
+  long nblocks = static_cast<long>((n + BLOCKSIZE - 1) / BLOCKSIZE);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (long b = 0; b < nblocks; ++b) {
+    size_t i0 = static_cast<size_t>(b) * BLOCKSIZE;
+    size_t i1 = std::min(i0 + BLOCKSIZE, n);
+    QF_SIMD
+    for (size_t i = i0; i < i1; ++i)
+      vol[i] = impliedVolBSKernel(payoffType[i], price[i], spot[i], strike[i], timeToExp[i], intRate[i], divYield[i]);
+  }
+}
+
+END_NAMESPACE(qf)
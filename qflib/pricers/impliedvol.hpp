@@ -0,0 +1,39 @@
+/**
+@file  impliedvol.hpp
+@brief Black-Scholes implied volatility, for single options and arrays of options
+*/
+
+#ifndef QF_IMPLIEDVOL_HPP
+#define QF_IMPLIEDVOL_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <cstddef>
+
+BEGIN_NAMESPACE(qf)
+
+/** Implied volatility of a European option in the Black-Scholes model, 
+    i.e. the inverse of europeanOptionBS(...)[0] in the volatility.
+    The price is converted to the normalized out-of-the-money Black price, and inverted with 
+    Halley steps from a closed form initial guess on either side of the inflection point.
+    The relative error of the volatility is below 2e-13 for vol sqrt(timeToExp) >= 0.2 and about 
+    3e-14 / (vol sqrt(timeToExp)) below it, e.g. 3e-11 at 0.001, because the normalized price is a difference 
+    of nearly equal terms at low volatility; it is larger where the price itself hardly depends on the volatility.
+    Throws if the price is outside the no-arbitrage bounds.
+*/
+double impliedVolBS(int payoffType, double price, double spot, double strike, double timeToExp,
+                    double intRate, double divYield);
+
+/** Implied volatilities of n European options in the Black-Scholes model.
+    The inputs are arrays of size n with the same conventions as impliedVolBS; the results are written 
+    to the caller-owned array vol of size n. The options are processed in vectorized blocks, in parallel
+    when OpenMP is available. Prices outside the no-arbitrage bounds, or otherwise invalid inputs, 
+    give NaN instead of throwing.
+*/
+void impliedVolBSBatch(size_t n, int const* payoffType, double const* price, double const* spot,
+                       double const* strike, double const* timeToExp, double const* intRate,
+                       double const* divYield, double* vol);
+
+END_NAMESPACE(qf)
+
+#endif // QF_IMPLIEDVOL_HPP
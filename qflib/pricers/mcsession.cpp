@@ -0,0 +1,57 @@
+/**
+@file  mcsession.cpp
+@brief Implementation of the McSession class
+*/
+
+#include <qflib/pricers/mcsession.hpp>
+#include <cmath>
+#include <limits>
+
+BEGIN_NAMESPACE(qf)
+
+McSession::McSession(std::shared_ptr<BsMcPricer> pricer)
+: pricer_(pricer), stats_(pricer ? pricer->nVariables() : 1)
+{
+  QF_ASSERT(pricer_, "McSession: the pricer is null");
+}
+
+McSession::Results McSession::simulate(unsigned long npaths)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pricer_->simulate(stats_, npaths);
+  return currentResults();
+}
+
+McSession::Results McSession::results()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return currentResults();
+}
+
+unsigned long McSession::nPaths() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<unsigned long>(stats_.nSamples());
+}
+
+void McSession::reset()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.reset();
+}
+
+McSession::Results McSession::currentResults()
+{
+  Results res;
+  res.nPaths = static_cast<unsigned long>(stats_.nSamples());
+  if (res.nPaths == 0) {
+    res.mean = res.stdErr = std::numeric_limits<double>::quiet_NaN();
+    return res;
+  }
+  Matrix const& stats = stats_.results();
+  res.mean = stats(0, 0);
+  res.stdErr = std::sqrt(stats(1, 0) / res.nPaths);
+  return res;
+}
+
+END_NAMESPACE(qf)
@@ -0,0 +1,64 @@
+/**
+@file  mcsession.hpp
+@brief A Monte Carlo simulation kept across calls
+*/
+
+#ifndef QF_MCSESSION_HPP
+#define QF_MCSESSION_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/pricers/bsmcpricer.hpp>
+#include <qflib/math/stats/meanvarcalculator.hpp>
+#include <memory>
+#include <mutex>
+
+BEGIN_NAMESPACE(qf)
+
+/** A Monte Carlo simulation kept across calls, e.g. stored in the market and driven from Python.
+    It owns a pricer, whose path generator, discount factors and drifts are built once, and the statistics
+    of all the paths simulated so far. Each call to simulate continues the random number stream where
+    the previous call stopped and adds its paths to the statistics, so that k calls of n paths give
+    the same results as one call of k * n paths. The pricer uses the curves it was created with.
+    Calls on the same session are serialized.
+*/
+class McSession
+{
+public:
+  /** The accumulated results */
+  struct Results
+  {
+    double mean;           // the mean PV of the paths
+    double stdErr;         // the standard error of the mean
+    unsigned long nPaths;  // the number of paths simulated since creation or the last reset
+  };
+
+  /** Ctor from the pricer */
+  explicit McSession(std::shared_ptr<BsMcPricer> pricer);
+
+  /** Simulates npaths more paths and returns the results of all the paths so far */
+  Results simulate(unsigned long npaths);
+
+  /** Returns the results of all the paths so far */
+  Results results();
+
+  /** Returns the number of paths simulated so far */
+  unsigned long nPaths() const;
+
+  /** Clears the statistics; the random number stream is not rewound */
+  void reset();
+
+private:
+  // returns the results; the mutex must be held
+  Results currentResults();
+
+  std::shared_ptr<BsMcPricer> pricer_;
+  MeanVarCalculator<double*> stats_;
+  mutable std::mutex mutex_;
+};
+
+using SPtrMcSession = std::shared_ptr<McSession>;
+
+END_NAMESPACE(qf)
+
+#endif // QF_MCSESSION_HPP
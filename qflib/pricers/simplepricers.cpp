@@ -4,7 +4,7 @@
 */
 
 #include <qflib/pricers/simplepricers.hpp>
-#include <qflib/math/stats/normaldistribution.hpp>
+#include <qflib/math/stats/normalkernels.hpp>
 #include <qflib/utils.hpp>
 
 #include <cmath>
@@ -35,9 +35,9 @@ double quantoFwdPrice(double spot, double timeToExp, double intRate, double divY
   return cvx * fwd;
 }
 
-/** Price of a European digital option in the Black-Scholes model*/
-Vector digitalOptionBS(int payoffType, double spot, double strike, double timeToExp,
-                       double intRate, double divYield, double volatility)
+/** Price and Greeks of a European digital option in the Black-Scholes model*/
+Greeks digitalOptionBSGreeks(int payoffType, double spot, double strike, double timeToExp,
+                             double intRate, double divYield, double volatility, unsigned mask)
 {
   QF_ASSERT(payoffType == 1 || payoffType == -1, "payoffType must be 1 or -1");
   QF_ASSERT(strike >= 0.0, "strike must be non-negative");
@@ -50,46 +50,49 @@ Vector digitalOptionBS(int payoffType, double spot, double strike, double timeTo
   double sig2 = volatility * volatility;
 
   double epsilon = 1.0e-012;  // a very small hard-coded number
-  double d1 = log(fwd / (strike + epsilon)) / sigT + 0.5 * sigT;
   double d2 = log(fwd / strike) / sigT - 0.5 * sigT;
-  NormalDistribution normal;
 
-  // precompute common quantities
+  // the price
+  Greeks res;
   double df = exp(-intRate * timeToExp);
-  double nd2 = normal.cdf(phi * d2);
-  double nprd2 = normal.pdf(d2);
-  double sqrtT = sqrt(timeToExp);
-  double spot2 = spot * spot;
-
-  // price and Greeks
-  double price = df * nd2;
-  double delta = phi * df * nprd2 / (spot * sigT);
-  delta = sigT < epsilon ? 0.0 : delta;
-  double gamma = -phi * df * d1 * nprd2 / (spot2 * sig2 * timeToExp);
-  gamma = sigT < epsilon ? 0.0 : gamma;
-
-  double theta = intRate * price;
-  theta += phi * df * nprd2 * (log(spot/(strike + epsilon)) / timeToExp - (intRate - divYield - sig2 / 2) ) / 2.0 / sigT;
-  theta = sigT < epsilon ? 0.0 : theta;
-
-  double vega = -phi * df * strike * sqrtT * nprd2;
-  vega *= 0.5 + log(fwd / strike) / sig2 / timeToExp;
-  vega = sigT < epsilon ? 0.0 : vega;
-
-  Vector vec(5);
-  vec[0] = price;
-  vec[1] = delta;
-  vec[2] = gamma;
-  vec[3] = theta;
-  vec[4] = vega;
-
-  return vec;
+  res.price = df * normalCdf(phi * d2);
+  if (!(mask & (Greeks::DELTA | Greeks::GAMMA | Greeks::THETA | Greeks::VEGA)) || sigT < epsilon)
+    return res;
+
+  // precompute the quantities common to the Greeks
+  double nprd2 = normalPdf(d2);
+
+  if (mask & Greeks::DELTA)
+    res.delta = phi * df * nprd2 / (spot * sigT);
+
+  if (mask & Greeks::GAMMA) {
+    double d1 = log(fwd / (strike + epsilon)) / sigT + 0.5 * sigT;
+    res.gamma = -phi * df * d1 * nprd2 / (spot * spot * sig2 * timeToExp);
+  }
+
+  if (mask & Greeks::THETA) {
+    res.theta = intRate * res.price;
+    res.theta += phi * df * nprd2 * (log(spot / (strike + epsilon)) / timeToExp - (intRate - divYield - sig2 / 2)) / 2.0 / sigT;
+  }
+
+  if (mask & Greeks::VEGA) {
+    res.vega = -phi * df * strike * sqrt(timeToExp) * nprd2;
+    res.vega *= 0.5 + log(fwd / strike) / sig2 / timeToExp;
+  }
+
+  return res;
 }
 
+/** Price of a European digital option in the Black-Scholes model*/
+Vector digitalOptionBS(int payoffType, double spot, double strike, double timeToExp,
+                       double intRate, double divYield, double volatility)
+{
+  return digitalOptionBSGreeks(payoffType, spot, strike, timeToExp, intRate, divYield, volatility).toVector();
+}
 
 /** Price and Greeks of a European option in the Black-Scholes model*/
-Vector europeanOptionBS(int payoffType, double spot, double strike, double timeToExp, 
-                        double intRate, double divYield, double volatility)
+Greeks europeanOptionBSGreeks(int payoffType, double spot, double strike, double timeToExp,
+                              double intRate, double divYield, double volatility, unsigned mask)
 {
   QF_ASSERT(payoffType == 1 || payoffType == -1, "payoffType must be 1 or -1");
   QF_ASSERT(strike >= 0.0, "strike must be non-negative");
@@ -97,39 +100,44 @@ Vector europeanOptionBS(int payoffType, double spot, double strike, double timeT
 
   double phi = payoffType;
   double fwd = fwdPrice(spot, timeToExp, intRate, divYield);
-  double sigT = volatility * sqrt(timeToExp);
+  double sqrtT = sqrt(timeToExp);
+  double sigT = volatility * sqrtT;
   double d1 = log(fwd / strike) / sigT + 0.5 * sigT;
   double d2 = d1 - sigT;
-  NormalDistribution normal;
   double epsilon = 1.0e-012;  // a very small hard-coded number
 
-  // precompute common quantities
+  // the price, and delta which comes almost for free
+  Greeks res;
   double df = exp(-intRate * timeToExp);
   double qf = exp(-divYield * timeToExp);
-  double nd1 = normal.cdf(phi * d1);
-  double nd2 = normal.cdf(phi * d2);
-  double nprd1 = normal.pdf(d1);      // the normal density     
-  double sqrtT = sqrt(timeToExp);
+  double nd1 = normalCdf(phi * d1);
+  double nd2 = normalCdf(phi * d2);
+  res.price = phi * df * (fwd * nd1 - strike * nd2);
+  if (mask & Greeks::DELTA)
+    res.delta = phi * qf * nd1;
+  if (!(mask & (Greeks::GAMMA | Greeks::THETA | Greeks::VEGA)))
+    return res;
+
+  // the Greeks depending on the normal density
+  double nprd1 = normalPdf(d1);
+  if (mask & Greeks::GAMMA)
+    res.gamma = sigT < epsilon ? 0.0 : qf * nprd1 / (spot * sigT);
+  if ((mask & Greeks::THETA) && sqrtT >= epsilon) {
+    res.theta = -qf * nprd1 * spot * volatility / (2.0 * sqrtT);
+    res.theta += phi * divYield * qf * spot * nd1;
+    res.theta -= phi * intRate * df * strike * nd2;
+  }
+  if (mask & Greeks::VEGA)
+    res.vega = qf * sqrtT * spot * nprd1;
 
-  // price and Greeks
-  double price = phi * df * (fwd * nd1 - strike * nd2);
-  double delta = phi * qf * nd1;
-  double gamma = qf * nprd1 / (spot * volatility * sqrtT);
-  gamma = sigT < epsilon ? 0.0 : gamma;
-  double theta = -qf * nprd1 * spot * volatility / (2.0 * sqrtT);
-  theta += phi * divYield * qf * spot * nd1;
-  theta -= phi * intRate * df * strike * nd2;
-  theta = sqrtT < epsilon ? 0.0 : theta;
-  double vega = qf * sqrtT * spot * nprd1;
-
-  Vector vec(5);
-  vec[0] = price;
-  vec[1] = delta;
-  vec[2] = gamma;
-  vec[3] = theta;
-  vec[4] = vega;
-
-  return vec;
+  return res;
+}
+
+/** Price and Greeks of a European option in the Black-Scholes model*/
+Vector europeanOptionBS(int payoffType, double spot, double strike, double timeToExp, 
+                        double intRate, double divYield, double volatility)
+{
+  return europeanOptionBSGreeks(payoffType, spot, strike, timeToExp, intRate, divYield, volatility).toVector();
 }
 
 /** Price of a single point knock-out forward contract*/
@@ -143,10 +151,11 @@ double knockoutFwd(double spot, double strike, double kolevel,
   QF_ASSERT(volatility >= 0.0, "volatility must be non-negative");
 
   double dfko = exp(-divYield * (timeToExp - timeToKO));
-  double price = europeanOptionBS(1, spot, kolevel, timeToKO, intRate, divYield, volatility)[0];
+  double price = europeanOptionBSGreeks(1, spot, kolevel, timeToKO, intRate, divYield, volatility,
+                                        Greeks::PRICE).price;
   double digimult = (kolevel - exp(-(intRate - divYield) * (timeToExp - timeToKO)) * strike);
-  price += digimult * digitalOptionBS(1, spot, kolevel, timeToKO,
-    intRate, divYield, volatility)[0];
+  price += digimult * digitalOptionBSGreeks(1, spot, kolevel, timeToKO,
+    intRate, divYield, volatility, Greeks::PRICE).price;
 
   price *= dfko;
   return price;
@@ -173,20 +182,19 @@ double capFloorletBS(int payoffType, SPtrYieldCurve spyc, double strikeRate,
 
   double d1 = log(frate / strikeRate) / pervol + 0.5 * pervol;
   double d2 = d1 - pervol;
-  NormalDistribution normal;
 
   // precompute common quantities
-  double nd1 = normal.cdf(phi * d1);
-  double nd2 = normal.cdf(phi * d2);
-  double nprd1 = normal.pdf(d1);      // the normal density     
+  double nd1 = normalCdf(phi * d1);
+  double nd2 = normalCdf(phi * d2);
+  double nprd1 = normalPdf(d1);      // the normal density     
 
   double price = phi * df * (frate * nd1 - strikeRate * nd2) * tenor;
 
   return price;
 }
 
-/** Present value of a credit default swap */
-Vector cdsPV(SPtrYieldCurve sprfyc, double credSprd, double cdsRate,
+/** Present values of the default and premium legs of a credit default swap */
+CdsLegs cdsLegsPV(SPtrYieldCurve sprfyc, double credSprd, double cdsRate,
                   double recov, double timeToMat, size_t payFreq)
 {
   QF_ASSERT(credSprd > 0.0, "credit spread must be non-negative");
@@ -199,38 +207,37 @@ Vector cdsPV(SPtrYieldCurve sprfyc, double credSprd, double cdsRate,
   size_t npay = (size_t) std::ceil(timeToMat * payFreq);    // number of periods within timeToMat
   double epsilon = 1.0e-012;  // a very small hard-coded number
 
-  if (npay == 0)
-    return Vector(2, arma::fill::zeros);
-
-  Vector paytimes(npay);
-  paytimes.fill(timeToMat);
+  // the payment times, the first period being the short stub; they are ascending, 
+  // hence their discount factors are computed in a single pass over the curve
+  Vector paytimes(npay), dfs(npay);
+  for (size_t i = 0; i < npay; ++i)
+    paytimes[i] = timeToMat - (npay - i - 1) * DeltaT;
+  sprfyc->discount(paytimes.begin(), paytimes.end(), dfs.begin());
+
+  // the survival probabilities are generated on the fly
+  CdsLegs legs;
+  double prevtime = 0.0;
+  double prevsurv = 1.0;
   for (size_t i = 0; i < npay; ++i) {
-    paytimes[npay - i - 1] -= i * DeltaT;
+    double paytime = paytimes[i];
+    double survprob = std::exp(-credSprd * paytime) - recov;
+    survprob = survprob > 0.0 ? survprob : 0.0;  // survival prob cannot be negative!
+    survprob /= (1.0 - recov + epsilon);         // add epsilon to handle the case recov=1
+    double df = dfs[i];
+    legs.premiumLeg += cdsRate * (paytime - prevtime) * survprob * df;
+    legs.defaultLeg += (1.0 - recov) * (prevsurv - survprob) * df;
+    prevtime = paytime;
+    prevsurv = survprob;
   }
 
-  Vector survprob(npay);
-  survprob.fill(1.0);
-  for (size_t i = 0; i < npay; ++i) {
-    survprob[i] = std::exp(-credSprd * paytimes[i]) - recov;
-    survprob[i] = survprob[i] > 0.0 ? survprob[i] : 0.0;  // survival prob cannot be negative!
-    survprob[i] /= (1.0 - recov + epsilon);               // add epsilon to handle the case recov=1
-  }
-
-  double pvpl = 0.0;
-  double pvdl = 0.0;
-
-  for (size_t i = 0; i < npay; ++i) {
-    double df = sprfyc->discount(paytimes[i]);
-    double DeltaT = i == 0 ? paytimes[i] : paytimes[i] - paytimes[i - 1];
-    pvpl += cdsRate *  DeltaT * survprob[i] * df;
-    double defprob = i == 0 ? (1 - survprob[i]) : survprob[i - 1] - survprob[i];
-    pvdl += (1.0 - recov) * defprob * df;
-  }
-  Vector ret(2);
-  ret[0] = pvdl;
-  ret[1] = pvpl;
+  return legs;
+}
 
-  return ret;
+/** Present value of a credit default swap */
+Vector cdsPV(SPtrYieldCurve sprfyc, double credSprd, double cdsRate,
+                  double recov, double timeToMat, size_t payFreq)
+{
+  return cdsLegsPV(sprfyc, credSprd, cdsRate, recov, timeToMat, payFreq).toVector();
 }
 
 END_NAMESPACE(qf)
@@ -10,6 +10,7 @@
 #include <qflib/exception.hpp>
 #include <qflib/math/matrix.hpp>
 #include <qflib/market/market.hpp>
+#include <qflib/pricers/greeks.hpp>
 
 BEGIN_NAMESPACE(qf)
 
@@ -20,10 +21,24 @@ double fwdPrice(double spot, double timeToExp, double intRate, double divYield);
 double quantoFwdPrice(double spot, double timeToExp, double intRate, double divYield,
                       double assetVol, double fxVol, double correl);
 
+/** Price and Greeks of a European digital option in the Black-Scholes model.
+    Only the Greeks selected in mask (or-ed Greeks flags) are computed, the others are left at zero.
+*/
+Greeks digitalOptionBSGreeks(int payoffType, double spot, double strike, double timeToExp,
+                             double intRate, double divYield, double volatility,
+                             unsigned mask = Greeks::ALL);
+
 /** Price of a European digital option in the Black-Scholes model*/
 Vector digitalOptionBS(int payoffType, double spot, double strike, double timeToExp,
                        double intRate, double divYield, double volatility);
 
+/** Price and Greeks of a European option in the Black-Scholes model.
+    Only the Greeks selected in mask (or-ed Greeks flags) are computed, the others are left at zero.
+*/
+Greeks europeanOptionBSGreeks(int payoffType, double spot, double strike, double timeToExp,
+                              double intRate, double divYield, double volatility,
+                              unsigned mask = Greeks::ALL);
+
 /** Price and Greeks of a European option in the Black-Scholes model*/
 Vector europeanOptionBS(int payoffType, double spot, double strike, double timeToExp, 
                         double intRate, double divYield, double volatility);
@@ -36,6 +51,10 @@ double knockoutFwd(double spot, double strike, double kolevel, double timeToExp,
 double capFloorletBS(int payoffType, SPtrYieldCurve spyc, double strikeRate, 
                      double timeToReset, double tenor, double fwdRateVol);
 
+/** Present values of the default and premium legs of a credit default swap */
+CdsLegs cdsLegsPV(SPtrYieldCurve sprfyc, double credSprd, double cdsRate,
+                  double recov, double timeToMat, size_t payFreq);
+
 /** Present value of a credit default swap */
 Vector cdsPV(SPtrYieldCurve sprfyc, double credSprd, double cdsRate,
                  double recov, double timeToMat, size_t payFreq);
@@ -0,0 +1,165 @@
+/**
+@file  scenarioengine.cpp
+@brief Implementation of the ScenarioEngine class
+*/
+
+#include <qflib/risk/scenarioengine.hpp>
+#include <qflib/market/market.hpp>
+#include <qflib/market/marketfile.hpp>
+#include <qflib/math/stats/meanvarcalculator.hpp>
+#include <qflib/math/stats/quantilecalculator.hpp>
+#include <qflib/pricers/bsmcpricer.hpp>
+#include <qflib/pricers/simplepricers.hpp>
+#include <qflib/products/europeancallput.hpp>
+
+BEGIN_NAMESPACE(qf)
+
+using namespace std;
+
+ScenarioEngine::ScenarioEngine(vector<Trade> const& portfolio, size_t blockSize)
+: trades_(portfolio), blocksize_(blockSize)
+{
+  QF_ASSERT(!trades_.empty(), "ScenarioEngine: the portfolio is empty");
+  QF_ASSERT(blocksize_ > 0, "ScenarioEngine: the block size must be positive");
+}
+
+double ScenarioEngine::tradeValue(Trade const& trade, SPtrYieldCurve const& spyc,
+                                  SPtrVolatilityTermStructure const& spvts, double spotReturn)
+{
+  double spot = trade.spot * (1.0 + spotReturn);
+  double tExp = trade.timeToExp;
+  double value = 0.0;
+  switch (trade.type) {
+  case Trade::Type::EUROPEAN:
+    // the term structures enter the closed form through their averages up to expiration
+    value = europeanOptionBSGreeks(trade.payoffType, spot, trade.strike, tExp, spyc->spotRate(tExp),
+                                   trade.divYield, spvts->spotVol(tExp), Greeks::PRICE).price;
+    break;
+  case Trade::Type::DIGITAL:
+    value = digitalOptionBSGreeks(trade.payoffType, spot, trade.strike, tExp, spyc->spotRate(tExp),
+                                  trade.divYield, spvts->spotVol(tExp), Greeks::PRICE).price;
+    break;
+  case Trade::Type::EUROPEANMC: {
+    // each pricer starts its generator from the same seed, hence the scenarios share the random numbers
+    SPtrProduct spprod(new EuropeanCallPut(trade.payoffType, trade.strike, tExp));
+    BsMcPricer pricer(spprod, spyc, trade.divYield, spvts, spot, McParams());
+    MeanVarCalculator<double*> sc(pricer.nVariables());
+    pricer.simulate(sc, trade.nPaths);
+    value = sc.results()(0, 0);
+    break;
+  }
+  default:
+    QF_ASSERT(0, "ScenarioEngine: unknown trade type");
+  }
+  return trade.quantity * value;
+}
+
+Vector ScenarioEngine::baseValues() const
+{
+  Market::Snapshot snap = market().snapshot();
+  Vector values(nVariables(), arma::fill::zeros);
+  for (size_t t = 0; t < trades_.size(); ++t) {
+    Trade const& trade = trades_[t];
+    SPtrYieldCurve spyc = snap.yieldCurves.get(trade.ycName);
+    QF_ASSERT(spyc, "ScenarioEngine: yield curve " + trade.ycName + " not found");
+    SPtrVolatilityTermStructure spvts = snap.volatilities.get(trade.volName);
+    QF_ASSERT(spvts, "ScenarioEngine: vol curve " + trade.volName + " not found");
+    values[t] = tradeValue(trade, spyc, spvts);
+    values[trades_.size()] += values[t];
+  }
+  return values;
+}
+
+void ScenarioEngine::revalueBlock(vector<string> const& marketFiles, Vector const& spotReturns,
+                                  Vector const& base, size_t first, size_t last, Matrix& pnls) const
+{
+  ptrdiff_t nscen = (ptrdiff_t) (last - first);
+  ptrdiff_t ntrades = (ptrdiff_t) trades_.size();
+  // the curves used by each (scenario, trade) pair; they keep their files mapped until the block is done
+  vector<SPtrYieldCurve> ycs(nscen * ntrades);
+  vector<SPtrVolatilityTermStructure> vols(nscen * ntrades);
+  // exceptions cannot leave a parallel region; the first message is rethrown after it
+  string error;
+
+#pragma omp parallel for schedule(dynamic)
+  for (ptrdiff_t s = 0; s < nscen; ++s) {
+    try {
+      string const& fileName = marketFiles[first + s];
+      MarketFile::Contents contents = MarketFile::read(fileName);
+      SPtrMap<YieldCurve> ycmap;
+      ycmap.assign(contents.yieldCurves.begin(), contents.yieldCurves.end());
+      SPtrMap<VolatilityTermStructure> volmap;
+      volmap.assign(contents.volatilities.begin(), contents.volatilities.end());
+      for (ptrdiff_t t = 0; t < ntrades; ++t) {
+        Trade const& trade = trades_[t];
+        ycs[s * ntrades + t] = ycmap.get(trade.ycName);
+        QF_ASSERT(ycs[s * ntrades + t], "ScenarioEngine: yield curve " + trade.ycName + " not found in " + fileName);
+        vols[s * ntrades + t] = volmap.get(trade.volName);
+        QF_ASSERT(vols[s * ntrades + t], "ScenarioEngine: vol curve " + trade.volName + " not found in " + fileName);
+      }
+    }
+    catch (std::exception const& e) {
+#pragma omp critical
+      if (error.empty())
+        error = e.what();
+    }
+  }
+  QF_ASSERT(error.empty(), error);
+
+#pragma omp parallel for schedule(dynamic)
+  for (ptrdiff_t k = 0; k < nscen * ntrades; ++k) {
+    ptrdiff_t s = k / ntrades;
+    ptrdiff_t t = k % ntrades;
+    try {
+      double spotReturn = spotReturns.size() == 0 ? 0.0 : spotReturns[first + s];
+      pnls(t, s) = tradeValue(trades_[t], ycs[k], vols[k], spotReturn) - base[t];
+    }
+    catch (std::exception const& e) {
+#pragma omp critical
+      if (error.empty())
+        error = e.what();
+    }
+  }
+  QF_ASSERT(error.empty(), error);
+
+  for (ptrdiff_t s = 0; s < nscen; ++s) {
+    double total = 0.0;
+    for (ptrdiff_t t = 0; t < ntrades; ++t)
+      total += pnls(t, s);
+    pnls(ntrades, s) = total;
+  }
+}
+
+ScenarioEngine::VarResults ScenarioEngine::valueAtRisk(vector<string> const& marketFiles, Vector const& spotReturns,
+                                                       Vector const& confidences) const
+{
+  QF_ASSERT(!marketFiles.empty(), "ScenarioEngine: no scenarios");
+  // the VaR at confidence c is minus the (1 - c) quantile of the P&L
+  Vector probs(confidences.size());
+  for (size_t k = 0; k < confidences.size(); ++k) {
+    QF_ASSERT(confidences[k] > 0.0 && confidences[k] < 1.0, "ScenarioEngine: confidence levels must be in (0, 1)");
+    probs[k] = 1.0 - confidences[k];
+  }
+
+  QF_ASSERT(spotReturns.size() == 0 || spotReturns.size() == marketFiles.size(),
+            "ScenarioEngine: one spot return per scenario is required");
+
+  VarResults results;
+  results.baseValues = baseValues();
+  QuantileCalculator<double*> qc(nVariables(), probs);
+  runBlocks(marketFiles, spotReturns, results.baseValues, qc);
+  Matrix const& res = qc.results();
+
+  results.nScenarios = qc.nSamples();
+  results.var.set_size(confidences.size(), nVariables());
+  results.es.set_size(confidences.size(), nVariables());
+  for (size_t k = 0; k < confidences.size(); ++k) {
+    for (size_t j = 0; j < nVariables(); ++j) {
+      results.var(k, j) = -res(k, j);
+      results.es(k, j) = -res(confidences.size() + k, j);
+    }
+  }
+  return results;
+}
+
+END_NAMESPACE(qf)
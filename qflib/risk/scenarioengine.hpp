@@ -0,0 +1,158 @@
+/**
+@file  scenarioengine.hpp
+@brief Revaluation of a portfolio under historical market scenarios
+*/
+
+#ifndef QF_SCENARIOENGINE_HPP
+#define QF_SCENARIOENGINE_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <qflib/math/matrix.hpp>
+#include <qflib/math/stats/statisticscalculator.hpp>
+#include <qflib/market/yieldcurve.hpp>
+#include <qflib/market/volatilitytermstructure.hpp>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** A trade of the portfolio revalued by the ScenarioEngine
+    The rates and vols come from the named curves of each scenario, the spot from the trade
+    moved by the spot return of the scenario.
+*/
+struct Trade
+{
+  /** The trade types and the pricers used for them */
+  enum class Type
+  {
+    EUROPEAN,      // European option, closed form
+    DIGITAL,       // European digital option, closed form
+    EUROPEANMC     // European option, Monte Carlo with BsMcPricer
+  };
+
+  /** Ctor */
+  Trade(Type type, int payoffType, double strike, double timeToExp, double spot, double divYield,
+        std::string const& ycName, std::string const& volName, double quantity = 1.0,
+        unsigned long nPaths = 10000);
+
+  // state
+  Type type;
+  int payoffType;          // 1: call, -1: put
+  double strike;
+  double timeToExp;
+  double spot;             // the spot on the base market
+  double divYield;
+  std::string ycName;      // the name of the discount curve
+  std::string volName;     // the name of the volatility term structure
+  double quantity;         // the number of options held, negative if sold
+  unsigned long nPaths;    // the number of Monte Carlo paths, for EUROPEANMC
+};
+
+/** The historical scenario engine.
+    Each scenario is a market file saved with MarketFile::save, e.g. one per business day, together with
+    a relative return of the spots. The engine values the trades on the current market, then revalues them
+    on every scenario and passes the P&Ls of each scenario, one per trade followed by the portfolio P&L,
+    to a statistics calculator, e.g. a QuantileCalculator for VaR and expected shortfall.
+    The scenarios are processed in blocks: the files of a block are mapped and the (scenario, trade) pairs
+    are revalued in parallel with OpenMP, then the block is streamed to the calculator, in scenario order,
+    and released. Hence the market data in memory is bounded by the block size, whatever the number of scenarios.
+    The Monte Carlo trades use the same random numbers in every scenario.
+*/
+class ScenarioEngine
+{
+public:
+  /** The results of valueAtRisk; the columns are the trades followed by the portfolio */
+  struct VarResults
+  {
+    Vector baseValues;    // the values on the current market
+    Matrix var;           // the VaR, one row per confidence level
+    Matrix es;            // the expected shortfall, one row per confidence level
+    size_t nScenarios;
+  };
+
+  /** Ctor from the portfolio and the number of scenarios mapped at once */
+  explicit ScenarioEngine(std::vector<Trade> const& portfolio, size_t blockSize = 64);
+
+  /** Returns the number of trades */
+  size_t nTrades() const { return trades_.size(); }
+
+  /** Returns the number of variables passed to the statistics calculator, the trades and the portfolio */
+  size_t nVariables() const { return trades_.size() + 1; }
+
+  /** Returns the values of the trades and the portfolio on the current market */
+  Vector baseValues() const;
+
+  /** Revalues the portfolio on each scenario and adds its P&Ls to the statistics calculator
+      The spot returns are one per scenario, or empty for no spot moves.
+  */
+  template<typename ITER>
+  void run(std::vector<std::string> const& marketFiles, Vector const& spotReturns,
+           StatisticsCalculator<ITER>& statsCalc) const;
+
+  /** Returns the historical VaR and expected shortfall at each confidence level, e.g. 0.99,
+      as positive numbers for losses
+  */
+  VarResults valueAtRisk(std::vector<std::string> const& marketFiles, Vector const& spotReturns,
+                         Vector const& confidences) const;
+
+  /** Returns the value of the trade on the given curves, with the spot moved by spotReturn */
+  static double tradeValue(Trade const& trade, SPtrYieldCurve const& spyc,
+                           SPtrVolatilityTermStructure const& spvts, double spotReturn = 0.0);
+
+private:
+  // Streams the P&Ls against the base values to the statistics calculator, block by block
+  template<typename ITER>
+  void runBlocks(std::vector<std::string> const& marketFiles, Vector const& spotReturns,
+                 Vector const& base, StatisticsCalculator<ITER>& statsCalc) const;
+
+  // Writes to column s of pnls the P&Ls of scenario first + s, for the scenarios in [first, last)
+  void revalueBlock(std::vector<std::string> const& marketFiles, Vector const& spotReturns,
+                    Vector const& base, size_t first, size_t last, Matrix& pnls) const;
+
+  std::vector<Trade> trades_;
+  size_t blocksize_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline
+Trade::Trade(Type type, int payoffType, double strike, double timeToExp, double spot, double divYield,
+             std::string const& ycName, std::string const& volName, double quantity, unsigned long nPaths)
+: type(type), payoffType(payoffType), strike(strike), timeToExp(timeToExp), spot(spot), divYield(divYield),
+  ycName(ycName), volName(volName), quantity(quantity), nPaths(nPaths)
+{
+  QF_ASSERT(payoffType == 1 || payoffType == -1, "Trade: the payoff type must be 1 (call) or -1 (put)");
+  QF_ASSERT(timeToExp > 0.0, "Trade: the time to expiration must be positive");
+  QF_ASSERT(spot > 0.0, "Trade: the spot must be positive");
+  QF_ASSERT(type != Type::EUROPEANMC || nPaths > 1, "Trade: at least two Monte Carlo paths are required");
+}
+
+template<typename ITER>
+void ScenarioEngine::run(std::vector<std::string> const& marketFiles, Vector const& spotReturns,
+                         StatisticsCalculator<ITER>& statsCalc) const
+{
+  QF_ASSERT(statsCalc.nVariables() == nVariables(),
+            "ScenarioEngine: the statistics calculator must track the trades and the portfolio");
+  QF_ASSERT(spotReturns.size() == 0 || spotReturns.size() == marketFiles.size(),
+            "ScenarioEngine: one spot return per scenario is required");
+  runBlocks(marketFiles, spotReturns, baseValues(), statsCalc);
+}
+
+template<typename ITER>
+void ScenarioEngine::runBlocks(std::vector<std::string> const& marketFiles, Vector const& spotReturns,
+                               Vector const& base, StatisticsCalculator<ITER>& statsCalc) const
+{
+  Matrix pnls(nVariables(), blocksize_);
+  for (size_t first = 0; first < marketFiles.size(); first += blocksize_) {
+    size_t last = std::min(first + blocksize_, marketFiles.size());
+    revalueBlock(marketFiles, spotReturns, base, first, last, pnls);
+    for (size_t s = 0; s < last - first; ++s)
+      statsCalc.addSample(pnls.colptr(s), pnls.colptr(s) + nVariables());
+  }
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_SCENARIOENGINE_HPP
@@ -7,8 +7,12 @@
 #define QF_SPTRMAP_HPP
 
 #include <qflib/sptr.hpp>
+#include <qflib/exception.hpp>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <cctype>
 #include <algorithm>
@@ -25,6 +29,13 @@ std::string trim(const std::string &s)
 }
 
 /** A string to smart pointer dictionary class.
+    The map is published as immutable snapshots: readers load the current snapshot atomically 
+    and never block, while writers copy the snapshot, modify the copy and publish it atomically.
+    Writers are serialized among themselves. A Snapshot held by a reader is unaffected by later updates,
+    so that a pricing thread can read a consistent set of objects while another thread publishes new versions.
+    Names are case insensitive and hashed. Each name also gets a slot, and a Handle to the slot
+    resolves in O(1) without any string processing; a handle carries the version it was issued for,
+    so that a handle to a replaced object is detected as stale.
 */
 template<typename T>
 class SPtrMap
@@ -32,53 +43,159 @@ class SPtrMap
 public:
   using ptr_type = std::shared_ptr<T>;
   using pair_type = std::pair<ptr_type, unsigned long>;
-  using map_type = std::map<std::string, pair_type>;
 
-  /** Returns a list of names of the contained objects */
-  std::vector<std::string> list() const;
+  /** A reference to the object stored under a name, at a given version */
+  struct Handle
+  {
+    size_t slot = 0;              // the slot of the name
+    unsigned long version = 0;    // the version of the object, 0 for an invalid handle
+    unsigned long generation = 0; // the number of times the map was cleared when the handle was issued
+  };
+
+  /** The result of set: the processed name and the version number, and the handle to the stored object */
+  struct SetResult : public std::pair<std::string, unsigned long>
+  {
+    Handle handle;
+  };
+
+private:
+  // the contents of a snapshot
+  struct Entry
+  {
+    std::string name;
+    pair_type object;
+  };
+  struct State
+  {
+    std::vector<Entry> entries;                      // the slots, in order of first insertion
+    std::unordered_map<std::string, size_t> slots;   // the slot of each name
+    unsigned long generation = 0;
+  };
+
+public:
+  /** An immutable view of the map at one point in time */
+  class Snapshot
+  {
+  public:
+    /** Returns a sorted list of names of the contained objects */
+    std::vector<std::string> list() const;
+
+    /** Returns true if the map contains an entry under this name */
+    bool contains(std::string const& name) const;
+
+    /** Retrieves the smart pointer by name */
+    ptr_type get(std::string const& name) const;
+
+    /** Retrieves the smart pointer by handle in O(1); returns an empty pointer if the handle is stale */
+    ptr_type get(Handle const& handle) const;
+
+    /** Returns the version of the pointed object */
+    unsigned long version(std::string const& name) const;
+
+    /** Returns a handle to the current version of the object stored under this name
+        The handle is invalid, i.e. has version 0, if there is no such object.
+    */
+    Handle handle(std::string const& name) const;
+
+    /** Returns true if the handle refers to the current version of its object */
+    bool isCurrent(Handle const& handle) const;
+
+  private:
+    friend class SPtrMap;
+    explicit Snapshot(std::shared_ptr<const State> state) : state_(std::move(state)) {}
+
+    // Helper function returning the slot of the name, or npos if not found
+    size_t find(std::string const& name) const;
+
+    std::shared_ptr<const State> state_;
+  };
+
+  /** Ctor of an empty map */
+  SPtrMap() : state_(std::make_shared<const State>()) {}
+
+  /** Returns the current snapshot of the map, without locking */
+  Snapshot snapshot() const { return Snapshot(state_.load(std::memory_order_acquire)); }
+
+  /** Returns a sorted list of names of the contained objects */
+  std::vector<std::string> list() const { return snapshot().list(); }
 
   /** Returns true if the map contains an entry under this name */
-  bool contains(std::string const& name) const;
+  bool contains(std::string const& name) const { return snapshot().contains(name); }
 
   /** Retrieves the smart pointer by name */
-  ptr_type get(std::string const& name) const;
+  ptr_type get(std::string const& name) const { return snapshot().get(name); }
+
+  /** Retrieves the smart pointer by handle in O(1); returns an empty pointer if the handle is stale */
+  ptr_type get(Handle const& handle) const { return snapshot().get(handle); }
+
+  /** Returns a handle to the current version of the object stored under this name */
+  Handle handle(std::string const& name) const { return snapshot().handle(name); }
+
+  /** Returns true if the handle refers to the current version of its object */
+  bool isCurrent(Handle const& handle) const { return snapshot().isCurrent(handle); }
 
   /** Stores the smart pointer to object using the passed-in name 
-      Returns the name and the version number
+      Returns the name and the version number, and the handle to the object
   */
-  std::pair<std::string, unsigned long> set(std::string const& name, ptr_type sp);
+  SetResult set(std::string const& name, ptr_type sp);
+
+  /** Stores the (name, smart pointer) pairs in [first, last), publishing them all at once
+      Returns the names and the version numbers, and the handles to the objects
+  */
+  template<typename ITER>
+  std::vector<SetResult> set(ITER first, ITER last);
 
   /** Returns the version of the pointed object */
-  unsigned long version(std::string const& name) const;
+  unsigned long version(std::string const& name) const { return snapshot().version(name); }
 
-  /** Clears the map and resets the current version to 0 */
+  /** Replaces the contents with the (name, (smart pointer, version)) pairs in [first, last), 
+      publishing them all at once with the given versions, e.g. when restoring a saved market.
+      As with clear, all handles issued so far become stale.
+  */
+  template<typename ITER>
+  void assign(ITER first, ITER last);
+
+  /** Clears the map and resets the current version to 0; all handles become stale */
   void clear();
 
 private:
 
   // Removes leading and trailing blanks and upper cases the passed in string.
   // Throws an exception if the string has internal blanks.
-  std::string processName(std::string const& name) const;
+  static std::string processName(std::string const& name);
 
-  // Helper function to retrieve the pointer and the version number
-  // Call processName() before calling this.
-  pair_type get_pair(std::string const& name) const;
+  // Returns true if the name is already processed, i.e. non-empty, upper case and without blanks
+  static bool isProcessed(std::string const& name);
 
-  // Helper function to remove the pointer and the version number;
-  // returns true if the pair was found and removed.
+  // Helper function to insert or replace the pointer in a state being built, bumping the version number.
   // Call processName() before calling this.
-  bool remove_pair(std::string const& name);
+  static SetResult set_entry(State& state, std::string const& name, ptr_type sp);
 
   // state
-  map_type map_;            // the map
+  std::atomic<std::shared_ptr<const State>> state_;   // the published snapshot
+  std::mutex writemutex_;                             // serializes the writers
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Inline definitions
 
+template<typename T>
+inline bool 
+SPtrMap<T>::isProcessed(std::string const& name) {
+    if (name.empty())
+        return false;
+    for (char c : name) {
+        if (::isspace(static_cast<unsigned char>(c)) || ::islower(static_cast<unsigned char>(c)))
+            return false;
+    }
+    return true;
+}
+
 template<typename T>
 inline std::string 
-SPtrMap<T>::processName(std::string const& name) const {
+SPtrMap<T>::processName(std::string const& name) {
     std::string ret = trim(name);
     QF_ASSERT(!ret.empty(), "empty object names not allowed");
     std::transform(ret.begin(), ret.end(), ret.begin(), ::toupper);
@@ -88,70 +205,141 @@ SPtrMap<T>::processName(std::string const& name) const {
 }
 
 template<typename T>
-inline typename SPtrMap<T>::pair_type 
-SPtrMap<T>::get_pair(std::string const& name) const {
-    auto it = map_.find(name.c_str());
-    return it == map_.end() ? pair_type() : it->second;
-}
-
-template<typename T>
-inline bool 
-SPtrMap<T>::remove_pair(std::string const& name) {
-    auto it = map_.find(name.c_str());
-    if (it == map_.end())
-        return false;
-    else {
-        map_.erase(it);
-    }
-    return true;
+inline size_t 
+SPtrMap<T>::Snapshot::find(std::string const& name) const {
+    // processed names, such as the ones returned by set, are looked up without a copy
+    auto it = isProcessed(name) ? state_->slots.find(name) : state_->slots.find(processName(name));
+    return it == state_->slots.end() ? npos : it->second;
 }
 
 template<typename T>
 inline std::vector<std::string> 
-SPtrMap<T>::list() const {
+SPtrMap<T>::Snapshot::list() const {
     std::vector<std::string> lst;
-    for (auto cit = map_.begin(); cit != map_.end(); ++cit) 
-        lst.push_back(cit->first);
+    for (auto cit = state_->entries.begin(); cit != state_->entries.end(); ++cit) 
+        lst.push_back(cit->name);
+    std::sort(lst.begin(), lst.end());
     return lst;
 }
 
 template<typename T>
-inline bool SPtrMap<T>::contains(std::string const& name) const {
-    std::string nm = processName(name);
-    return map_.find(nm) != map_.end();
+inline bool SPtrMap<T>::Snapshot::contains(std::string const& name) const {
+    return find(name) != npos;
 }
 
 template<typename T> 
 inline typename SPtrMap<T>::ptr_type 
-SPtrMap<T>::get(std::string const& name) const {
-    std::string nm = processName(name);
-    return get_pair(nm).first;
+SPtrMap<T>::Snapshot::get(std::string const& name) const {
+    size_t slot = find(name);
+    return slot == npos ? ptr_type() : state_->entries[slot].object.first;
+}
+
+template<typename T> 
+inline typename SPtrMap<T>::ptr_type 
+SPtrMap<T>::Snapshot::get(Handle const& handle) const {
+    return isCurrent(handle) ? state_->entries[handle.slot].object.first : ptr_type();
 }
 
 template<typename T>
-inline std::pair<std::string, unsigned long> 
-SPtrMap<T>::set(std::string const& name, ptr_type sp) {
-    std::string nm = processName(name);
-    // first check if the object is already stored under this name
-    // if it does, record the version number
-    unsigned long ver = 0;
-    if (contains(nm)) {
-      ver = get_pair(nm).second;
-      bool b = remove_pair(nm);
+inline unsigned long SPtrMap<T>::Snapshot::version(std::string const& name) const {
+    size_t slot = find(name);
+    return slot == npos ? 0 : state_->entries[slot].object.second;
+}
+
+template<typename T>
+inline typename SPtrMap<T>::Handle 
+SPtrMap<T>::Snapshot::handle(std::string const& name) const {
+    Handle h;
+    size_t slot = find(name);
+    if (slot != npos) {
+        h.slot = slot;
+        h.version = state_->entries[slot].object.second;
+        h.generation = state_->generation;
     }
-    map_.insert(std::make_pair(nm, std::make_pair(sp, ++ver)));
-    return std::make_pair(nm, ver);
+    return h;
+}
+
+template<typename T>
+inline bool SPtrMap<T>::Snapshot::isCurrent(Handle const& handle) const {
+    return handle.version != 0 && handle.generation == state_->generation
+        && handle.slot < state_->entries.size() && state_->entries[handle.slot].object.second == handle.version;
 }
 
 template<typename T>
-inline unsigned long SPtrMap<T>::version(std::string const& name) const {
+inline typename SPtrMap<T>::SetResult 
+SPtrMap<T>::set_entry(State& state, std::string const& name, ptr_type sp) {
+    // if the object is already stored under this name, reuse its slot and bump its version number
+    auto ins = state.slots.insert(std::make_pair(name, state.entries.size()));
+    if (ins.second)
+        state.entries.push_back(Entry{ name, pair_type() });
+    size_t slot = ins.first->second;
+    pair_type& object = state.entries[slot].object;
+    object.first = sp;
+    ++object.second;
+
+    SetResult res;
+    res.first = name;
+    res.second = object.second;
+    res.handle.slot = slot;
+    res.handle.version = object.second;
+    res.handle.generation = state.generation;
+    return res;
+}
+
+template<typename T>
+inline typename SPtrMap<T>::SetResult 
+SPtrMap<T>::set(std::string const& name, ptr_type sp) {
     std::string nm = processName(name);
-    return get_pair(nm).second;
+    std::lock_guard<std::mutex> lock(writemutex_);
+    // copy on write: the readers of the current snapshot are not affected
+    auto newstate = std::make_shared<State>(*state_.load(std::memory_order_acquire));
+    SetResult res = set_entry(*newstate, nm, sp);
+    state_.store(std::move(newstate), std::memory_order_release);
+    return res;
+}
+
+template<typename T>
+template<typename ITER>
+inline std::vector<typename SPtrMap<T>::SetResult> 
+SPtrMap<T>::set(ITER first, ITER last) {
+    std::vector<SetResult> ret;
+    std::vector<std::string> names;
+    for (ITER it = first; it != last; ++it)
+        names.push_back(processName(it->first));
+
+    std::lock_guard<std::mutex> lock(writemutex_);
+    auto newstate = std::make_shared<State>(*state_.load(std::memory_order_acquire));
+    size_t i = 0;
+    for (ITER it = first; it != last; ++it, ++i)
+        ret.push_back(set_entry(*newstate, names[i], it->second));
+    state_.store(std::move(newstate), std::memory_order_release);
+    return ret;
+}
+
+template<typename T>
+template<typename ITER>
+inline void SPtrMap<T>::assign(ITER first, ITER last) {
+    auto newstate = std::make_shared<State>();
+    for (ITER it = first; it != last; ++it) {
+        std::string nm = processName(it->first);
+        QF_ASSERT(it->second.second > 0, "object versions must be positive");
+        auto ins = newstate->slots.insert(std::make_pair(nm, newstate->entries.size()));
+        QF_ASSERT(ins.second, "duplicate object name " + nm);
+        newstate->entries.push_back(Entry{ nm, it->second });
+    }
+
+    std::lock_guard<std::mutex> lock(writemutex_);
+    newstate->generation = state_.load(std::memory_order_acquire)->generation + 1;
+    state_.store(std::move(newstate), std::memory_order_release);
 }
 
 template<typename T>
 inline void SPtrMap<T>::clear() { 
-    map_.clear(); 
+    std::lock_guard<std::mutex> lock(writemutex_);
+    // a new generation makes the handles issued so far stale
+    auto newstate = std::make_shared<State>();
+    newstate->generation = state_.load(std::memory_order_acquire)->generation + 1;
+    state_.store(std::move(newstate), std::memory_order_release);
     return;
 }
 
@@ -0,0 +1,121 @@
+/**
+@file  threadpool.hpp
+@brief A fixed-size pool of worker threads running queued tasks
+*/
+
+#ifndef QF_THREADPOOL_HPP
+#define QF_THREADPOOL_HPP
+
+#include <qflib/defines.hpp>
+#include <qflib/exception.hpp>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+BEGIN_NAMESPACE(qf)
+
+/** A pool of worker threads.
+    Tasks are queued by submit, which returns a std::future to the task result; the workers take the tasks
+    in submission order. An exception thrown by a task is stored in its future and rethrown by get().
+    The destructor runs the tasks already queued, then joins the workers.
+*/
+class ThreadPool
+{
+public:
+  /** Ctor with the number of workers, by default one per hardware thread */
+  explicit ThreadPool(size_t nthreads = std::thread::hardware_concurrency());
+
+  /** Dtor, waits for the queued tasks */
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  /** Returns the number of workers */
+  size_t size() const { return workers_.size(); }
+
+  /** Returns the number of tasks queued and not yet started */
+  size_t pending() const;
+
+  /** Queues the task f, callable without arguments, and returns the future of its result */
+  template<typename F>
+  std::future<std::invoke_result_t<F>> submit(F f);
+
+private:
+  // the loop run by each worker
+  void work();
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+
+inline ThreadPool::ThreadPool(size_t nthreads)
+{
+  nthreads = nthreads > 0 ? nthreads : 1;
+  for (size_t i = 0; i < nthreads; ++i)
+    workers_.emplace_back([this]() { work(); });
+}
+
+inline ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (std::thread& w : workers_)
+    w.join();
+}
+
+inline size_t ThreadPool::pending() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tasks_.size();
+}
+
+template<typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F f)
+{
+  // std::function requires a copyable target, hence the shared packaged task
+  auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(f));
+  std::future<std::invoke_result_t<F>> fut = task->get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    QF_ASSERT(!stop_, "ThreadPool: the pool is stopping");
+    tasks_.push([task]() { (*task)(); });
+  }
+  cv_.notify_one();
+  return fut;
+}
+
+inline void ThreadPool::work()
+{
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty())
+        return;   // stopping, and nothing left to run
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    task();
+  }
+}
+
+END_NAMESPACE(qf)
+
+#endif // QF_THREADPOOL_HPP